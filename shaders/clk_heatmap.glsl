@@ -0,0 +1,19 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "clock.glsl"
+
+// Blend a blue-to-red ramp of tile cost over the rendered image
+void main(){
+    ivec2 uv = ivec2(gl_GlobalInvocationID.xy);
+    if(uv.x >= int(pc.width) || uv.y >= int(pc.height)) return;
+
+    float cost = tileCost(clk.tiles[gl_WorkGroupID.y*pc.tilesX + gl_WorkGroupID.x])
+               / max(uintBitsToFloat(clk.maxCost), 1.0);
+    vec3 heat = clamp(vec3(2.0*cost - 0.5, 1.0 - abs(2.0*cost - 1.0), 1.5 - 2.0*cost), 0.0, 1.0);
+
+    vec3 col = imageLoad(img, uv).rgb;
+    // tile outlines make the grid readable
+    bool edge = (uv.x & 15) == 0 || (uv.y & 15) == 0;
+    imageStore(img, uv, vec4(mix(col, heat, edge ? 0.8 : 0.5), 1.0));
+}
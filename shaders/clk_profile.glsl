@@ -0,0 +1,76 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+#extension GL_ARB_shader_clock : require
+
+#include "clock.glsl"
+#include "shade.glsl"
+
+// march, normal, shade cycles of the tile, 64-bit as lo/hi with carry
+shared uint sLo[3], sHi[3];
+
+void addCycles(uint phase, uint cycles) {
+    uint old = atomicAdd(sLo[phase], cycles);
+    if(old + cycles < old) atomicAdd(sHi[phase], 1u);
+}
+
+// The subgroup clock is only comparable within one subgroup, so only
+// deltas are used; the low word wraps harmlessly for phase-length spans
+uint cyclesSince(uint start) {
+    return clock2x32ARB().x - start;
+}
+
+void main(){
+    if(gl_LocalInvocationIndex < 3u) { sLo[gl_LocalInvocationIndex] = 0u; sHi[gl_LocalInvocationIndex] = 0u; }
+    barrier();
+
+    ivec2 uv = ivec2(gl_GlobalInvocationID.xy);
+    bool inside = uv.x < int(pc.width) && uv.y < int(pc.height);
+    uint march = 0u, normal = 0u, shading = 0u;
+
+    if(inside) {
+        // same ray and march as comp.glsl
+        vec2 frag = (vec2(uv) / vec2(pc.width, pc.height) - 0.5) * 2.0;
+        frag.x *= float(pc.width)/float(pc.height);
+        vec3 rd = normalize(frag.x*cam.right + frag.y*cam.up + cam.forward);
+        vec3 ro = cam.pos;
+
+        uint c0 = clock2x32ARB().x;
+        float t = 0.0;
+        const float MAXT = 50.0;
+        for(int i=0;i<128;i++){
+            float d = mandelbulb(ro + rd*t);
+            if(d < 0.001 || t > MAXT) break;
+            t += d;
+        }
+        march = cyclesSince(c0);
+
+        vec3 col = vec3(0.0);
+        if(t <= MAXT) {
+            uint c1 = clock2x32ARB().x;
+            vec3 n = getNormal(ro + rd*t);
+            normal = cyclesSince(c1);
+
+            uint c2 = clock2x32ARB().x;
+            col = shadeNormal(n);
+            shading = cyclesSince(c2);
+        }
+        imageStore(img, uv, vec4(col,1.0));
+    }
+
+    addCycles(0u, march);
+    addCycles(1u, normal);
+    addCycles(2u, shading);
+    barrier();
+
+    if(gl_LocalInvocationIndex == 0u) {
+        uint c0, c1;
+        uint totalLo = uaddCarry(uaddCarry(sLo[0], sLo[1], c0), sLo[2], c1);
+        uint totalHi = sHi[0] + sHi[1] + sHi[2] + c0 + c1;
+        ClkTile tile;
+        tile.lo = uvec4(sLo[0], sLo[1], sLo[2], totalLo);
+        tile.hi = uvec4(sHi[0], sHi[1], sHi[2], totalHi);
+        clk.tiles[gl_WorkGroupID.y*pc.tilesX + gl_WorkGroupID.x] = tile;
+        // non-negative floats order like their bits
+        atomicMax(clk.maxCost, floatBitsToUint(tileCost(tile)));
+    }
+}
@@ -0,0 +1,8 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+#extension GL_KHR_shader_subgroup_arithmetic : require
+#extension GL_KHR_shader_subgroup_ballot : require
+
+// comp.glsl with the statistics reduced per subgroup; see comp_main.glsl
+#define STATS_SUBGROUP
+#include "comp_main.glsl"
@@ -0,0 +1,23 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "foveated.glsl"
+
+vec4 fetch(int x, int y) {
+    x = clamp(x, 0, int(pc.bufW) - 1);
+    y = (y + int(pc.bufH)) % int(pc.bufH);   // angle wraps around
+    return fovea[y*int(pc.bufW) + x];
+}
+
+// Bilinear lookup of every full-resolution pixel in the log-polar buffer.
+void main(){
+    ivec2 uv = ivec2(gl_GlobalInvocationID.xy);
+    if(uv.x >= int(pc.width) || uv.y >= int(pc.height)) return;
+
+    vec2 u = toLogPolar(vec2(uv) - pc.focus) * vec2(pc.bufW, pc.bufH) - 0.5;
+    ivec2 i = ivec2(floor(u));
+    vec2 f = u - vec2(i);
+    vec4 col = mix(mix(fetch(i.x, i.y),   fetch(i.x+1, i.y),   f.x),
+                   mix(fetch(i.x, i.y+1), fetch(i.x+1, i.y+1), f.x), f.y);
+    imageStore(img, uv, vec4(col.rgb,1.0));
+}
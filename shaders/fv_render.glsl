@@ -0,0 +1,27 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "foveated.glsl"
+
+// March the log-polar buffer. Step count, hit epsilon and DE iterations
+// are relaxed with eccentricity as well as ray density.
+void main(){
+    uvec2 b = gl_GlobalInvocationID.xy;
+    if(b.x >= pc.bufW || b.y >= pc.bufH) return;
+
+    vec2 u = (vec2(b) + 0.5) / vec2(pc.bufW, pc.bufH);
+    vec2 uv = pc.focus + fromLogPolar(u);
+
+    vec2 frag = (uv / vec2(pc.width, pc.height) - 0.5) * 2.0;
+    frag.x *= float(pc.width)/float(pc.height);
+    vec3 rd = normalize(frag.x*cam.right + frag.y*cam.up + cam.forward);
+
+    float e     = u.x;   // eccentricity in [0,1]
+    int   steps = int(mix(float(MARCH_MAX_STEPS), 64.0, e));
+    float eps   = MARCH_EPS * (1.0 + 4.0*e);
+    int   iters = int(mix(float(DE_ITER), 5.0, e) + 0.5);
+    float t = marchRayBudget(cam.pos, rd, 50.0, steps, eps, iters);
+
+    vec3 col = t < 0.0 ? vec3(0.0) : shade(cam.pos + rd*t);
+    fovea[b.y*pc.bufW + b.x] = vec4(col, 1.0);
+}
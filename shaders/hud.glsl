@@ -0,0 +1,71 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "font.glsl"
+
+// Performance HUD: darkens a panel of the finished image and draws the
+// host-formatted text lines and a frame-time bar graph into it. The
+// dispatch covers only the panel.
+layout(local_size_x = 16, local_size_y = 16) in;
+
+layout(binding=0, rgba8) uniform image2D img;
+layout(binding=1) uniform Camera {
+    vec3 pos;
+    vec3 forward;
+    vec3 up;
+    vec3 right;
+} cam;
+
+// Must match HUD_* and HudBlock in main.cpp
+const int HUD_COLS    = 48;
+const int HUD_ROWS    = 6;
+const int HUD_SAMPLES = 144;   // 2 panel pixels per sample
+layout(std430, binding=2) buffer Hud {
+    uint  text[HUD_ROWS*HUD_COLS];   // ASCII, row-major
+    float graph[HUD_SAMPLES];        // frame ms, oldest first
+} hud;
+
+layout(push_constant) uniform HudParams {
+    ivec2 origin;      // top-left of the panel in image pixels
+    int   scale;       // image pixels per panel pixel
+    int   rows;        // text rows in use
+    float graphMaxMs;  // top of the graph
+    float budgetMs;    // reference line, e.g. the refresh interval
+} pc;
+
+const int   PAD     = 3;
+const ivec2 CELL    = ivec2(FONT_W + 1, FONT_H + 2);
+const int   GRAPH_H = 32;
+
+void main(){
+    ivec2 uv = pc.origin + ivec2(gl_GlobalInvocationID.xy);
+    ivec2 q  = ivec2(gl_GlobalInvocationID.xy) / pc.scale;   // panel pixel
+    int textH = pc.rows * CELL.y;
+    ivec2 panel = ivec2(2*PAD + HUD_COLS*CELL.x, 3*PAD + textH + GRAPH_H);
+    if(any(greaterThanEqual(q, panel)) || any(greaterThanEqual(uv, imageSize(img)))) return;
+
+    vec3 col = imageLoad(img, uv).rgb * 0.3;
+
+    ivec2 t = q - ivec2(PAD);
+    ivec2 cell = t / CELL;
+    if(t.x >= 0 && t.y >= 0 && cell.x < HUD_COLS && cell.y < pc.rows) {
+        uint ch = hud.text[cell.y*HUD_COLS + cell.x];
+        if(glyphPixel(ch, t - cell*CELL)) col = vec3(1.0);
+    }
+
+    ivec2 g = q - ivec2(PAD, 2*PAD + textH);
+    if(g.x >= 0 && g.y >= 0 && g.x < 2*HUD_SAMPLES && g.y < GRAPH_H) {
+        float ms = hud.graph[g.x / 2];
+        float y  = float(GRAPH_H - 1 - g.y) / float(GRAPH_H) * pc.graphMaxMs;
+        int budgetY = GRAPH_H - 1 - int(pc.budgetMs / pc.graphMaxMs * float(GRAPH_H));
+        if(y < ms) {
+            float over = ms / pc.budgetMs;
+            col = over <= 1.0 ? vec3(0.3, 0.9, 0.3) : (over <= 2.0 ? vec3(0.9, 0.8, 0.2) : vec3(0.9, 0.25, 0.2));
+        } else {
+            col += vec3(0.05);
+        }
+        if(g.y == budgetY) col = mix(col, vec3(1.0), 0.6);
+    }
+
+    imageStore(img, uv, vec4(col, 1.0));
+}
@@ -0,0 +1,40 @@
+// Shared state for the shader-clock profile (clk_*.glsl), needs
+// VK_KHR_shader_clock. clk_profile renders the comp.glsl image while
+// summing subgroup clock deltas per workgroup for the march, normal and
+// shade phases; clk_heatmap tints each tile by its share of the worst tile.
+#ifndef CLOCK_GLSL
+#define CLOCK_GLSL
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+layout(binding=0, rgba8) uniform image2D img;
+layout(binding=1) uniform Camera {
+    vec3 pos;
+    vec3 forward;
+    vec3 up;
+    vec3 right;
+} cam;
+
+// Must match ClkTile in main.cpp. Cycles summed over a tile's invocations
+// overflow 32 bits on slow tiles, so they are 64-bit totals as lo/hi.
+struct ClkTile {
+    uvec4 lo;          // march, normal, shade, total cycles
+    uvec4 hi;
+};
+layout(std430, binding=2) buffer Clock {
+    uint    maxCost;   // largest tile total this frame, as float bits
+    uint    pad[3];
+    ClkTile tiles[];
+} clk;
+
+float tileCost(ClkTile t) {
+    return float(t.hi.w) * 4294967296.0 + float(t.lo.w);
+}
+
+layout(push_constant) uniform ClkParams {
+    uint width;
+    uint height;
+    uint tilesX;
+} pc;
+
+#endif
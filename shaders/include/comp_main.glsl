@@ -0,0 +1,149 @@
+// The raymarch kernel behind comp.glsl and comp_subgroup.glsl. The two
+// differ only in how recordStats() reduces its counters, so that devices
+// without subgroup arithmetic or ballot get a module that doesn't declare
+// them.
+#ifndef COMP_MAIN_GLSL
+#define COMP_MAIN_GLSL
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+// Treat each primary ray as a cone of one pixel radius and blend silhouettes
+// by the coverage estimated during the march (no extra rays)
+layout(constant_id = 0) const bool CONE_AA = false;
+// Count march work into the statistics buffer below
+layout(constant_id = 1) const bool STATS = false;
+
+layout(binding=0, rgba8) uniform writeonly image2D img;
+layout(binding=1) uniform Camera {
+    vec3 pos;
+    vec3 forward;
+    vec3 up;
+    vec3 right;
+} cam;
+
+// One ring slot of statistics, zeroed by the host before the dispatch.
+// Must match StatsBlock in main.cpp.
+const uint STEP_BUCKETS = 32u;   // 4 march steps per histogram bucket
+layout(std430, binding=2) buffer Stats {
+    uint marchStepsLo, marchStepsHi;   // 64-bit totals as lo/hi with carry
+    uint deEvalsLo, deEvalsHi;
+    uint normalEvals;
+    uint hitPixels;
+    uint missPixels;
+    uint cappedPixels;                 // ran out of steps before hit or escape
+    uint stepHistogram[STEP_BUCKETS];
+} stats;
+
+#include "shade.glsl"
+
+const uint OUTCOME_HIT    = 0u;
+const uint OUTCOME_MISS   = 1u;
+const uint OUTCOME_CAPPED = 2u;
+
+#ifdef STATS_SUBGROUP
+// Reduce across the subgroup first so each counter costs one atomic per
+// subgroup instead of one per pixel.
+void recordStats(uint steps, uint normals, uint outcome) {
+    uint s  = subgroupAdd(steps);
+    uint n  = subgroupAdd(normals);
+    uint de = s + 6u*n;   // getNormal() is six DE evaluations
+    uvec3 o = subgroupAdd(uvec3(outcome == OUTCOME_HIT, outcome == OUTCOME_MISS,
+                                outcome == OUTCOME_CAPPED));
+    if(subgroupElect()) {
+        uint old = atomicAdd(stats.marchStepsLo, s);
+        if(old + s < old) atomicAdd(stats.marchStepsHi, 1u);
+        old = atomicAdd(stats.deEvalsLo, de);
+        if(old + de < old) atomicAdd(stats.deEvalsHi, 1u);
+        atomicAdd(stats.normalEvals, n);
+        atomicAdd(stats.hitPixels,    o.x);
+        atomicAdd(stats.missPixels,   o.y);
+        atomicAdd(stats.cappedPixels, o.z);
+    }
+
+    // one atomic per distinct bucket present in the subgroup
+    uint bucket = min(steps / 4u, STEP_BUCKETS - 1u);
+    for(;;) {
+        uint first = subgroupBroadcastFirst(bucket);
+        if(bucket == first) {
+            uint count = subgroupBallotBitCount(subgroupBallot(true));
+            if(subgroupElect()) atomicAdd(stats.stepHistogram[first], count);
+            break;
+        }
+    }
+}
+#else
+// Devices without subgroup arithmetic and ballot: one atomic per counter
+// per pixel
+void recordStats(uint steps, uint normals, uint outcome) {
+    uint de  = steps + 6u*normals;
+    uint old = atomicAdd(stats.marchStepsLo, steps);
+    if(old + steps < old) atomicAdd(stats.marchStepsHi, 1u);
+    old = atomicAdd(stats.deEvalsLo, de);
+    if(old + de < old) atomicAdd(stats.deEvalsHi, 1u);
+    if(normals > 0u) atomicAdd(stats.normalEvals, normals);
+    if(outcome == OUTCOME_HIT)         atomicAdd(stats.hitPixels,    1u);
+    else if(outcome == OUTCOME_MISS)   atomicAdd(stats.missPixels,   1u);
+    else                               atomicAdd(stats.cappedPixels, 1u);
+    atomicAdd(stats.stepHistogram[min(steps / 4u, STEP_BUCKETS - 1u)], 1u);
+}
+#endif
+
+void main(){
+    ivec2 uv = ivec2(gl_GlobalInvocationID.xy);
+    if(uv.x >= imageSize(img).x || uv.y >= imageSize(img).y) return;
+
+    // generate ray
+    vec2 frag = (vec2(uv) / vec2(imageSize(img)) - 0.5) * 2.0;
+    frag.x *= float(imageSize(img).x)/imageSize(img).y;
+    vec3 rd = normalize(frag.x*cam.right + frag.y*cam.up + cam.forward);
+    vec3 ro = cam.pos;
+
+    // ray march
+    float t = 0.0;
+    const float MAXT = 50.0;
+    float d;
+    // cone radius per unit distance: half a pixel of the [-1,1] frag span
+    float coneK = 1.0 / float(imageSize(img).y);
+    float minRatio = 1e9;
+    float tMin = 0.0;
+    uint steps = 0u;
+    bool capped = true;
+    for(int i=0;i<128;i++){
+        vec3 p = ro + rd*t;
+        d = mandelbulb(p);
+        steps++;
+        if(CONE_AA && t > 0.0) {
+            // closest approach relative to the cone radius at this distance
+            float ratio = d / (t*coneK);
+            if(ratio < minRatio) { minRatio = ratio; tMin = t; }
+        }
+        if(d < 0.001 || t > MAXT) { capped = false; break; }
+        t += d;
+    }
+
+    const vec3 background = vec3(0.0);
+    vec3 col;
+    uint normals = 0u;
+    if(t > MAXT) {
+        col = background;
+        // the ray missed, but its cone grazed a silhouette: shade the point
+        // of closest approach and blend it in by the covered fraction
+        if(CONE_AA && minRatio < 1.0) {
+            float coverage = 1.0 - smoothstep(0.0, 1.0, minRatio);
+            col = mix(background, shade(ro + rd*tMin), coverage);
+            normals = 1u;
+        }
+    } else {
+        col = shade(ro + rd*t);
+        normals = 1u;
+    }
+
+    if(STATS) {
+        uint outcome = t > MAXT ? OUTCOME_MISS : (capped ? OUTCOME_CAPPED : OUTCOME_HIT);
+        recordStats(steps, normals, outcome);
+    }
+
+    imageStore(img, uv, vec4(col,1.0));
+}
+
+#endif
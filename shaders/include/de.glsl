@@ -0,0 +1,68 @@
+// Mandelbulb distance estimator shared by every raymarching kernel.
+// Generated from src/de_source.h by MetharizonDeGen: edit that, not this.
+#ifndef DE_GLSL
+#define DE_GLSL
+
+const int DE_ITER = 8;
+
+// power-8 Mandelbulb, with a caller-chosen iteration budget
+float mandelbulbN(vec3 p, int iters) {
+    vec3  z  = p;
+    float dr = 1.0;
+    float r  = 0.0;
+    for(int i=0;i<iters;i++){
+        float t0 = z.x * z.x;
+        float t1 = z.y * z.y;
+        float t2 = t0 + t1;
+        float t3 = z.z * z.z;
+        float t4 = t2 + t3;
+        float t5 = sqrt(t4);
+        r = t5;
+        if(r>2.0) break;
+        float t6 = z.z / r;
+        float t7 = acos(t6);
+        float t8 = t7 * 8.0;
+        float t9 = sin(t8);
+        float t10 = atan(z.y, z.x);
+        float t11 = t10 * 8.0;
+        float t12 = cos(t11);
+        float t13 = t9 * t12;
+        float t14 = pow(r, 7.0);
+        float t15 = t14 * r;
+        float t16 = t13 * t15;
+        float t17 = t16 + p.x;
+        float t18 = sin(t11);
+        float t19 = t18 * t9;
+        float t20 = t19 * t15;
+        float t21 = t20 + p.y;
+        float t22 = cos(t8);
+        float t23 = t22 * t15;
+        float t24 = t23 + p.z;
+        float t25 = t14 * 8.0;
+        float t26 = t25 * dr;
+        float t27 = t26 + 1.0;
+        z  = vec3(t17, t21, t24);
+        dr = t27;
+    }
+    float t28 = log(r);
+    float t29 = 0.5 * t28;
+    float t30 = t29 * r;
+    float t31 = t30 / dr;
+    return t31;
+}
+
+float mandelbulb(vec3 p) {
+    return mandelbulbN(p, DE_ITER);
+}
+
+// estimate normal
+vec3 getNormal(vec3 p) {
+    float e = 0.0005;
+    return normalize(vec3(
+        mandelbulb(p+vec3(e,0,0)) - mandelbulb(p-vec3(e,0,0)),
+        mandelbulb(p+vec3(0,e,0)) - mandelbulb(p-vec3(0,e,0)),
+        mandelbulb(p+vec3(0,0,e)) - mandelbulb(p-vec3(0,0,e))
+    ));
+}
+
+#endif
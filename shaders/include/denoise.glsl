@@ -0,0 +1,74 @@
+// Shared state for the stochastic AO / soft shadow mode (sd_*.glsl).
+//
+// Per-pixel storage buffers; the ones suffixed "2x" hold two halves that
+// ping-pong between frames (or between a-trous iterations) via pc.parity
+// and pc.srcBuf.
+#ifndef DENOISE_GLSL
+#define DENOISE_GLSL
+
+#include "march.glsl"
+#include "sampling.glsl"
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+layout(binding=0, rgba8) uniform writeonly image2D img;
+layout(binding=1) uniform Camera {
+    vec3 pos;
+    vec3 forward;
+    vec3 up;
+    vec3 right;
+} cam;
+
+layout(std430, binding=2) buffer GBuffer  { vec4 gbuf[];    };  // 2x: normal, hit distance (<0 miss)
+layout(std430, binding=3) buffer Noisy    { vec2 noisy[];   };  // shadow, AO visibility this frame
+layout(std430, binding=4) buffer History  { vec4 history[]; };  // 2x: shadow, AO, history length
+layout(std430, binding=5) buffer Filtered { vec2 filt[];    };  // 2x: a-trous ping-pong
+
+layout(push_constant) uniform SDParams {
+    vec4 prevPos;        // camera of the previous frame, for reprojection
+    vec4 prevForward;
+    vec4 prevUp;
+    vec4 prevRight;
+    uint frame;
+    uint width;
+    uint height;
+    uint parity;         // half of gbuf/history written this frame
+    uint step;           // a-trous tap spacing
+    uint srcBuf;         // half of filt read by this a-trous pass
+    uint historyValid;   // 0 after a reset or resize
+    uint rays;           // 1: alternate shadow/AO per frame, 2: both
+} pc;
+
+const float SD_MAXT          = 50.0;
+const float AO_RADIUS        = 0.25;
+const vec3  SUN_DIR          = vec3(0.666667, 0.666667, 0.333333);
+const float SUN_COS_ANGLE    = 0.9962;
+const float MAX_HISTORY      = 32.0;
+
+uint pixelIndex(ivec2 uv)  { return uint(uv.y)*pc.width + uint(uv.x); }
+uint curHalf()             { return pc.parity*pc.width*pc.height; }
+uint prevHalf()            { return (1u - pc.parity)*pc.width*pc.height; }
+
+bool inImage(ivec2 uv) {
+    return uv.x >= 0 && uv.y >= 0 && uv.x < int(pc.width) && uv.y < int(pc.height);
+}
+
+vec3 primaryDir(ivec2 uv) {
+    vec2 frag = (vec2(uv) / vec2(pc.width, pc.height) - 0.5) * 2.0;
+    frag.x *= float(pc.width)/float(pc.height);
+    return normalize(frag.x*cam.right + frag.y*cam.up + cam.forward);
+}
+
+// Pixel of world point p in the previous frame's camera (inverse of primaryDir)
+bool reproject(vec3 p, out ivec2 prevUV) {
+    vec3 v = p - pc.prevPos.xyz;
+    float z = dot(v, pc.prevForward.xyz);
+    if(z <= 0.0) return false;
+    vec2 frag = vec2(dot(v, pc.prevRight.xyz), dot(v, pc.prevUp.xyz)) / z;
+    frag.x /= float(pc.width)/float(pc.height);
+    vec2 uv = (frag*0.5 + 0.5) * vec2(pc.width, pc.height);
+    prevUV = ivec2(floor(uv + 0.5));
+    return inImage(prevUV);
+}
+
+#endif
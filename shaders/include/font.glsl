@@ -0,0 +1,39 @@
+// 5x7 bitmap font for ASCII 32..95 (space to underscore; lower case is
+// folded to upper case by the host). Bit y*5+x of each glyph is pixel
+// (x, y), y down; bits 0-31 in .x, 32-34 in .y.
+#ifndef FONT_GLSL
+#define FONT_GLSL
+
+const uint FONT_FIRST = 32u;
+const uint FONT_COUNT = 64u;
+const int  FONT_W = 5;
+const int  FONT_H = 7;
+
+const uvec2 FONT[FONT_COUNT] = uvec2[](
+    uvec2(0x00000000u, 0x0u), uvec2(0x00421084u, 0x1u), uvec2(0x0000014au, 0x0u), uvec2(0x95f57d4au, 0x2u),   // sp ! " #
+    uvec2(0x1f4717c4u, 0x1u), uvec2(0x32222263u, 0x6u), uvec2(0x93511526u, 0x5u), uvec2(0x00000084u, 0x0u),   // $ % & '
+    uvec2(0x08210888u, 0x2u), uvec2(0x88842082u, 0x0u), uvec2(0x09575480u, 0x0u), uvec2(0x084f9080u, 0x0u),   // ( ) * +
+    uvec2(0x88600000u, 0x0u), uvec2(0x000f8000u, 0x0u), uvec2(0x8c000000u, 0x1u), uvec2(0x02222200u, 0x0u),   // , - . /
+    uvec2(0xa33ae62eu, 0x3u), uvec2(0x884210c4u, 0x3u), uvec2(0xc444422eu, 0x7u), uvec2(0xa304111fu, 0x3u),   // 0 1 2 3
+    uvec2(0x11f4a988u, 0x2u), uvec2(0xa3083c3fu, 0x3u), uvec2(0xa317844cu, 0x3u), uvec2(0x8422221fu, 0x0u),   // 4 5 6 7
+    uvec2(0xa317462eu, 0x3u), uvec2(0x910f462eu, 0x1u), uvec2(0x0c6018c0u, 0x0u), uvec2(0x886018c0u, 0x0u),   // 8 9 : ;
+    uvec2(0x08208888u, 0x2u), uvec2(0x01f07c00u, 0x0u), uvec2(0x88882082u, 0x0u), uvec2(0x0044422eu, 0x1u),   // < = > ?
+    uvec2(0xab5b422eu, 0x3u), uvec2(0x631fc62eu, 0x4u), uvec2(0xe317c62fu, 0x3u), uvec2(0xa210862eu, 0x3u),   // @ A B C
+    uvec2(0xd318c527u, 0x1u), uvec2(0xc217843fu, 0x7u), uvec2(0x4217843fu, 0x0u), uvec2(0xa31e862eu, 0x7u),   // D E F G
+    uvec2(0x631fc631u, 0x4u), uvec2(0x8842108eu, 0x3u), uvec2(0x9284211cu, 0x1u), uvec2(0x52519531u, 0x4u),   // H I J K
+    uvec2(0xc2108421u, 0x7u), uvec2(0x631ad771u, 0x4u), uvec2(0x639ace31u, 0x4u), uvec2(0xa318c62eu, 0x3u),   // L M N O
+    uvec2(0x4217c62fu, 0x0u), uvec2(0x9358c62eu, 0x5u), uvec2(0x5257c62fu, 0x4u), uvec2(0xe107043eu, 0x3u),   // P Q R S
+    uvec2(0x0842109fu, 0x1u), uvec2(0xa318c631u, 0x3u), uvec2(0x1518c631u, 0x1u), uvec2(0xab5ac631u, 0x2u),   // T U V W
+    uvec2(0x62a22a31u, 0x4u), uvec2(0x08454631u, 0x1u), uvec2(0xc222221fu, 0x7u), uvec2(0x8421084eu, 0x3u),   // X Y Z [
+    uvec2(0x20820820u, 0x0u), uvec2(0x9084210eu, 0x3u), uvec2(0x00004544u, 0x0u), uvec2(0xc0000000u, 0x7u)    // \ ] ^ _
+);
+
+bool glyphPixel(uint ch, ivec2 p) {
+    if (ch < FONT_FIRST || ch >= FONT_FIRST + FONT_COUNT) return false;
+    if (p.x < 0 || p.y < 0 || p.x >= FONT_W || p.y >= FONT_H) return false;
+    uvec2 g = FONT[ch - FONT_FIRST];
+    uint bit = uint(p.y*FONT_W + p.x);
+    return bit < 32u ? ((g.x >> bit) & 1u) != 0u : ((g.y >> (bit - 32u)) & 1u) != 0u;
+}
+
+#endif
@@ -0,0 +1,48 @@
+// Shared state for foveated rendering (fv_*.glsl), after kernel foveated
+// rendering (Meng et al. 2018): fv_render marches a reduced log-polar
+// buffer centred on the focus point, so ray density falls off with
+// eccentricity, and fv_reconstruct resamples it into the full image.
+#ifndef FOVEATED_GLSL
+#define FOVEATED_GLSL
+
+#include "march.glsl"
+#include "shade.glsl"
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+layout(binding=0, rgba8) uniform writeonly image2D img;
+layout(binding=1) uniform Camera {
+    vec3 pos;
+    vec3 forward;
+    vec3 up;
+    vec3 right;
+} cam;
+
+layout(std430, binding=2) buffer Fovea { vec4 fovea[]; };   // bufW x bufH log-polar samples
+
+layout(push_constant) uniform FVParams {
+    uint  width;
+    uint  height;
+    uint  bufW;       // log-radius axis
+    uint  bufH;       // angle axis
+    vec2  focus;      // focus point in pixels
+    float logMaxR;    // log of the focus-to-farthest-corner distance
+    float alpha;      // kernel exponent: larger keeps more samples near the focus
+} pc;
+
+const float PI2 = 6.2831853;
+
+// Buffer coordinate (both in [0,1]) -> pixel offset from the focus
+vec2 fromLogPolar(vec2 u) {
+    float r = exp(pc.logMaxR * pow(u.x, pc.alpha));
+    float a = PI2 * u.y;
+    return r * vec2(cos(a), sin(a));
+}
+
+vec2 toLogPolar(vec2 d) {
+    float r = max(length(d), 1.0);
+    float a = atan(d.y, d.x) / PI2;
+    return vec2(pow(log(r) / pc.logMaxR, 1.0/pc.alpha), fract(a));
+}
+
+#endif
@@ -0,0 +1,27 @@
+// Sphere tracing against the shared distance estimator.
+#ifndef MARCH_GLSL
+#define MARCH_GLSL
+
+#include "de.glsl"
+
+const int   MARCH_MAX_STEPS = 256;
+const float MARCH_EPS       = 0.001;
+
+// Returns hit distance, or -1.0 if the ray passes maxT. Running out of
+// steps counts as a hit, as in comp.glsl.
+float marchRayBudget(vec3 ro, vec3 rd, float maxT, int maxSteps, float eps, int iters) {
+    float t = 0.0;
+    for (int i = 0; i < maxSteps; i++) {
+        float d = mandelbulbN(ro + rd*t, iters);
+        if (d < eps) return t;
+        t += d;
+        if (t > maxT) return -1.0;
+    }
+    return t;
+}
+
+float marchRay(vec3 ro, vec3 rd, float maxT) {
+    return marchRayBudget(ro, rd, maxT, MARCH_MAX_STEPS, MARCH_EPS, DE_ITER);
+}
+
+#endif
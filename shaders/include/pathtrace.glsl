@@ -0,0 +1,86 @@
+// Shared state for the wavefront path tracer (pt_*.glsl).
+//
+// Paths live in a fixed-size pool; kernels communicate through index
+// queues whose lengths sit in the Counters buffer. pt_args turns a queue
+// length into the VkDispatchIndirectCommand for the kernel that drains it.
+#ifndef PATHTRACE_GLSL
+#define PATHTRACE_GLSL
+
+#include "march.glsl"
+#include "sampling.glsl"
+
+layout(binding=0, rgba8) uniform writeonly image2D img;
+layout(binding=1) uniform Camera {
+    vec3 pos;
+    vec3 forward;
+    vec3 up;
+    vec3 right;
+} cam;
+
+struct PathState {
+    vec4 origin;      // xyz ray origin, w hit distance written by pt_extend
+    vec4 dir;         // xyz ray direction, w pixel index (uint bits)
+    vec4 throughput;  // rgb path throughput
+};
+layout(std430, binding=2) buffer Paths { PathState paths[]; };
+
+struct ShadowRay {
+    vec4 origin;      // xyz origin
+    vec4 dir;         // xyz direction
+    vec4 contrib;     // rgb radiance if unoccluded, w pixel index (uint bits)
+};
+layout(std430, binding=3) buffer ShadowRays { ShadowRay shadowRays[]; };
+
+// QUEUE_* each own poolSize consecutive entries
+layout(std430, binding=4) buffer Queues { uint queueItems[]; };
+layout(std430, binding=5) buffer Counters {
+    uint  queueCount[4];
+    uvec4 dispatchArgs[3];  // indexed by PHASE_*, xyz read by vkCmdDispatchIndirect
+};
+layout(std430, binding=6) buffer Accum { vec4 accum[]; };
+
+layout(push_constant) uniform PTParams {
+    uint frame;        // RNG seed, advances every sample
+    uint sampleCount;  // samples accumulated including the current one
+    uint bounce;
+    uint maxBounces;
+    uint phase;        // PHASE_* prepared by pt_args
+    uint extendIn;     // QUEUE_EXTEND_A or _B, marched this bounce
+    uint width;
+    uint height;
+    uint chunkBase;    // first pixel of the current chunk
+    uint chunkSize;    // pixels in the current chunk
+    uint poolSize;     // capacity of the path pool and of each queue
+} pc;
+
+const uint QUEUE_EXTEND_A = 0u;
+const uint QUEUE_EXTEND_B = 1u;
+const uint QUEUE_SHADE    = 2u;
+const uint QUEUE_SHADOW   = 3u;
+
+const uint PHASE_EXTEND = 0u;
+const uint PHASE_SHADE  = 1u;
+const uint PHASE_SHADOW = 2u;
+
+const float PT_MAXT = 50.0;
+
+const vec3  SUN_DIR       = vec3(0.666667, 0.666667, 0.333333);
+const float SUN_COS_ANGLE = 0.9962;   // ~5 degree half angle -> soft shadows
+const vec3  SUN_COLOR     = vec3(2.5, 2.3, 2.0);
+const vec3  SKY_COLOR     = vec3(0.3, 0.4, 0.6);
+const vec3  ALBEDO        = vec3(0.7, 0.7, 0.7);
+
+void pushQueue(uint q, uint path) {
+    uint slot = atomicAdd(queueCount[q], 1u);
+    queueItems[q*pc.poolSize + slot] = path;
+}
+
+uint popQueue(uint q, uint i) {
+    return queueItems[q*pc.poolSize + i];
+}
+
+uint rngSeed(uint pixel, uint salt) {
+    return pcgHash(pixel + pcgHash(pc.frame + pcgHash(pc.bounce*4u + salt)));
+}
+
+#endif
@@ -0,0 +1,42 @@
+// Hashing and direction sampling for the stochastic kernels.
+#ifndef SAMPLING_GLSL
+#define SAMPLING_GLSL
+
+uint pcgHash(uint v) {
+    uint state = v * 747796405u + 2891336453u;
+    uint word  = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+float rand(inout uint s) {
+    s = pcgHash(s);
+    return float(s >> 8) * (1.0/16777216.0);
+}
+
+// Branchless orthonormal basis around n (Duff et al. 2017)
+void basis(vec3 n, out vec3 t, out vec3 b) {
+    float s = n.z >= 0.0 ? 1.0 : -1.0;
+    float a = -1.0 / (s + n.z);
+    float c = n.x * n.y * a;
+    t = vec3(1.0 + s*n.x*n.x*a, s*c, -s*n.x);
+    b = vec3(c, s + n.y*n.y*a, -n.y);
+}
+
+vec3 cosineHemisphere(vec3 n, vec2 u) {
+    float r   = sqrt(u.x);
+    float phi = 6.2831853 * u.y;
+    vec3 t, b;
+    basis(n, t, b);
+    return normalize(t*(r*cos(phi)) + b*(r*sin(phi)) + n*sqrt(max(0.0, 1.0 - u.x)));
+}
+
+vec3 sampleCone(vec3 axis, float cosMax, vec2 u) {
+    float cosT = mix(1.0, cosMax, u.x);
+    float sinT = sqrt(max(0.0, 1.0 - cosT*cosT));
+    float phi  = 6.2831853 * u.y;
+    vec3 t, b;
+    basis(axis, t, b);
+    return normalize(t*(sinT*cos(phi)) + b*(sinT*sin(phi)) + axis*cosT);
+}
+
+#endif
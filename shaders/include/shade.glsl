@@ -0,0 +1,18 @@
+// comp.glsl's surface shading, shared with kernels that must match it.
+#ifndef SHADE_GLSL
+#define SHADE_GLSL
+
+#include "de.glsl"
+
+vec3 shadeNormal(vec3 n) {
+    // simple side lighting
+    vec3 lightDir = normalize(vec3(1.0, 1.0, 0.5));
+    float diff = clamp(dot(n, lightDir), 0.0, 1.0);
+    return mix(vec3(0.1,0.1,0.2), vec3(0.6,0.8,1.0), diff);
+}
+
+vec3 shade(vec3 p) {
+    return shadeNormal(getNormal(p));
+}
+
+#endif
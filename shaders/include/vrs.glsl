@@ -0,0 +1,53 @@
+// Shared state for content-adaptive variable-rate rendering (vr_*.glsl).
+//
+// vr_coarse marches one ray per block corner, vr_classify interpolates the
+// smooth blocks and queues the rest, vr_refine marches every pixel of the
+// queued blocks through an indirect dispatch sized by vr_classify.
+#ifndef VRS_GLSL
+#define VRS_GLSL
+
+#include "march.glsl"
+#include "shade.glsl"
+
+layout(binding=0, rgba8) uniform writeonly image2D img;
+layout(binding=1) uniform Camera {
+    vec3 pos;
+    vec3 forward;
+    vec3 up;
+    vec3 right;
+} cam;
+
+layout(std430, binding=2) buffer Coarse { vec4 coarse[]; };      // rgb colour, hit distance (<0 miss)
+layout(std430, binding=3) buffer RefineQueue { uint refineBlocks[]; };
+layout(std430, binding=4) buffer Counters {
+    uvec4 refineArgs;     // VkDispatchIndirectCommand for vr_refine
+    uint  refineCount;
+};
+
+layout(push_constant) uniform VRParams {
+    uint  width;
+    uint  height;
+    uint  blockSize;       // 2 or 4
+    uint  gridW;           // coarse samples per row: ceil(width/blockSize) + 1
+    uint  gridH;
+    float depthThreshold;  // relative depth std-dev that forces refinement
+    float colorThreshold;  // colour std-dev that forces refinement
+    uint  showBlocks;      // tint refined blocks for debugging
+} pc;
+
+const float VR_MAXT = 50.0;
+
+vec3 primaryDir(vec2 uv) {
+    vec2 frag = (uv / vec2(pc.width, pc.height) - 0.5) * 2.0;
+    frag.x *= float(pc.width)/float(pc.height);
+    return normalize(frag.x*cam.right + frag.y*cam.up + cam.forward);
+}
+
+// Colour and hit distance of the primary ray through pixel uv
+vec4 tracePixel(ivec2 uv) {
+    vec3 rd = primaryDir(vec2(uv));
+    float t = marchRay(cam.pos, rd, VR_MAXT);
+    return vec4(t < 0.0 ? vec3(0.0) : shade(cam.pos + rd*t), t);
+}
+
+#endif
@@ -0,0 +1,50 @@
+// Shared state for exponential-map zoom videos (zm_*.glsl). A zoom with
+// the camera held still only rescales the image plane, so zm_strip marches
+// the plane once in log-polar coordinates around the view axis: columns
+// step log radius (outermost first), rows step angle. The columns come in
+// strips of pc.cols, held in a ring of pc.ring strips as the zoom moves
+// inwards. zm_frame resamples each frame from the strips at its scale and
+// marches the small disc around the centre, where log-polar samples run
+// out, directly.
+#ifndef ZOOM_GLSL
+#define ZOOM_GLSL
+
+#include "march.glsl"
+#include "shade.glsl"
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+layout(binding=0, rgba8) uniform writeonly image2D img;
+layout(binding=1) uniform Camera {
+    vec3 pos;
+    vec3 forward;
+    vec3 up;
+    vec3 right;
+} cam;
+
+layout(std430, binding=2) buffer Strips { uint strips[]; };   // packed RGBA8, ring x rows x cols
+
+layout(push_constant) uniform ZMParams {
+    uint  width;
+    uint  height;
+    uint  rows;       // angle samples
+    uint  cols;       // log-radius samples per strip
+    uint  ring;       // strips held
+    uint  strip;      // zm_strip: strip to march; zm_frame: first one held
+    uint  last;       // zm_frame: last strip held
+    float uTop;       // log plane radius of column 0, the frame corner at scale 1
+    float du;         // log radius per column
+    float logScale;   // zm_frame: log of the frame's zoom
+    float innerR;     // zm_frame: pixels around the centre marched directly
+} pc;
+
+const float PI2 = 6.2831853;
+
+// March and shade the ray through image-plane point q (comp.glsl's frag)
+vec3 traceFrag(vec2 q) {
+    vec3 rd = normalize(q.x*cam.right + q.y*cam.up + cam.forward);
+    float t = marchRayBudget(cam.pos, rd, 50.0, 128, MARCH_EPS, DE_ITER);
+    return t < 0.0 ? vec3(0.0) : shade(cam.pos + rd*t);
+}
+
+#endif
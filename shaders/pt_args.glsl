@@ -0,0 +1,22 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+layout(local_size_x = 1) in;
+
+#include "pathtrace.glsl"
+
+// Single-invocation kernel: sizes the indirect dispatch for pc.phase.
+// Before each extend it also empties the queues that bounce will refill.
+void main(){
+    uint q;
+    if(pc.phase == PHASE_EXTEND) {
+        q = pc.extendIn;
+        queueCount[QUEUE_SHADE]     = 0u;
+        queueCount[QUEUE_SHADOW]    = 0u;
+        queueCount[1u - pc.extendIn] = 0u;
+    } else if(pc.phase == PHASE_SHADE) {
+        q = QUEUE_SHADE;
+    } else {
+        q = QUEUE_SHADOW;
+    }
+    dispatchArgs[pc.phase] = uvec4((queueCount[q] + 63u) / 64u, 1u, 1u, 0u);
+}
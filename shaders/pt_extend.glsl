@@ -0,0 +1,27 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+layout(local_size_x = 64) in;
+
+#include "pathtrace.glsl"
+
+// March every queued path ray. Hits go to the shade queue; escaped
+// bounce rays pick up sky light, which is what produces the AO.
+void main(){
+    uint i = gl_GlobalInvocationID.x;
+    if(i >= queueCount[pc.extendIn]) return;
+
+    uint path = popQueue(pc.extendIn, i);
+    vec3 ro = paths[path].origin.xyz;
+    vec3 rd = paths[path].dir.xyz;
+    float t = marchRay(ro, rd, PT_MAXT);
+
+    if(t < 0.0) {
+        if(pc.bounce > 0u) {
+            uint pixel = floatBitsToUint(paths[path].dir.w);
+            accum[pixel].rgb += paths[path].throughput.rgb * SKY_COLOR;
+        }
+        return;
+    }
+    paths[path].origin.w = t;
+    pushQueue(QUEUE_SHADE, path);
+}
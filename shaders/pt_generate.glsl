@@ -0,0 +1,26 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+layout(local_size_x = 64) in;
+
+#include "pathtrace.glsl"
+
+// One camera path per pixel of the current chunk, jittered inside the pixel.
+// The host presets queueCount[QUEUE_EXTEND_A] = chunkSize.
+void main(){
+    uint i = gl_GlobalInvocationID.x;
+    if(i >= pc.chunkSize) return;
+
+    uint pixel = pc.chunkBase + i;
+    vec2 uv = vec2(pixel % pc.width, pixel / pc.width);
+    uint rng = rngSeed(pixel, 0u);
+    uv += vec2(rand(rng), rand(rng));
+
+    vec2 frag = (uv / vec2(pc.width, pc.height) - 0.5) * 2.0;
+    frag.x *= float(pc.width)/float(pc.height);
+    vec3 rd = normalize(frag.x*cam.right + frag.y*cam.up + cam.forward);
+
+    paths[i].origin     = vec4(cam.pos, 0.0);
+    paths[i].dir        = vec4(rd, uintBitsToFloat(pixel));
+    paths[i].throughput = vec4(1.0);
+    queueItems[QUEUE_EXTEND_A*pc.poolSize + i] = i;
+}
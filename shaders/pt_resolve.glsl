@@ -0,0 +1,16 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+layout(local_size_x = 16, local_size_y = 16) in;
+
+#include "pathtrace.glsl"
+
+// Average the accumulated samples into the storage image.
+void main(){
+    ivec2 uv = ivec2(gl_GlobalInvocationID.xy);
+    if(uv.x >= int(pc.width) || uv.y >= int(pc.height)) return;
+
+    vec3 col = accum[uv.y*int(pc.width) + uv.x].rgb / float(pc.sampleCount);
+    col = 1.0 - exp(-col);              // soft exposure curve
+    col = pow(col, vec3(1.0/2.2));
+    imageStore(img, uv, vec4(col,1.0));
+}
@@ -0,0 +1,44 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+layout(local_size_x = 64) in;
+
+#include "pathtrace.glsl"
+
+// Lambertian shading at each hit: emit one shadow ray towards a jittered
+// point on the sun disc and continue the path with a cosine-weighted
+// diffuse bounce (Russian roulette after the second bounce).
+void main(){
+    uint i = gl_GlobalInvocationID.x;
+    if(i >= queueCount[QUEUE_SHADE]) return;
+
+    uint path  = popQueue(QUEUE_SHADE, i);
+    PathState ps = paths[path];
+    uint pixel = floatBitsToUint(ps.dir.w);
+    uint rng   = rngSeed(pixel, 1u);
+
+    vec3 p = ps.origin.xyz + ps.dir.xyz*ps.origin.w;
+    vec3 n = getNormal(p);
+    if(dot(n, ps.dir.xyz) > 0.0) n = -n;
+    vec3 origin = p + n*(2.0*MARCH_EPS);
+    vec3 thr = ps.throughput.rgb * ALBEDO;
+
+    vec3 l = sampleCone(SUN_DIR, SUN_COS_ANGLE, vec2(rand(rng), rand(rng)));
+    float ndl = dot(n, l);
+    if(ndl > 0.0) {
+        shadowRays[path].origin  = vec4(origin, 0.0);
+        shadowRays[path].dir     = vec4(l, 0.0);
+        shadowRays[path].contrib = vec4(thr*SUN_COLOR*ndl, uintBitsToFloat(pixel));
+        pushQueue(QUEUE_SHADOW, path);
+    }
+
+    if(pc.bounce + 1u >= pc.maxBounces) return;
+    if(pc.bounce >= 2u) {
+        float q = min(max(thr.r, max(thr.g, thr.b)), 0.95);
+        if(rand(rng) >= q) return;
+        thr /= q;
+    }
+    paths[path].origin     = vec4(origin, 0.0);
+    paths[path].dir.xyz    = cosineHemisphere(n, vec2(rand(rng), rand(rng)));
+    paths[path].throughput = vec4(thr, 1.0);
+    pushQueue(1u - pc.extendIn, path);
+}
@@ -0,0 +1,18 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+layout(local_size_x = 64) in;
+
+#include "pathtrace.glsl"
+
+// Occlusion test for the shadow rays emitted by pt_shade.
+void main(){
+    uint i = gl_GlobalInvocationID.x;
+    if(i >= queueCount[QUEUE_SHADOW]) return;
+
+    uint path = popQueue(QUEUE_SHADOW, i);
+    ShadowRay sr = shadowRays[path];
+    if(marchRay(sr.origin.xyz, sr.dir.xyz, PT_MAXT) < 0.0) {
+        uint pixel = floatBitsToUint(sr.contrib.w);
+        accum[pixel].rgb += sr.contrib.rgb;
+    }
+}
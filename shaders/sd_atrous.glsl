@@ -0,0 +1,43 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "denoise.glsl"
+
+// One edge-aware a-trous wavelet iteration (Dammertz et al. 2010): 5x5 B3
+// spline taps spaced pc.step apart, weighted by normal, depth and value
+// similarity. Young history (few accumulated frames) is blurred harder.
+void main(){
+    ivec2 uv = ivec2(gl_GlobalInvocationID.xy);
+    if(!inImage(uv)) return;
+
+    uint n = pc.width*pc.height;
+    uint pix = pixelIndex(uv);
+    vec4 g = gbuf[curHalf() + pix];
+    vec2 c = filt[pc.srcBuf*n + pix];
+    if(g.w < 0.0) { filt[(1u - pc.srcBuf)*n + pix] = c; return; }
+
+    float len    = history[curHalf() + pix].z;
+    float sigmaV = 1.0 / sqrt(max(len, 1.0));
+    const float k[3] = float[3](3.0/8.0, 1.0/4.0, 1.0/16.0);
+
+    vec2 sum = vec2(0.0);
+    float wsum = 0.0;
+    for(int dy = -2; dy <= 2; dy++) {
+        for(int dx = -2; dx <= 2; dx++) {
+            ivec2 q = uv + ivec2(dx, dy)*int(pc.step);
+            if(!inImage(q)) continue;
+            uint qpix = pixelIndex(q);
+            vec4 qg = gbuf[curHalf() + qpix];
+            if(qg.w < 0.0) continue;
+            vec2 qc = filt[pc.srcBuf*n + qpix];
+
+            float w = k[abs(dx)] * k[abs(dy)];
+            w *= pow(max(dot(g.xyz, qg.xyz), 0.0), 32.0);
+            w *= exp(-abs(g.w - qg.w) / (0.01*g.w*float(pc.step) + 1e-4));
+            w *= exp(-length(c - qc) / sigmaV);
+            sum  += qc*w;
+            wsum += w;
+        }
+    }
+    filt[(1u - pc.srcBuf)*n + pix] = wsum > 0.0 ? sum/wsum : c;
+}
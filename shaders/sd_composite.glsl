@@ -0,0 +1,21 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "denoise.glsl"
+
+// comp.glsl's lighting with the denoised shadow on the direct term and AO
+// on the ambient term.
+void main(){
+    ivec2 uv = ivec2(gl_GlobalInvocationID.xy);
+    if(!inImage(uv)) return;
+
+    uint pix = pixelIndex(uv);
+    vec4 g = gbuf[curHalf() + pix];
+    vec3 col = vec3(0.0);
+    if(g.w >= 0.0) {
+        vec2 v = filt[pc.srcBuf*pc.width*pc.height + pix];
+        float diff = clamp(dot(g.xyz, SUN_DIR), 0.0, 1.0) * v.x;
+        col = mix(vec3(0.1,0.1,0.2)*v.y, vec3(0.6,0.8,1.0)*mix(0.5, 1.0, v.y), diff);
+    }
+    imageStore(img, uv, vec4(col,1.0));
+}
@@ -0,0 +1,15 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "denoise.glsl"
+
+// Primary march: the hit points the stochastic rays start from.
+void main(){
+    ivec2 uv = ivec2(gl_GlobalInvocationID.xy);
+    if(!inImage(uv)) return;
+
+    vec3 rd = primaryDir(uv);
+    float t = marchRay(cam.pos, rd, SD_MAXT);
+    vec3 n = t < 0.0 ? vec3(0.0) : getNormal(cam.pos + rd*t);
+    gbuf[curHalf() + pixelIndex(uv)] = vec4(n, t);
+}
@@ -0,0 +1,45 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "denoise.glsl"
+
+// Exponential moving average with last frame's history, reprojected
+// through the previous camera. History is dropped where depth or normal
+// disagree (disocclusion), so it stays stable while the camera moves.
+void main(){
+    ivec2 uv = ivec2(gl_GlobalInvocationID.xy);
+    if(!inImage(uv)) return;
+
+    uint pix = pixelIndex(uv);
+    vec4 g = gbuf[curHalf() + pix];
+    vec2 cur = noisy[pix];
+    vec4 h = vec4(0.0);
+    bool valid = false;
+
+    if(g.w >= 0.0 && pc.historyValid != 0u) {
+        vec3 p = cam.pos + primaryDir(uv)*g.w;
+        ivec2 puv;
+        if(reproject(p, puv)) {
+            uint ppix = pixelIndex(puv);
+            vec4 pg = gbuf[prevHalf() + ppix];
+            float dist = distance(p, pc.prevPos.xyz);
+            valid = pg.w >= 0.0 && abs(pg.w - dist) < 0.03*dist && dot(pg.xyz, g.xyz) > 0.9;
+            if(valid) h = history[prevHalf() + ppix];
+        }
+    }
+
+    // a term not traced this frame (cur < 0) keeps its history, or reads
+    // as unoccluded until it has some
+    float len = valid ? min(h.z + 1.0, MAX_HISTORY) : 1.0;
+    vec2 v;
+    if(valid) {
+        float alpha = 1.0 / len;
+        v.x = cur.x < 0.0 ? h.x : mix(h.x, cur.x, alpha);
+        v.y = cur.y < 0.0 ? h.y : mix(h.y, cur.y, alpha);
+    } else {
+        v = vec2(cur.x < 0.0 ? 1.0 : cur.x, cur.y < 0.0 ? 1.0 : cur.y);
+    }
+
+    history[curHalf() + pix] = vec4(v, len, 0.0);
+    filt[pix] = v;
+}
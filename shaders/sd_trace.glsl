@@ -0,0 +1,34 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "denoise.glsl"
+
+// One shadow ray towards a jittered point on the sun disc and one
+// cosine-distributed AO ray of length AO_RADIUS per pixel. With
+// pc.rays == 1 the two alternate between frames and the other term
+// keeps last frame's temporal estimate.
+void main(){
+    ivec2 uv = ivec2(gl_GlobalInvocationID.xy);
+    if(!inImage(uv)) return;
+
+    uint pix = pixelIndex(uv);
+    vec4 g = gbuf[curHalf() + pix];
+    if(g.w < 0.0) { noisy[pix] = vec2(1.0); return; }
+
+    vec3 n = g.xyz;
+    vec3 p = cam.pos + primaryDir(uv)*g.w + n*(2.0*MARCH_EPS);
+    uint rng = pcgHash(pix + pcgHash(pc.frame));
+    bool doShadow = pc.rays > 1u || (pc.frame & 1u) == 0u;
+    bool doAO     = pc.rays > 1u || (pc.frame & 1u) == 1u;
+
+    vec2 v = vec2(-1.0);   // negative: not traced this frame
+    if(doShadow) {
+        vec3 l = sampleCone(SUN_DIR, SUN_COS_ANGLE, vec2(rand(rng), rand(rng)));
+        v.x = dot(n, l) <= 0.0 ? 0.0 : (marchRay(p, l, SD_MAXT) < 0.0 ? 1.0 : 0.0);
+    }
+    if(doAO) {
+        vec3 d = cosineHemisphere(n, vec2(rand(rng), rand(rng)));
+        v.y = marchRay(p, d, AO_RADIUS) < 0.0 ? 1.0 : 0.0;
+    }
+    noisy[pix] = v;
+}
@@ -0,0 +1,51 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+layout(local_size_x = 16, local_size_y = 16) in;
+
+#include "vrs.glsl"
+
+// Per block: depth and colour variance of the four corner samples. Smooth
+// blocks are filled by bilinear interpolation right here; the others are
+// queued for vr_refine, whose dispatch size grows with the queue.
+void main(){
+    uvec2 b = gl_GlobalInvocationID.xy;
+    uint blocksX = pc.gridW - 1u;
+    if(b.x >= blocksX || b.y >= pc.gridH - 1u) return;
+
+    vec4 c00 = coarse[ b.y     *pc.gridW + b.x];
+    vec4 c10 = coarse[ b.y     *pc.gridW + b.x+1u];
+    vec4 c01 = coarse[(b.y+1u)*pc.gridW + b.x];
+    vec4 c11 = coarse[(b.y+1u)*pc.gridW + b.x+1u];
+
+    int hits = int(c00.w >= 0.0) + int(c10.w >= 0.0) + int(c01.w >= 0.0) + int(c11.w >= 0.0);
+    bool refine = hits != 0 && hits != 4;
+    if(!refine && hits == 4) {
+        vec4 m = (c00 + c10 + c01 + c11) * 0.25;
+        vec4 d0 = c00 - m, d1 = c10 - m, d2 = c01 - m, d3 = c11 - m;
+        vec4 var = (d0*d0 + d1*d1 + d2*d2 + d3*d3) * 0.25;
+        float colorVar = var.r + var.g + var.b;
+        float depthVar = var.w / max(m.w*m.w, 1e-8);
+        refine = colorVar > pc.colorThreshold*pc.colorThreshold ||
+                 depthVar > pc.depthThreshold*pc.depthThreshold;
+    }
+
+    if(refine) {
+        uint slot = atomicAdd(refineCount, 1u);
+        refineBlocks[slot] = b.y*blocksX + b.x;
+        uint groups = ((slot + 1u)*pc.blockSize*pc.blockSize + 63u) / 64u;
+        atomicMax(refineArgs.x, groups);
+        return;
+    }
+
+    ivec2 origin = ivec2(b*pc.blockSize);
+    float inv = 1.0 / float(pc.blockSize);
+    for(uint y = 0u; y < pc.blockSize; y++) {
+        for(uint x = 0u; x < pc.blockSize; x++) {
+            ivec2 uv = origin + ivec2(x, y);
+            if(uv.x >= int(pc.width) || uv.y >= int(pc.height)) continue;
+            vec2 f = vec2(x, y) * inv;
+            vec3 col = mix(mix(c00.rgb, c10.rgb, f.x), mix(c01.rgb, c11.rgb, f.x), f.y);
+            imageStore(img, uv, vec4(col,1.0));
+        }
+    }
+}
@@ -0,0 +1,14 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+layout(local_size_x = 16, local_size_y = 16) in;
+
+#include "vrs.glsl"
+
+// One ray per block corner; corners past the image edge clamp onto it.
+void main(){
+    uvec2 g = gl_GlobalInvocationID.xy;
+    if(g.x >= pc.gridW || g.y >= pc.gridH) return;
+
+    ivec2 uv = min(ivec2(g*pc.blockSize), ivec2(pc.width-1u, pc.height-1u));
+    coarse[g.y*pc.gridW + g.x] = tracePixel(uv);
+}
@@ -0,0 +1,23 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+layout(local_size_x = 64) in;
+
+#include "vrs.glsl"
+
+// Full-rate march of every pixel in the blocks queued by vr_classify.
+void main(){
+    uint i = gl_GlobalInvocationID.x;
+    uint perBlock = pc.blockSize*pc.blockSize;
+    if(i >= refineCount*perBlock) return;
+
+    uint block = refineBlocks[i / perBlock];
+    uint sub   = i % perBlock;
+    uint blocksX = pc.gridW - 1u;
+    ivec2 uv = ivec2((block % blocksX)*pc.blockSize + sub % pc.blockSize,
+                     (block / blocksX)*pc.blockSize + sub / pc.blockSize);
+    if(uv.x >= int(pc.width) || uv.y >= int(pc.height)) return;
+
+    vec3 col = tracePixel(uv).rgb;
+    if(pc.showBlocks != 0u) col = mix(col, vec3(1.0, 0.2, 0.2), 0.3);
+    imageStore(img, uv, vec4(col,1.0));
+}
@@ -0,0 +1,49 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "zoom.glsl"
+
+// Log-polar sample at global column c, row r: columns clamp to the strips
+// held, rows wrap around
+vec3 fetch(int c, int r) {
+    c = clamp(c, int(pc.strip*pc.cols), int((pc.last + 1u)*pc.cols) - 1);
+    r = (r + int(pc.rows)) % int(pc.rows);
+    uint slot = uint(c) / pc.cols % pc.ring;
+    return unpackUnorm4x8(strips[(slot*pc.rows + uint(r))*pc.cols + uint(c) % pc.cols]).rgb;
+}
+
+vec3 bilinear(vec2 p) {
+    ivec2 i = ivec2(floor(p));
+    vec2 f = p - vec2(i);
+    return mix(mix(fetch(i.x, i.y),   fetch(i.x+1, i.y),   f.x),
+               mix(fetch(i.x, i.y+1), fetch(i.x+1, i.y+1), f.x), f.y);
+}
+
+// One frame at zoom exp(logScale). Towards the centre a pixel covers many
+// log-polar samples, so they are box-filtered over its footprint.
+void main(){
+    ivec2 uv = ivec2(gl_GlobalInvocationID.xy);
+    if(uv.x >= int(pc.width) || uv.y >= int(pc.height)) return;
+
+    vec2 frag = (vec2(uv) / vec2(pc.width, pc.height) - 0.5) * 2.0;
+    frag.x *= float(pc.width)/float(pc.height);
+    float rPix = length(frag) * 0.5 * float(pc.height);
+    vec3 col;
+    if(rPix < pc.innerR) {
+        col = traceFrag(frag * exp(-pc.logScale));
+    } else {
+        float u = log(length(frag)) - pc.logScale;
+        float a = atan(frag.y, frag.x) / PI2;
+        vec2 p = vec2((pc.uTop - u) / pc.du, fract(a) * float(pc.rows)) - 0.5;
+        // samples per pixel along each axis: the strips are dense enough
+        // for the frame corner, 1/du pixels out
+        float per = 1.0 / (pc.du * rPix);
+        int n = clamp(int(ceil(per)), 1, 8);
+        col = vec3(0.0);
+        for(int j = 0; j < n; j++)
+            for(int i = 0; i < n; i++)
+                col += bilinear(p + per * ((vec2(i, j) + 0.5) / float(n) - 0.5));
+        col /= float(n*n);
+    }
+    imageStore(img, uv, vec4(col, 1.0));
+}
@@ -0,0 +1,16 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "zoom.glsl"
+
+// March one strip of the log-polar map into its ring slot.
+void main(){
+    uvec2 s = gl_GlobalInvocationID.xy;   // column in the strip, row
+    if(s.x >= pc.cols || s.y >= pc.rows) return;
+
+    float u = pc.uTop - (float(pc.strip*pc.cols + s.x) + 0.5) * pc.du;
+    float a = PI2 * (float(s.y) + 0.5) / float(pc.rows);
+    vec3 col = traceFrag(exp(u) * vec2(cos(a), sin(a)));
+    uint slot = pc.strip % pc.ring;
+    strips[(slot*pc.rows + s.y)*pc.cols + s.x] = packUnorm4x8(vec4(col, 1.0));
+}
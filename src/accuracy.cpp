@@ -0,0 +1,170 @@
+// src/accuracy.cpp
+//
+// MetharizonBench --accuracy: sweeps every vmath.h function over its
+// documented domain at the scalar and native widths, measures the error
+// in float ulps against double-precision libm, and fails if any exceeds
+// its documented bound.
+#include "bench.h"
+#include "vmath.h"
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+const int SAMPLES = 1 << 20;
+
+// Error of `got` in units of the float spacing at `want`. Results below
+// `absFloor` in magnitude are judged against the spacing at absFloor,
+// so sin near its zeros is held to an absolute bound.
+double ulpError(float got, double want, double absFloor) {
+    if (std::isnan(want)) return std::isnan(got) ? 0.0 : INFINITY;
+    if (std::isinf(want)) return got == want ? 0.0 : INFINITY;
+    float  w   = (float)std::max(std::fabs(want), absFloor);
+    double ulp = (double)std::nextafter(w, INFINITY) - (double)w;
+    return std::fabs((double)got - want) / ulp;
+}
+
+float logUniform(std::mt19937 &g, float lo, float hi) {
+    std::uniform_real_distribution<float> u(std::log(lo), std::log(hi));
+    return std::exp(u(g));
+}
+
+float uniform(std::mt19937 &g, float lo, float hi) {
+    return std::uniform_real_distribution<float>(lo, hi)(g);
+}
+
+float randomSign(std::mt19937 &g) {
+    return g() & 1 ? 1.f : -1.f;
+}
+
+// One function under test: the width-N kernel, the double reference, the
+// input domain and the documented bound in ulps (keep in sync with vmath.h)
+struct Log {
+    static constexpr const char* name = "log";
+    static constexpr double absFloor = 0;
+    static double bound(double, double) { return 1; }
+    template<int N> static vfloat<N> eval(vfloat<N> x, vfloat<N>) { return vlog<N>(x); }
+    static double ref(double x, double) { return std::log(x); }
+    static void sample(std::mt19937 &g, float &x, float &) { x = logUniform(g, 1e-30f, 1e30f); }
+};
+struct Exp {
+    static constexpr const char* name = "exp";
+    static constexpr double absFloor = 0;
+    static double bound(double, double) { return 2; }
+    template<int N> static vfloat<N> eval(vfloat<N> x, vfloat<N>) { return vexp<N>(x); }
+    static double ref(double x, double) { return std::exp(x); }
+    static void sample(std::mt19937 &g, float &x, float &) { x = uniform(g, -87.f, 88.f); }
+};
+struct Pow {
+    static constexpr const char* name = "pow";
+    static constexpr double absFloor = 0;
+    // exp turns the absolute error of y log x (about an ulp of log
+    // and one of the product) into relative error
+    static double bound(double x, double y) { return 2 + 2 * std::fabs(y * std::log(x)); }
+    template<int N> static vfloat<N> eval(vfloat<N> x, vfloat<N> y) { return vpow<N>(x, y); }
+    static double ref(double x, double y) { return std::pow(x, y); }
+    // results that underflow past FLT_MIN are out of the domain
+    static void sample(std::mt19937 &g, float &x, float &y) {
+        do {
+            x = logUniform(g, 1e-3f, 4.f);
+            y = uniform(g, 1.f, 16.f);
+        } while (std::pow(double(x), double(y)) < 1.17549435e-38);
+    }
+};
+struct Sin {
+    static constexpr const char* name = "sin";
+    static constexpr double absFloor = 1e-3;
+    static double bound(double, double) { return 2; }
+    template<int N> static vfloat<N> eval(vfloat<N> x, vfloat<N>) {
+        vfloat<N> s, c;
+        vsincos<N>(x, s, c);
+        return s;
+    }
+    static double ref(double x, double) { return std::sin(x); }
+    static void sample(std::mt19937 &g, float &x, float &) { x = uniform(g, -8192.f, 8192.f); }
+};
+struct Cos {
+    static constexpr const char* name = "cos";
+    static constexpr double absFloor = 1e-3;
+    static double bound(double, double) { return 2; }
+    template<int N> static vfloat<N> eval(vfloat<N> x, vfloat<N>) {
+        vfloat<N> s, c;
+        vsincos<N>(x, s, c);
+        return c;
+    }
+    static double ref(double x, double) { return std::cos(x); }
+    static void sample(std::mt19937 &g, float &x, float &) { x = uniform(g, -8192.f, 8192.f); }
+};
+struct Atan2 {
+    static constexpr const char* name = "atan2";
+    static constexpr double absFloor = 0;
+    static double bound(double, double) { return 4; }
+    template<int N> static vfloat<N> eval(vfloat<N> y, vfloat<N> x) { return vatan2<N>(y, x); }
+    static double ref(double y, double x) { return std::atan2(y, x); }
+    static void sample(std::mt19937 &g, float &y, float &x) {
+        y = logUniform(g, 1e-20f, 1e20f) * randomSign(g);
+        x = logUniform(g, 1e-20f, 1e20f) * randomSign(g);
+    }
+};
+struct Acos {
+    static constexpr const char* name = "acos";
+    static constexpr double absFloor = 0;
+    static double bound(double, double) { return 2; }
+    template<int N> static vfloat<N> eval(vfloat<N> x, vfloat<N>) { return vacos<N>(x); }
+    static double ref(double x, double) { return std::acos(x); }
+    static void sample(std::mt19937 &g, float &x, float &) { x = uniform(g, -1.f, 1.f); }
+};
+
+template<class F, int N>
+void evalAll(const std::vector<float> &x, const std::vector<float> &y, std::vector<float> &out) {
+    for (size_t i = 0; i + N <= x.size(); i += N)
+        vstore<N>(&out[i], F::template eval<N>(vload<N>(&x[i]), vload<N>(&y[i])));
+}
+
+// Returns the number of widths over the bound
+template<class F>
+int check() {
+    std::mt19937 rng(42);
+    std::vector<float> xs(SAMPLES), ys(SAMPLES, 0.f), out(SAMPLES);
+    for (int i = 0; i < SAMPLES; i++)
+        F::sample(rng, xs[i], ys[i]);
+
+    int failures = 0;
+    for (int lanes : { 1, SIMD_LANES }) {
+        if (lanes == 1)       evalAll<F, 1>(xs, ys, out);
+        else if (lanes == 16) evalAll<F, 16>(xs, ys, out);
+        else if (lanes == 8)  evalAll<F, 8>(xs, ys, out);
+        else                  evalAll<F, 4>(xs, ys, out);
+
+        // worst sample relative to its bound
+        double worst = 0, worstUlp = 0;
+        int    at    = 0;
+        for (int i = 0; i < SAMPLES; i++) {
+            double e = ulpError(out[i], F::ref(xs[i], ys[i]), F::absFloor);
+            double r = e / F::bound(xs[i], ys[i]);
+            if (r > worst) { worst = r; worstUlp = e; at = i; }
+        }
+        bool ok = worst <= 1.0;
+        failures += !ok;
+        std::cout << std::left << std::setw(8) << F::name << std::right << std::setw(7) << lanes
+                  << std::setw(12) << std::setprecision(3) << worstUlp
+                  << std::setw(8) << F::bound(xs[at], ys[at])
+                  << "  " << std::setprecision(9) << xs[at] << ", " << ys[at]
+                  << (ok ? "" : "  FAIL") << "\n";
+    }
+    return failures;
+}
+
+} // namespace
+
+int runAccuracy() {
+    std::cout << std::left << std::setw(8) << "function" << std::right << std::setw(7) << "lanes"
+              << std::setw(12) << "max ulp" << std::setw(8) << "bound" << "  worst input\n";
+    int failures = check<Log>() + check<Exp>() + check<Pow>() + check<Sin>() + check<Cos>()
+                 + check<Atan2>() + check<Acos>();
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,264 @@
+// src/bench.cpp
+//
+// Benchmark runner: --filter SUBSTR, --min-time SECONDS, --repetitions N,
+// --json OUT, --compare BASELINE.json, --threshold PERCENT.
+// --accuracy checks the vmath.h error bounds instead, --de-check holds the
+// CPU distance estimators against the generated shader one, --cpu-render WxH
+// [--threads N] [--frames N] reports the CPU renderer's NUMA behaviour.
+//
+// With --gate BASELINE.json and/or --write-baseline OUT.json it runs the
+// renderer's headless scenes instead (see gate.h): --renderer PATH,
+// --scenes a,b, --size WxH, --device N, --warmup N, --frames N,
+// --trials N, --threshold PERCENT, --steps-threshold PERCENT, --readback.
+#include "bench.h"
+#include "gate.h"
+#include "json.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Registered {
+    const char* name;
+    BenchFn     fn;
+};
+
+std::vector<Registered> &registry() {
+    static std::vector<Registered> r;   // filled by static initialisers
+    return r;
+}
+
+struct Options {
+    std::string filter;
+    double      minTime     = 0.2;   // seconds per repetition
+    int         repetitions = 5;
+    std::string jsonFile;
+    std::string compareFile;
+    double      threshold   = 5.0;   // percent
+    bool        accuracy    = false;
+    bool        deCheck     = false;
+    uint32_t    cpuWidth = 0, cpuHeight = 0, cpuThreads = 0;
+    GateOptions gate;
+};
+
+struct Result {
+    std::string name;
+    uint64_t    iterations;
+    double      nsPerIter;      // median over repetitions
+    double      itemsPerSec;    // median over repetitions
+    double      cv;             // coefficient of variation of itemsPerSec
+};
+
+double runOnce(BenchFn fn, BenchState &state) {
+    auto t0 = std::chrono::steady_clock::now();
+    fn(state);
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(t1 - t0).count();
+}
+
+Result runBenchmark(const Registered &b, const Options &opt) {
+    // Grow the iteration count until one run takes minTime
+    uint64_t n = 1;
+    for (;;) {
+        BenchState s{ n };
+        double t = runOnce(b.fn, s);
+        if (t >= opt.minTime || n >= (1ull << 40)) break;
+        double grow = t > 0.0 ? 1.4 * opt.minTime / t : 10.0;
+        n = (uint64_t)std::ceil((double)n * std::min(10.0, std::max(1.4, grow)));
+    }
+
+    std::vector<double> nsPer, rate;
+    for (int r = 0; r < opt.repetitions; r++) {
+        BenchState s{ n };
+        double t = runOnce(b.fn, s);
+        nsPer.push_back(t * 1e9 / (double)n);
+        rate.push_back((double)s.items * (double)n / t);
+    }
+
+    double mean = 0.0, var = 0.0;
+    for (double x : rate) mean += x;
+    mean /= (double)rate.size();
+    for (double x : rate) var += (x - mean) * (x - mean);
+    var /= std::max<size_t>(1, rate.size() - 1);
+
+    auto median = [](std::vector<double> v) {
+        std::sort(v.begin(), v.end());
+        size_t m = v.size() / 2;
+        return v.size() % 2 ? v[m] : 0.5 * (v[m - 1] + v[m]);
+    };
+    return { b.name, n, median(nsPer), median(rate), mean > 0.0 ? std::sqrt(var) / mean : 0.0 };
+}
+
+std::string humanRate(double perSec) {
+    const char* units[] = { "", "k", "M", "G" };
+    int u = 0;
+    while (perSec >= 1000.0 && u < 3) { perSec /= 1000.0; u++; }
+    std::ostringstream s;
+    s << std::fixed << std::setprecision(2) << perSec << units[u] << "/s";
+    return s.str();
+}
+
+void writeJson(const std::string &path, const std::vector<Result> &results, const Options &opt) {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("Failed to open " + path);
+
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    out << std::setprecision(9);
+    out << "{\n  \"context\": {\"date\": \"" << date << "\", \"num_cpus\": "
+        << std::thread::hardware_concurrency() << ", \"repetitions\": " << opt.repetitions
+        << ", \"simd_lanes\": " << SIMD_LANES << "},\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        out << (i ? ",\n    " : "\n    ") << "{\"name\": ";
+        jsonWriteString(out, r.name);
+        out << ", \"iterations\": " << r.iterations << ", \"real_time\": " << r.nsPerIter
+            << ", \"time_unit\": \"ns\", \"items_per_second\": " << r.itemsPerSec
+            << ", \"cv\": " << r.cv << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+// Returns the number of regressions
+int compare(const std::string &path, const std::vector<Result> &results, double threshold) {
+    JsonValue base = jsonReadFile(path);
+    const JsonValue* list = base.find("benchmarks");
+    if (!list || list->type != JsonValue::ARRAY)
+        throw std::runtime_error(path + " has no \"benchmarks\" array");
+
+    std::cout << "\nComparison against " << path << " (threshold " << threshold << "%)\n"
+              << std::left << std::setw(34) << "benchmark" << std::right
+              << std::setw(14) << "baseline" << std::setw(14) << "current"
+              << std::setw(10) << "change" << "  verdict\n";
+
+    int regressions = 0;
+    for (const Result &r : results) {
+        const JsonValue* old = nullptr;
+        for (const JsonValue &b : list->array)
+            if (b.str("name") == r.name) old = &b;
+
+        std::cout << std::left << std::setw(34) << r.name << std::right;
+        if (!old) {
+            std::cout << std::setw(14) << "-" << std::setw(14) << humanRate(r.itemsPerSec)
+                      << std::setw(10) << "-" << "  new\n";
+            continue;
+        }
+        double before = old->num("items_per_second");
+        double change = before > 0.0 ? (r.itemsPerSec / before - 1.0) * 100.0 : 0.0;
+        // A change inside twice the run-to-run noise is not a verdict either way
+        double noise  = 200.0 * std::max(r.cv, old->num("cv"));
+        const char* verdict = "same";
+        if (change < -std::max(threshold, noise))     { verdict = "REGRESSION"; regressions++; }
+        else if (change > std::max(threshold, noise)) verdict = "faster";
+
+        std::ostringstream pct;
+        pct << std::showpos << std::fixed << std::setprecision(1) << change << "%";
+        std::cout << std::setw(14) << humanRate(before) << std::setw(14) << humanRate(r.itemsPerSec)
+                  << std::setw(10) << pct.str() << "  " << verdict << "\n";
+    }
+    return regressions;
+}
+
+Options parseOptions(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) throw std::runtime_error("Missing value for " + a);
+            return argv[++i];
+        };
+        if      (a == "--filter")      opt.filter      = value();
+        else if (a == "--min-time")    opt.minTime     = std::stod(value());
+        else if (a == "--repetitions") opt.repetitions = std::max(1, std::stoi(value()));
+        else if (a == "--json")        opt.jsonFile    = value();
+        else if (a == "--compare")     opt.compareFile = value();
+        else if (a == "--threshold")   opt.threshold   = opt.gate.threshold = std::stod(value());
+        else if (a == "--accuracy")    opt.accuracy = true;
+        else if (a == "--de-check")    opt.deCheck  = true;
+        else if (a == "--cpu-render") {
+            std::string v = value();
+            size_t x = v.find('x');
+            if (x == std::string::npos) throw std::runtime_error("--cpu-render expects WxH");
+            opt.cpuWidth  = uint32_t(std::max(32, std::stoi(v.substr(0, x))));
+            opt.cpuHeight = uint32_t(std::max(32, std::stoi(v.substr(x + 1))));
+        }
+        else if (a == "--threads")     opt.cpuThreads = uint32_t(std::max(0, std::stoi(value())));
+        else if (a == "--gate")        opt.gate.baseline      = value();
+        else if (a == "--write-baseline") opt.gate.writeBaseline = value();
+        else if (a == "--renderer")    opt.gate.renderer      = value();
+        else if (a == "--scenes")      opt.gate.scenes        = value();
+        else if (a == "--size")        opt.gate.size          = value();
+        else if (a == "--device")      opt.gate.device        = std::stoi(value());
+        else if (a == "--warmup")      opt.gate.warmup        = std::max(0, std::stoi(value()));
+        else if (a == "--frames")      opt.gate.frames        = std::max(1, std::stoi(value()));
+        else if (a == "--trials")      opt.gate.trials        = std::max(2, std::stoi(value()));
+        else if (a == "--steps-threshold") opt.gate.stepsThreshold = std::stod(value());
+        else if (a == "--readback")    opt.gate.readback      = true;
+        else throw std::runtime_error("Unknown option " + a);
+    }
+    // the renderer is built next to us
+    if (opt.gate.renderer.empty()) {
+        std::string self = argv[0];
+        size_t slash = self.find_last_of('/');
+        opt.gate.renderer = (slash == std::string::npos ? std::string(".") : self.substr(0, slash))
+                          + "/Metharizon";
+    }
+    return opt;
+}
+
+} // namespace
+
+int benchRegister(const char* name, BenchFn fn) {
+    registry().push_back({ name, fn });
+    return (int)registry().size();
+}
+
+int main(int argc, char** argv) {
+    try {
+        Options opt = parseOptions(argc, argv);
+        if (opt.accuracy)
+            return runAccuracy();
+        if (opt.deCheck)
+            return runDeCheck();
+        if (opt.cpuWidth)
+            return runCpuRender(opt.cpuWidth, opt.cpuHeight, opt.cpuThreads, opt.gate.frames);
+        if (!opt.gate.baseline.empty() || !opt.gate.writeBaseline.empty())
+            return runGate(opt.gate);
+
+        std::cout << std::left << std::setw(34) << "benchmark" << std::right
+                  << std::setw(14) << "ns/iter" << std::setw(14) << "iterations"
+                  << std::setw(16) << "throughput" << std::setw(8) << "cv" << "\n";
+        std::vector<Result> results;
+        for (const Registered &b : registry()) {
+            if (!opt.filter.empty() && std::strstr(b.name, opt.filter.c_str()) == nullptr) continue;
+            Result r = runBenchmark(b, opt);
+            std::cout << std::left << std::setw(34) << r.name << std::right << std::fixed
+                      << std::setprecision(1) << std::setw(14) << r.nsPerIter
+                      << std::setw(14) << r.iterations << std::setw(16) << humanRate(r.itemsPerSec)
+                      << std::setw(7) << r.cv * 100.0 << "%\n";
+            results.push_back(r);
+        }
+
+        if (!opt.jsonFile.empty()) writeJson(opt.jsonFile, results, opt);
+        if (!opt.compareFile.empty() && compare(opt.compareFile, results, opt.threshold) > 0)
+            return 1;
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 2;
+    }
+    return 0;
+}
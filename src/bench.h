@@ -0,0 +1,54 @@
+// src/bench.h
+//
+// A small google-benchmark-style harness for the CPU kernels. A benchmark
+// is a function that loops over its state and reports how many items
+// (DE evaluations, normals, rotations) one iteration processed:
+//
+//     void deTrig(BenchState &state) {
+//         for (auto _ : state) ...;
+//         state.items = POINTS;
+//     }
+//     BENCHMARK(deTrig);
+//
+// The runner picks the iteration count, repeats, and reports the median.
+#pragma once
+
+#include "simd.h"
+
+#include <cstdint>
+
+struct BenchState {
+    uint64_t iterations;
+    uint64_t items = 0;   // processed per iteration
+
+    // Non-trivial so `for (auto _ : state)` is not an unused variable
+    struct Tick { ~Tick() {} };
+
+    struct Iterator {
+        uint64_t left;
+        bool operator!=(const Iterator &o) const { return left != o.left; }
+        void operator++() { --left; }
+        Tick operator*() const { return {}; }
+    };
+    Iterator begin() const { return { iterations }; }
+    Iterator end()   const { return { 0 }; }
+};
+
+typedef void (*BenchFn)(BenchState &);
+
+int benchRegister(const char* name, BenchFn fn);
+
+#define BENCH_CONCAT2(a, b) a##b
+#define BENCH_CONCAT(a, b)  BENCH_CONCAT2(a, b)
+#define BENCHMARK_NAMED(name, fn) \
+    static int BENCH_CONCAT(benchReg_, __LINE__) = benchRegister(name, fn)
+#define BENCHMARK(fn) BENCHMARK_NAMED(#fn, fn)
+
+// vmath.h error sweep against libm (accuracy.cpp), 1 if a bound is exceeded
+int runAccuracy();
+
+// CPU DE kernels against the generated shader DE (decheck.cpp), 1 on a mismatch
+int runDeCheck();
+
+// Render frames on the NUMA-aware CPU renderer and print its node stats
+int runCpuRender(uint32_t width, uint32_t height, uint32_t threads, int frames);
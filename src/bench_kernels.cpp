@@ -0,0 +1,214 @@
+// src/bench_kernels.cpp
+//
+// Benchmarks for the CPU ports of the shader building blocks. Every DE
+// benchmark evaluates the same POINTS random points in the bulb's bounding
+// cube, so items/s is DE evaluations per second and directly comparable
+// across formulations and vector widths.
+#include "bench.h"
+#include "camera.h"
+#include "cpurender.h"
+#include "de.h"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+const int POINTS = 4096;
+
+struct PointSet {
+    std::vector<float> x, y, z;   // structure of arrays for the vector loads
+    std::vector<Vec3>  p;
+
+    PointSet() : x(POINTS), y(POINTS), z(POINTS), p(POINTS) {
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> u(-1.5f, 1.5f);
+        for (int i = 0; i < POINTS; i++) {
+            x[i] = u(rng); y[i] = u(rng); z[i] = u(rng);
+            p[i] = { x[i], y[i], z[i] };
+        }
+    }
+};
+
+const PointSet &points() {
+    static PointSet set;
+    return set;
+}
+
+// DE formulations
+
+void deTrigScalar(BenchState &state) {
+    const PointSet &ps = points();
+    for (auto _ : state)
+        for (const Vec3 &p : ps.p)
+            keepAlive(mandelbulbTrig(p));
+    state.items = POINTS;
+}
+BENCHMARK_NAMED("de/trig/scalar", deTrigScalar);
+
+void deAlgebraicScalar(BenchState &state) {
+    const PointSet &ps = points();
+    for (auto _ : state)
+        for (const Vec3 &p : ps.p)
+            keepAlive(mandelbulbAlgebraic(p));
+    state.items = POINTS;
+}
+BENCHMARK_NAMED("de/algebraic/scalar", deAlgebraicScalar);
+
+template<int N> void deAlgebraicSimd(BenchState &state) {
+    const PointSet &ps = points();
+    for (auto _ : state)
+        for (int i = 0; i < POINTS; i += N)
+            keepAlive(mandelbulbAlgebraic<N>(vload<N>(&ps.x[i]), vload<N>(&ps.y[i]), vload<N>(&ps.z[i])));
+    state.items = POINTS;
+}
+BENCHMARK_NAMED("de/algebraic/simd4",  deAlgebraicSimd<4>);
+BENCHMARK_NAMED("de/algebraic/simd8",  deAlgebraicSimd<8>);
+BENCHMARK_NAMED("de/algebraic/simd16", deAlgebraicSimd<16>);
+
+// Non-integer power, where the trig chain cannot be avoided: libm per
+// point against vmath.h lanes
+
+using OddPower = DePower<15, 2>;
+
+void dePowerLibm(BenchState &state) {
+    const PointSet &ps = points();
+    for (auto _ : state)
+        for (const Vec3 &p : ps.p)
+            keepAlive(mandelbulbTrig<OddPower>(p));
+    state.items = POINTS;
+}
+BENCHMARK_NAMED("de/power7.5/libm", dePowerLibm);
+
+template<int N> void dePowerSimd(BenchState &state) {
+    const PointSet &ps = points();
+    for (auto _ : state)
+        for (int i = 0; i < POINTS; i += N)
+            keepAlive(mandelbulbTrig<N, OddPower>(vload<N>(&ps.x[i]), vload<N>(&ps.y[i]),
+                                                  vload<N>(&ps.z[i])));
+    state.items = POINTS;
+}
+BENCHMARK_NAMED("de/power7.5/vmath1",  dePowerSimd<1>);
+BENCHMARK_NAMED("de/power7.5/vmath8",  dePowerSimd<8>);
+BENCHMARK_NAMED("de/power7.5/vmath16", dePowerSimd<16>);
+
+// Normal estimators, each over the algebraic DE; items are normals
+
+float deAlg(Vec3 p) { return mandelbulbAlgebraic(p); }
+
+void normalCentralBench(BenchState &state) {
+    const PointSet &ps = points();
+    for (auto _ : state)
+        for (const Vec3 &p : ps.p)
+            keepAlive(normalCentral(p, deAlg));
+    state.items = POINTS;
+}
+BENCHMARK_NAMED("normal/central6", normalCentralBench);
+
+void normalTetrahedralBench(BenchState &state) {
+    const PointSet &ps = points();
+    for (auto _ : state)
+        for (const Vec3 &p : ps.p)
+            keepAlive(normalTetrahedral(p, deAlg));
+    state.items = POINTS;
+}
+BENCHMARK_NAMED("normal/tetrahedral4", normalTetrahedralBench);
+
+void normalForwardBench(BenchState &state) {
+    const PointSet &ps = points();
+    for (auto _ : state)
+        for (const Vec3 &p : ps.p)
+            keepAlive(normalForward(p, deAlg));
+    state.items = POINTS;
+}
+BENCHMARK_NAMED("normal/forward4", normalForwardBench);
+
+// Camera math: one item is a full basis update (three rotations)
+
+// v' = v + 2w(q x v) + 2 q x (q x v), the usual alternative to q v q*
+void rotateVecCross(const Quat &q, const float in[3], float out[3]) {
+    float tx = 2.f * (q.y*in[2] - q.z*in[1]);
+    float ty = 2.f * (q.z*in[0] - q.x*in[2]);
+    float tz = 2.f * (q.x*in[1] - q.y*in[0]);
+    out[0] = in[0] + q.w*tx + (q.y*tz - q.z*ty);
+    out[1] = in[1] + q.w*ty + (q.z*tx - q.x*tz);
+    out[2] = in[2] + q.w*tz + (q.x*ty - q.y*tx);
+}
+
+template<void (*Rotate)(const Quat &, const float*, float*)>
+void cameraBasis(BenchState &state) {
+    const float axis[3] = { 0.267f, 0.535f, 0.802f };
+    Quat q = quatFromAxisAngle(axis, 0.3f);
+    Camera cam{};
+    for (auto _ : state) {
+        for (int i = 0; i < 256; i++) {
+            Rotate(q, BASE_FORWARD, cam.forward);
+            Rotate(q, BASE_UP,      cam.up);
+            Rotate(q, BASE_RIGHT,   cam.right);
+            keepAlive(cam);
+            q.x += 1e-7f;   // defeat hoisting out of the loop
+        }
+    }
+    state.items = 256;
+}
+BENCHMARK_NAMED("camera/basis_sandwich", cameraBasis<rotateVec>);
+BENCHMARK_NAMED("camera/basis_cross",    cameraBasis<rotateVecCross>);
+
+// The per-frame steering step from main(): two axis-angle compositions
+void cameraSteer(BenchState &state) {
+    Quat q{ 1.f, 0.f, 0.f, 0.f };
+    float upAxis[3], rightAxis[3];
+    for (auto _ : state) {
+        for (int i = 0; i < 256; i++) {
+            rotateVec(q, BASE_UP, upAxis);
+            q = quatMul(quatFromAxisAngle(upAxis, 0.01f), q);
+            rotateVec(q, BASE_RIGHT, rightAxis);
+            q = quatMul(quatFromAxisAngle(rightAxis, 0.007f), q);
+            quatNormalize(q);
+        }
+        keepAlive(q);
+    }
+    state.items = 256;
+}
+BENCHMARK_NAMED("camera/steer", cameraSteer);
+
+// Whole CPU frames on every core (cpurender.h); items are pixels
+
+Camera overviewCamera() {
+    Camera cam{};
+    cam.pos[2] = 3.f;
+    std::copy(BASE_FORWARD, BASE_FORWARD + 3, cam.forward);
+    std::copy(BASE_UP,      BASE_UP + 3,      cam.up);
+    std::copy(BASE_RIGHT,   BASE_RIGHT + 3,   cam.right);
+    return cam;
+}
+
+void cpuFrame(BenchState &state) {
+    const uint32_t w = 320, h = 240;
+    cpuRenderInit(w, h);
+    Camera cam = overviewCamera();
+    cpuRenderFrame(cam);   // placement frame
+    for (auto _ : state)
+        cpuRenderFrame(cam);
+    cpuRenderShutdown();
+    state.items = w * h;
+}
+BENCHMARK_NAMED("cpurender/frame320x240", cpuFrame);
+
+} // namespace
+
+int runCpuRender(uint32_t width, uint32_t height, uint32_t threads, int frames) {
+    cpuRenderInit(width, height, threads);
+    Camera cam = overviewCamera();
+    double total = 0;
+    for (int i = 0; i <= frames; i++) {
+        cpuRenderFrame(cam);
+        if (i) total += cpuRenderStats().frameMs;   // frame 0 places the pages
+    }
+    cpuRenderPrintStats(std::cout);
+    std::cout << "mean " << total / std::max(1, frames) << " ms over " << frames << " frames\n";
+    cpuRenderShutdown();
+    return 0;
+}
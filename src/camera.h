@@ -0,0 +1,49 @@
+// src/camera.h
+//
+// Camera UBO layout and the quaternion math that steers it, shared by the
+// renderer and the benchmarks.
+#pragma once
+
+#include <cmath>
+
+struct Camera {
+    alignas(16) float pos[3];
+    alignas(16) float forward[3];
+    alignas(16) float up[3];
+    alignas(16) float right[3];
+};
+
+struct Quat {
+    float w, x, y, z;
+};
+
+static inline Quat quatMul(const Quat& a, const Quat& b) {
+    return {
+        a.w*b.w - a.x*b.x - a.y*b.y - a.z*b.z,
+        a.w*b.x + a.x*b.w + a.y*b.z - a.z*b.y,
+        a.w*b.y - a.x*b.z + a.y*b.w + a.z*b.x,
+        a.w*b.z + a.x*b.y - a.y*b.x + a.z*b.w
+    };
+}
+
+static inline Quat quatFromAxisAngle(const float axis[3], float angle) {
+    float half = angle * 0.5f;
+    float s = std::sin(half);
+    return { std::cos(half), axis[0]*s, axis[1]*s, axis[2]*s };
+}
+
+static inline void quatNormalize(Quat& q) {
+    float len = std::sqrt(q.w*q.w + q.x*q.x + q.y*q.y + q.z*q.z);
+    q.w/=len; q.x/=len; q.y/=len; q.z/=len;
+}
+
+static inline void rotateVec(const Quat& q, const float in[3], float out[3]) {
+    Quat v{0.f, in[0], in[1], in[2]};
+    Quat iq{q.w, -q.x, -q.y, -q.z};
+    Quat r = quatMul(quatMul(q, v), iq);
+    out[0] = r.x; out[1] = r.y; out[2] = r.z;
+}
+
+static const float BASE_FORWARD[3] = {0.f, 0.f, -1.f};
+static const float BASE_UP[3]      = {0.f, 1.f, 0.f};
+static const float BASE_RIGHT[3]   = {1.f, 0.f, 0.f};
@@ -0,0 +1,198 @@
+// src/checkpoint.cpp
+#include "checkpoint.h"
+
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char   MAGIC[8] = { 'M', 'Z', 'C', 'K', 'P', 'T', '0', '1' };
+const size_t PAGE     = 4096;
+
+struct Header {
+    char     magic[8];
+    uint64_t jobHash;
+    uint64_t tileBytes;
+    uint32_t tiles;
+    uint32_t pad;
+};
+
+struct TileRecord {
+    uint64_t seq;              // 0 = never written
+    uint32_t samples;
+    uint32_t pad;
+    uint64_t dataChecksum;
+    uint64_t recordChecksum;   // over the fields above
+};
+
+int      fd = -1;
+uint8_t* base = nullptr;
+size_t   fileSize = 0, recordBytes = 0, slotBytes = 0, dataOffset = 0;
+uint32_t tileCount = 0;
+size_t   tileSize = 0;
+
+// per tile: slot holding the newest valid state (-1 = none) and its seq
+std::vector<int>      newest;
+std::vector<uint64_t> newestSeq;
+
+size_t roundUp(size_t n, size_t a) { return (n + a - 1) / a * a; }
+
+TileRecord &record(uint32_t tile, int slot) {
+    return reinterpret_cast<TileRecord*>(base + PAGE + slot * recordBytes)[tile];
+}
+
+uint8_t* slotData(uint32_t tile, int slot) {
+    return base + dataOffset + (size_t(tile) * 2 + slot) * slotBytes;
+}
+
+uint64_t recordChecksum(const TileRecord &r) {
+    return checksum64(&r, offsetof(TileRecord, recordChecksum));
+}
+
+void syncRange(const void* p, size_t n) {
+#ifndef _WIN32
+    uintptr_t begin = reinterpret_cast<uintptr_t>(p) & ~uintptr_t(PAGE - 1);
+    uintptr_t end   = reinterpret_cast<uintptr_t>(p) + n;
+    if (msync(reinterpret_cast<void*>(begin), end - begin, MS_SYNC) != 0)
+        throw std::runtime_error("Failed to sync the checkpoint");
+#endif
+}
+
+int newestSlot(uint32_t tile, uint64_t &seq) {
+    int best = -1;
+    seq = 0;
+    for (int s = 0; s < 2; s++) {
+        const TileRecord &r = record(tile, s);
+        if (!r.seq || r.seq <= seq || r.recordChecksum != recordChecksum(r)) continue;
+        if (r.dataChecksum != checksum64(slotData(tile, s), tileSize)) continue;
+        best = s;
+        seq  = r.seq;
+    }
+    return best;
+}
+
+} // namespace
+
+uint64_t checksum64(const void* data, size_t bytes, uint64_t seed) {
+    const uint64_t prime = 0x100000001b3ull;
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint64_t h = seed;
+    size_t i = 0;
+    for (; i + 8 <= bytes; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, p + i, 8);
+        h = (h ^ w) * prime;
+    }
+    for (; i < bytes; i++)
+        h = (h ^ p[i]) * prime;
+    return h;
+}
+
+#ifdef _WIN32
+
+bool checkpointOpen(const std::string &, uint64_t, uint32_t, size_t) {
+    throw std::runtime_error("Checkpoints need POSIX mmap");
+}
+void checkpointClose() {}
+
+#else
+
+bool checkpointOpen(const std::string &path, uint64_t jobHash, uint32_t tiles, size_t tileBytes) {
+    checkpointClose();
+    tileCount   = tiles;
+    tileSize    = tileBytes;
+    recordBytes = roundUp(tiles * sizeof(TileRecord), PAGE);
+    slotBytes   = roundUp(tileBytes, PAGE);
+    dataOffset  = PAGE + 2 * recordBytes;
+    fileSize    = dataOffset + size_t(tiles) * 2 * slotBytes;
+
+    fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) throw std::runtime_error("Failed to open " + path);
+    struct stat st;
+    if (fstat(fd, &st) != 0) throw std::runtime_error("Failed to stat " + path);
+    bool sized = size_t(st.st_size) == fileSize;
+    if (!sized && ftruncate(fd, off_t(fileSize)) != 0) {
+        checkpointClose();
+        throw std::runtime_error("Failed to size " + path);
+    }
+    // a store to a hole of a full disk raises SIGBUS, so reserve the blocks
+    // up front (macOS has no posix_fallocate and keeps the file sparse)
+#ifndef __APPLE__
+    if (int err = posix_fallocate(fd, 0, off_t(fileSize))) {
+        checkpointClose();
+        throw std::runtime_error("Failed to reserve " + std::to_string(fileSize >> 20) + " MiB for " +
+                                 path + ": " + std::strerror(err));
+    }
+#endif
+    void* mem = mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mem == MAP_FAILED) throw std::runtime_error("Failed to map " + path);
+    base = static_cast<uint8_t*>(mem);
+
+    Header h{};
+    std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.jobHash   = jobHash;
+    h.tileBytes = tileBytes;
+    h.tiles     = tiles;
+    bool kept = sized && std::memcmp(base, &h, sizeof(h)) == 0;
+    if (!kept) {
+        // forget the records before claiming the file for this job
+        std::memset(base + PAGE, 0, 2 * recordBytes);
+        syncRange(base + PAGE, 2 * recordBytes);
+        std::memcpy(base, &h, sizeof(h));
+        syncRange(base, sizeof(h));
+    }
+
+    newest.assign(tiles, -1);
+    newestSeq.assign(tiles, 0);
+    for (uint32_t t = 0; t < tiles; t++)
+        newest[t] = newestSlot(t, newestSeq[t]);
+    return kept;
+}
+
+void checkpointClose() {
+    if (base) munmap(base, fileSize);
+    if (fd >= 0) close(fd);
+    base = nullptr;
+    fd   = -1;
+}
+
+#endif
+
+uint32_t checkpointLoad(uint32_t tile, void* out) {
+    int slot = newest[tile];
+    if (slot < 0) return 0;
+    std::memcpy(out, slotData(tile, slot), tileSize);
+    return record(tile, slot).samples;
+}
+
+uint32_t checkpointSamples(uint32_t tile) {
+    return newest[tile] < 0 ? 0 : record(tile, newest[tile]).samples;
+}
+
+void checkpointStore(uint32_t tile, uint32_t samples, const void* data) {
+    int slot = newest[tile] == 0 ? 1 : 0;
+    uint8_t* dst = slotData(tile, slot);
+    std::memcpy(dst, data, tileSize);
+    syncRange(dst, tileSize);
+
+    TileRecord r{};
+    r.seq          = newestSeq[tile] + 1;
+    r.samples      = samples;
+    r.dataChecksum = checksum64(dst, tileSize);
+    r.recordChecksum = recordChecksum(r);
+    record(tile, slot) = r;
+    syncRange(&record(tile, slot), sizeof(r));
+
+    newest[tile]    = slot;
+    newestSeq[tile] = r.seq;
+}
@@ -0,0 +1,31 @@
+// src/checkpoint.h
+//
+// Crash-safe progress file for long offline renders, memory-mapped. After
+// a header naming the job, every tile has two (record, data) slots used in
+// turn: a store writes the idle slot's data and syncs it, then writes and
+// syncs that slot's record with a higher sequence number than the other.
+// Dying at any point leaves the previous slot intact. On open, checksums
+// reject torn records and data and the newest valid slot wins. The two
+// slots' records live on different pages so one torn page can't take out
+// both.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Open path for a job, creating it, or resetting it if it holds another
+// job (different hash or tile geometry). True if earlier progress was kept.
+bool checkpointOpen(const std::string &path, uint64_t jobHash, uint32_t tiles, size_t tileBytes);
+void checkpointClose();
+
+// Samples in the tile's newest consistent state, 0 if it has none. If
+// non-zero its tileBytes of data are copied to out.
+uint32_t checkpointLoad(uint32_t tile, void* out);
+uint32_t checkpointSamples(uint32_t tile);
+
+// Record the tile's state durably: returns once data and record are synced
+void checkpointStore(uint32_t tile, uint32_t samples, const void* data);
+
+// FNV-1a over 64-bit words (the tail byte-wise), for records and job hashes
+uint64_t checksum64(const void* data, size_t bytes, uint64_t seed = 0xcbf29ce484222325ull);
@@ -0,0 +1,405 @@
+// src/cluster.cpp
+#include "cluster.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#ifndef _WIN32
+#include <csignal>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+enum MsgType : uint32_t { MSG_HELLO = 1, MSG_JOB, MSG_RESULT, MSG_ERROR };
+
+struct MsgHeader {
+    uint32_t type, size;   // size of the payload that follows
+};
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point t) {
+    return std::chrono::duration<double>(Clock::now() - t).count();
+}
+
+#ifndef _WIN32
+
+// A worker or coordinator that goes away must not SIGPIPE the other end:
+// MSG_NOSIGNAL per send where it exists, SO_NOSIGPIPE per socket on macOS
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int SEND_FLAGS = 0;
+#endif
+
+void noSigpipe(int fd) {
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#else
+    (void)fd;
+#endif
+}
+
+bool sendAll(int fd, const void* data, size_t n) {
+    const char* p = static_cast<const char*>(data);
+    while (n) {
+        ssize_t k = send(fd, p, n, SEND_FLAGS);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) return false;
+        p += k;
+        n -= size_t(k);
+    }
+    return true;
+}
+
+bool recvAll(int fd, void* data, size_t n) {
+    char* p = static_cast<char*>(data);
+    while (n) {
+        ssize_t k = recv(fd, p, n, 0);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) return false;
+        p += k;
+        n -= size_t(k);
+    }
+    return true;
+}
+
+bool sendMsg(int fd, MsgType type, const void* a, size_t an, const void* b = nullptr, size_t bn = 0) {
+    MsgHeader h{ type, uint32_t(an + bn) };
+    return sendAll(fd, &h, sizeof(h)) && sendAll(fd, a, an) && (!bn || sendAll(fd, b, bn));
+}
+
+sockaddr_un socketAddress(const std::string &path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+        throw std::runtime_error("Socket path too long: " + path);
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    return addr;
+}
+
+struct Worker {
+    int                  fd = -1;
+    pid_t                pid = -1;       // -1 for workers started by hand
+    bool                 sameUser = false;  // peer runs as us, its hello may name its pid
+    std::string          name = "?";
+    std::vector<uint8_t> inbox;
+    bool                 ready = false;  // said hello
+    int                  band = -1;      // in flight
+    Clock::time_point    sent;
+    uint32_t             bands = 0;
+    double               busySecs = 0;
+};
+
+// Identify the process at the other end. Linux tells the pid; elsewhere
+// getpeereid only vouches for the user, and the hello names the pid.
+void identifyPeer(Worker &w) {
+#ifdef __linux__
+    ucred cred{};
+    socklen_t len = sizeof(cred);
+    if (getsockopt(w.fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0) {
+        w.pid      = cred.pid;
+        w.sameUser = cred.uid == geteuid();
+    }
+#else
+    uid_t uid;
+    gid_t gid;
+    w.sameUser = getpeereid(w.fd, &uid, &gid) == 0 && uid == geteuid();
+#endif
+}
+
+pid_t spawnWorker(const std::vector<std::string> &argv) {
+    std::vector<char*> args;
+    for (const std::string &a : argv) args.push_back(const_cast<char*>(a.c_str()));
+    args.push_back(nullptr);
+    pid_t pid = fork();
+    if (pid < 0) throw std::runtime_error("fork failed");
+    if (pid == 0) {
+        execvp(args[0], args.data());
+        std::perror(args[0]);
+        _exit(127);
+    }
+    return pid;
+}
+
+#endif
+
+} // namespace
+
+#ifdef _WIN32
+
+void runCoordinator(const CoordinatorOptions &) {
+    throw std::runtime_error("Cluster rendering needs Unix domain sockets");
+}
+int  clusterConnect(const std::string &, const std::string &) {
+    throw std::runtime_error("Cluster rendering needs Unix domain sockets");
+}
+bool clusterNextJob(int, ClusterJob &) { return false; }
+bool clusterSendResult(int, const ClusterJob &, const std::vector<uint8_t> &) { return false; }
+void clusterSendError(int, const std::string &) {}
+void clusterClose(int) {}
+
+#else
+
+void runCoordinator(const CoordinatorOptions &opt) {
+    std::string path = opt.socketPath.empty() ?
+        "/tmp/metharizon-" + std::to_string(getpid()) + ".sock" : opt.socketPath;
+    sockaddr_un addr = socketAddress(path);
+    int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) throw std::runtime_error("Failed to create a socket");
+    unlink(path.c_str());
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listenFd, 64) != 0)
+        throw std::runtime_error("Failed to listen on " + path);
+
+    std::vector<pid_t> children;
+    for (int dev : opt.devices) {
+        std::vector<std::string> argv = opt.workerArgv;
+        argv.insert(argv.end(), { "--worker", path, "--device", std::to_string(dev) });
+        children.push_back(spawnWorker(argv));
+    }
+
+    uint32_t bands = (opt.height + opt.bandRows - 1) / opt.bandRows;
+    std::deque<uint32_t>  pending;
+    std::vector<bool>     finished(bands, false);
+    std::vector<uint32_t> copies(bands, 0);   // workers rendering the band
+    for (uint32_t b = 0; b < bands; b++) pending.push_back(b);
+    std::vector<uint8_t> image(size_t(3) * opt.width * opt.height);
+    std::vector<Worker> workers;
+    uint32_t done = 0, requeued = 0, duplicated = 0;
+    double   bandSecs = 0;   // mean time of finished bands
+    auto lastAlive = Clock::now();
+    std::cout << "coordinator: " << bands << " bands of " << opt.bandRows << " rows on " << path << "\n";
+
+    auto fail = [&](Worker &w, const std::string &why) {
+        std::cout << "coordinator: worker " << w.name << " lost (" << why << ")";
+        close(w.fd);
+        w.fd = -1;
+        if (w.pid > 0) kill(w.pid, SIGKILL);
+        if (w.band >= 0 && !finished[w.band] && --copies[w.band] == 0) {
+            pending.push_front(uint32_t(w.band));
+            requeued++;
+            std::cout << ", band " << w.band << " requeued";
+        }
+        std::cout << "\n";
+        w.band = -1;
+    };
+    auto assign = [&](Worker &w, uint32_t band) {
+        ClusterJob job{};
+        job.band    = band;
+        job.y0      = band * opt.bandRows;
+        job.rows    = std::min(opt.bandRows, opt.height - job.y0);
+        job.width   = opt.width;
+        job.height  = opt.height;
+        job.spp     = opt.spp;
+        job.bounces = opt.bounces;
+        std::strncpy(job.scene, opt.scene.c_str(), sizeof(job.scene) - 1);
+        w.band = int(band);
+        w.sent = Clock::now();
+        copies[band]++;
+        if (!sendMsg(w.fd, MSG_JOB, &job, sizeof(job)))
+            fail(w, "send failed");
+    };
+    auto handle = [&](Worker &w, const MsgHeader &h, const uint8_t* payload) {
+        if (h.type == MSG_HELLO) {
+            w.name  = std::string(reinterpret_cast<const char*>(payload), h.size);
+            w.ready = true;
+            // "<device> (pid N)", for platforms whose sockets don't tell
+            size_t at = w.name.rfind("(pid ");
+            if (w.pid < 0 && w.sameUser && at != std::string::npos) {
+                pid_t pid = pid_t(std::atol(w.name.c_str() + at + 5));
+                if (std::find(children.begin(), children.end(), pid) != children.end()) w.pid = pid;
+            }
+            std::cout << "coordinator: worker " << w.name << " ready\n";
+            return;
+        }
+        if (h.type == MSG_ERROR) {
+            fail(w, std::string(reinterpret_cast<const char*>(payload), h.size));
+            return;
+        }
+        uint32_t band;
+        if (h.type != MSG_RESULT || h.size < sizeof(band)) {
+            fail(w, "protocol error");
+            return;
+        }
+        std::memcpy(&band, payload, sizeof(band));
+        if (band >= bands || int(band) != w.band) {
+            fail(w, "protocol error");
+            return;
+        }
+        uint32_t y0 = band * opt.bandRows, rows = std::min(opt.bandRows, opt.height - y0);
+        size_t bytes = size_t(3) * opt.width * rows;
+        if (h.size != sizeof(band) + bytes) {
+            fail(w, "bad result size");
+            return;
+        }
+        double secs = secondsSince(w.sent);
+        w.busySecs += secs;
+        w.bands++;
+        w.band = -1;
+        copies[band]--;
+        if (finished[band]) return;   // a duplicate lost the race
+        std::memcpy(&image[size_t(3) * opt.width * y0], payload + sizeof(band), bytes);
+        finished[band] = true;
+        bandSecs += (secs - bandSecs) / ++done;
+    };
+
+    while (done < bands) {
+        // hand out bands; with none left, back up the slowest one in flight
+        for (Worker &w : workers) {
+            if (w.fd < 0 || !w.ready || w.band >= 0) continue;
+            while (!pending.empty() && finished[pending.front()]) pending.pop_front();
+            if (!pending.empty()) {
+                uint32_t band = pending.front();
+                pending.pop_front();
+                assign(w, band);
+                continue;
+            }
+            const Worker* slowest = nullptr;
+            for (const Worker &o : workers)
+                if (o.fd >= 0 && o.band >= 0 && copies[o.band] == 1 &&
+                    (!slowest || o.sent < slowest->sent))
+                    slowest = &o;
+            if (slowest && secondsSince(slowest->sent) > 1.5 * bandSecs) {
+                duplicated++;
+                assign(w, uint32_t(slowest->band));
+            }
+        }
+
+        std::vector<pollfd> fds{ { listenFd, POLLIN, 0 } };
+        for (const Worker &w : workers)
+            if (w.fd >= 0) fds.push_back({ w.fd, POLLIN, 0 });
+        if (poll(fds.data(), fds.size(), 100) < 0 && errno != EINTR)
+            throw std::runtime_error("poll failed");
+
+        if (fds[0].revents & POLLIN) {
+            Worker w;
+            w.fd = accept(listenFd, nullptr, nullptr);
+            if (w.fd >= 0) {
+                noSigpipe(w.fd);
+                identifyPeer(w);
+                // only children we spawned are ours to signal
+                if (std::find(children.begin(), children.end(), w.pid) == children.end())
+                    w.pid = -1;
+                workers.push_back(std::move(w));
+            }
+        }
+        for (Worker &w : workers) {
+            if (w.fd < 0) continue;
+            auto it = std::find_if(fds.begin() + 1, fds.end(), [&](const pollfd &p) { return p.fd == w.fd; });
+            if (it != fds.end() && (it->revents & (POLLIN | POLLHUP | POLLERR))) {
+                uint8_t buf[1 << 16];
+                ssize_t k = recv(w.fd, buf, sizeof(buf), 0);
+                if (k <= 0) {
+                    fail(w, k == 0 ? "disconnected" : std::strerror(errno));
+                    continue;
+                }
+                w.inbox.insert(w.inbox.end(), buf, buf + k);
+                MsgHeader h;
+                while (w.fd >= 0 && w.inbox.size() >= sizeof(h)) {
+                    std::memcpy(&h, w.inbox.data(), sizeof(h));
+                    if (w.inbox.size() < sizeof(h) + h.size) break;
+                    handle(w, h, w.inbox.data() + sizeof(h));
+                    if (w.fd >= 0)
+                        w.inbox.erase(w.inbox.begin(), w.inbox.begin() + sizeof(h) + h.size);
+                }
+            }
+            if (w.fd >= 0 && w.band >= 0 && opt.timeoutSecs > 0.f && secondsSince(w.sent) > opt.timeoutSecs)
+                fail(w, "band timed out");
+        }
+
+        // children that died before connecting never show up as workers
+        for (pid_t &pid : children)
+            if (pid > 0 && waitpid(pid, nullptr, WNOHANG) == pid) pid = 0;
+        bool alive = std::any_of(workers.begin(), workers.end(), [](const Worker &w) { return w.fd >= 0; });
+        bool starting = std::any_of(children.begin(), children.end(), [&](pid_t pid) {
+            return pid > 0 && std::none_of(workers.begin(), workers.end(), [&](const Worker &w) { return w.pid == pid; });
+        });
+        if (alive || starting) lastAlive = Clock::now();
+        else if (secondsSince(lastAlive) > opt.connectSecs) {
+            close(listenFd);
+            unlink(path.c_str());
+            throw std::runtime_error("No workers left with " + std::to_string(bands - done) + " bands to go");
+        }
+    }
+
+    // hanging up tells idle workers to exit; losing duplicates needn't finish
+    for (Worker &w : workers) {
+        if (w.fd < 0) continue;
+        if (w.band >= 0 && w.pid > 0) kill(w.pid, SIGTERM);
+        close(w.fd);
+    }
+    for (pid_t pid : children)
+        if (pid > 0) waitpid(pid, nullptr, 0);
+    close(listenFd);
+    unlink(path.c_str());
+
+    std::ofstream out(opt.output, std::ios::binary);
+    if (!out) throw std::runtime_error("Failed to open " + opt.output);
+    out << "P6\n" << opt.width << " " << opt.height << "\n255\n";
+    out.write(reinterpret_cast<const char*>(image.data()), image.size());
+    if (!out) throw std::runtime_error("Failed to write " + opt.output);
+
+    std::cout << "coordinator: wrote " << opt.output << ", " << requeued << " bands requeued, "
+              << duplicated << " duplicated\n";
+    for (const Worker &w : workers)
+        std::cout << "  " << w.name << ": " << w.bands << " bands, "
+                  << (w.bands ? w.busySecs / w.bands : 0.0) << " s each\n";
+}
+
+int clusterConnect(const std::string &socketPath, const std::string &deviceName) {
+    sockaddr_un addr = socketAddress(socketPath);
+    auto start = Clock::now();
+    for (;;) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) throw std::runtime_error("Failed to create a socket");
+        if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+            noSigpipe(fd);
+            std::string hello = deviceName + " (pid " + std::to_string(getpid()) + ")";
+            if (!sendMsg(fd, MSG_HELLO, hello.data(), hello.size()))
+                throw std::runtime_error("Lost the coordinator");
+            return fd;
+        }
+        close(fd);
+        if (secondsSince(start) > 30.0)
+            throw std::runtime_error("No coordinator on " + socketPath);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+}
+
+bool clusterNextJob(int fd, ClusterJob &job) {
+    MsgHeader h;
+    if (!recvAll(fd, &h, sizeof(h))) return false;
+    if (h.type != MSG_JOB || h.size != sizeof(job))
+        throw std::runtime_error("Unexpected message from the coordinator");
+    if (!recvAll(fd, &job, sizeof(job))) return false;
+    job.scene[sizeof(job.scene) - 1] = 0;
+    return true;
+}
+
+bool clusterSendResult(int fd, const ClusterJob &job, const std::vector<uint8_t> &rgb) {
+    return sendMsg(fd, MSG_RESULT, &job.band, sizeof(job.band), rgb.data(), rgb.size());
+}
+
+void clusterSendError(int fd, const std::string &message) {
+    sendMsg(fd, MSG_ERROR, message.data(), message.size());
+}
+
+void clusterClose(int fd) {
+    close(fd);
+}
+
+#endif
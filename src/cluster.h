@@ -0,0 +1,45 @@
+// src/cluster.h
+//
+// Multi-process rendering of a path-traced still over a Unix domain
+// socket. The coordinator splits the image into bands of rows and hands
+// them to worker processes (Metharizon --worker, each on its own --device)
+// whenever one goes idle, so faster devices take more bands, and it
+// reassembles the results. A worker that disconnects or overruns the
+// timeout loses its band back to the queue. Once the queue is empty, idle
+// workers duplicate the longest-running band and the first copy back wins.
+// Bands are deterministic (samples seeded by index), so any copy is as
+// good as another.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ClusterJob {
+    uint32_t band, y0, rows;
+    uint32_t width, height, spp, bounces;
+    char     scene[32];
+};
+
+struct CoordinatorOptions {
+    std::string output;                   // PPM
+    std::string socketPath;               // empty = /tmp/metharizon-<pid>.sock
+    std::vector<std::string> workerArgv;  // spawn command (PATH searched), "--worker SOCKET --device N" appended
+    std::vector<int> devices;             // one spawned worker per entry, -1 = default device
+    std::string scene;
+    uint32_t    width = 0, height = 0, spp = 64, bounces = 4, bandRows = 32;
+    float       timeoutSecs = 0.f;        // per band, 0 = never
+    float       connectSecs = 60.f;       // give up if no worker is left or arriving
+};
+
+// Throws on errors, including every worker failing
+void runCoordinator(const CoordinatorOptions &opt);
+
+// Worker side. Connect (retrying while the coordinator starts) and announce
+// the device; then take jobs until the coordinator hangs up, which it may
+// also do mid-band once another copy of the band has come back.
+int  clusterConnect(const std::string &socketPath, const std::string &deviceName);
+bool clusterNextJob(int fd, ClusterJob &job);
+bool clusterSendResult(int fd, const ClusterJob &job, const std::vector<uint8_t> &rgb);
+void clusterSendError(int fd, const std::string &message);
+void clusterClose(int fd);
@@ -0,0 +1,324 @@
+// src/cpurender.cpp
+#include "cpurender.h"
+#include "de.h"
+#include "topology.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+const int   LANES = 8;          // pixels per packet, a quarter of a tile row
+const int   MAX_STEPS = 128;    // as comp.glsl
+const float MAXT = 50.f;
+
+struct NodeQueue {
+    uint32_t              begin, end;    // owned band of tile indices
+    std::atomic<uint32_t> next{0};
+    std::vector<int>      stealOrder;    // other nodes, nearest first
+};
+
+struct Worker {
+    std::thread thread;
+    int         node, cpu;
+    uint64_t    localTiles = 0, stolenTiles = 0;
+};
+
+std::vector<NumaNode>                   topology;
+std::vector<std::unique_ptr<NodeQueue>> queues;
+std::vector<std::unique_ptr<Worker>>    workers;
+
+uint32_t fbWidth = 0, fbHeight = 0, tilesX = 0, tilesY = 0;
+uint8_t* framebuffer = nullptr;
+size_t   framebufferSize = 0;
+uint8_t* target = nullptr;            // framebuffer unless cpuRenderSetTarget
+void*    mapping = nullptr;           // framebuffer's allocation, before alignment
+size_t   mappingSize = 0;
+
+std::mutex              poolLock;
+std::condition_variable wake, finished;
+uint64_t                generation = 0;
+uint32_t                running = 0;
+bool                    quit = false;
+
+Camera         frameCam;
+bool           allowSteal = false;
+bool           placementChecked = false;
+CpuRenderStats stats;
+
+// Shade N horizontally adjacent pixels starting at (x0, y) into out
+void renderPacket(uint32_t x0, uint32_t y, uint8_t* out) {
+    typedef vfloat<LANES> vf;
+    const Camera &c = frameCam;
+    float aspect = float(fbWidth) / float(fbHeight);
+    vf px;
+    for (int i = 0; i < LANES; i++) px[i] = float(x0 + i);
+    vf   fx = (px / float(fbWidth) - 0.5f) * 2.f * aspect;
+    float fy = (float(y) / float(fbHeight) - 0.5f) * 2.f;
+
+    vf rdx = fx*c.right[0] + fy*c.up[0] + c.forward[0];
+    vf rdy = fx*c.right[1] + fy*c.up[1] + c.forward[1];
+    vf rdz = fx*c.right[2] + fy*c.up[2] + c.forward[2];
+    vf inv = 1.f / vsqrt<LANES>(rdx*rdx + rdy*rdy + rdz*rdz);
+    rdx *= inv; rdy *= inv; rdz *= inv;
+
+    vf t = splat<LANES>(0.f);
+    vmask<LANES> active = t == t;
+    for (int i = 0; i < MAX_STEPS && any<LANES>(active); i++) {
+        vf d = mandelbulbAlgebraic<LANES>(c.pos[0] + rdx*t, c.pos[1] + rdy*t, c.pos[2] + rdz*t);
+        active &= ~((d < 0.001f) | (t > MAXT));
+        t = select<LANES>(active, t + d, t);
+    }
+
+    vmask<LANES> hit = t <= MAXT;
+    vf r = splat<LANES>(0.f), g = r, b = r;   // background
+    if (any<LANES>(hit)) {
+        vf hx = c.pos[0] + rdx*t, hy = c.pos[1] + rdy*t, hz = c.pos[2] + rdz*t;
+        const float e = 0.0005f;   // getNormal()
+        auto de = [](vf x, vf y, vf z) { return mandelbulbAlgebraic<LANES>(x, y, z); };
+        vf nx = de(hx + e, hy, hz) - de(hx - e, hy, hz);
+        vf ny = de(hx, hy + e, hz) - de(hx, hy - e, hz);
+        vf nz = de(hx, hy, hz + e) - de(hx, hy, hz - e);
+        vf nl = 1.f / vsqrt<LANES>(nx*nx + ny*ny + nz*nz);
+        // shadeNormal(): light normalize(1, 1, 0.5)
+        vf diff = (nx*0.666666667f + ny*0.666666667f + nz*0.333333333f) * nl;
+        diff = vmin<LANES>(vmax<LANES>(diff, splat<LANES>(0.f)), splat<LANES>(1.f));
+        r = select<LANES>(hit, 0.1f + 0.5f*diff, r);
+        g = select<LANES>(hit, 0.1f + 0.7f*diff, g);
+        b = select<LANES>(hit, 0.2f + 0.8f*diff, b);
+    }
+    for (int i = 0; i < LANES; i++) {
+        out[4*i + 0] = uint8_t(std::clamp(r[i], 0.f, 1.f) * 255.f + 0.5f);
+        out[4*i + 1] = uint8_t(std::clamp(g[i], 0.f, 1.f) * 255.f + 0.5f);
+        out[4*i + 2] = uint8_t(std::clamp(b[i], 0.f, 1.f) * 255.f + 0.5f);
+        out[4*i + 3] = 255;
+    }
+}
+
+void renderTile(uint32_t tile) {
+    uint32_t tx = tile % tilesX, ty = tile / tilesX;
+    uint8_t* base = target + size_t(tile) * CPU_TILE_BYTES;
+    for (uint32_t row = 0; row < CPU_TILE; row++) {
+        uint32_t y = ty * CPU_TILE + row;
+        if (y >= fbHeight) break;
+        for (uint32_t col = 0; col < CPU_TILE; col += LANES) {
+            if (tx * CPU_TILE + col >= fbWidth) break;
+            renderPacket(tx * CPU_TILE + col, y, base + (row * CPU_TILE + col) * 4);
+        }
+    }
+}
+
+bool takeTile(NodeQueue &q, uint32_t &tile) {
+    if (q.next.load(std::memory_order_relaxed) >= q.end) return false;
+    tile = q.next.fetch_add(1, std::memory_order_relaxed);
+    return tile < q.end;
+}
+
+void workerMain(Worker* w) {
+    pinThreadToCpu(w->cpu);
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> l(poolLock);
+            wake.wait(l, [&] { return quit || generation != seen; });
+            if (quit) return;
+            seen = generation;
+        }
+        uint32_t tile;
+        while (takeTile(*queues[w->node], tile)) {
+            renderTile(tile);
+            w->localTiles++;
+        }
+        if (allowSteal)
+            for (int victim : queues[w->node]->stealOrder)
+                while (takeTile(*queues[victim], tile)) {
+                    renderTile(tile);
+                    w->stolenTiles++;
+                }
+        std::lock_guard<std::mutex> l(poolLock);
+        if (--running == 0) finished.notify_one();
+    }
+}
+
+// Where did each node's band of pages land? Only meaningful once touched.
+void checkPlacement() {
+    for (size_t n = 0; n < queues.size(); n++) {
+        CpuNodeStats &ns = stats.nodes[n];
+        ns.localPages = ns.remotePages = 0;
+        for (uint32_t t = queues[n]->begin; t < queues[n]->end; t++) {
+            int home = pageNode(target + size_t(t) * CPU_TILE_BYTES);
+            if (home < 0) continue;
+            (home == topology[n].memNode ? ns.localPages : ns.remotePages)++;
+        }
+    }
+}
+
+} // namespace
+
+void cpuRenderInit(uint32_t width, uint32_t height, uint32_t maxThreads, size_t alignment) {
+    cpuRenderShutdown();
+    fbWidth  = width;
+    fbHeight = height;
+    tilesX   = (width  + CPU_TILE - 1) / CPU_TILE;
+    tilesY   = (height + CPU_TILE - 1) / CPU_TILE;
+    uint32_t tiles = tilesX * tilesY;
+
+    // untouched pages: the renderer's first writes decide their node
+    alignment = std::max(alignment, CPU_TILE_BYTES);
+    if (alignment & (alignment - 1))
+        throw std::runtime_error("CPU framebuffer alignment must be a power of two");
+    framebufferSize = (size_t(tiles) * CPU_TILE_BYTES + alignment - 1) & ~(alignment - 1);
+#ifdef __linux__
+    // mmap only guarantees page alignment, map the slack and skip to the boundary
+    mappingSize = framebufferSize + alignment - CPU_TILE_BYTES;
+    mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) throw std::runtime_error("Failed to map the CPU framebuffer");
+    // a transparent huge page spans many tiles and would land whole on the
+    // node of its first writer; best effort, kernels without THP refuse it
+    madvise(mapping, mappingSize, MADV_NOHUGEPAGE);
+    uintptr_t addr = (reinterpret_cast<uintptr_t>(mapping) + alignment - 1) & ~uintptr_t(alignment - 1);
+    framebuffer = reinterpret_cast<uint8_t*>(addr);
+#else
+    mapping = std::aligned_alloc(alignment, framebufferSize);
+    if (!mapping) throw std::runtime_error("Failed to allocate the CPU framebuffer");
+    framebuffer = static_cast<uint8_t*>(mapping);
+#endif
+    target = framebuffer;
+
+    topology = discoverTopology();
+    // spread a thread cap over the nodes in proportion to their CPUs. A cap
+    // below the node count leaves some nodes without a thread; the others
+    // steal their bands from the first frame on.
+    uint32_t total = 0;
+    for (const NumaNode &n : topology) total += uint32_t(n.cpus.size());
+    uint32_t budget = maxThreads ? std::min(maxThreads, total) : total;
+
+    stats = CpuRenderStats{};
+    uint32_t assigned = 0, cpusBefore = 0, threadsBefore = 0;
+    bool     idleNode = false;
+    for (size_t n = 0; n < topology.size(); n++) {
+        const NumaNode &node = topology[n];
+        auto q = std::make_unique<NodeQueue>();
+        // band of tiles in proportion to the node's CPUs
+        cpusBefore += uint32_t(node.cpus.size());
+        q->begin = assigned;
+        q->end   = n + 1 == topology.size() ? tiles : uint32_t(uint64_t(tiles) * cpusBefore / total);
+        assigned = q->end;
+        for (size_t o = 0; o < topology.size(); o++)
+            if (o != n) q->stealOrder.push_back(int(o));
+        std::stable_sort(q->stealOrder.begin(), q->stealOrder.end(), [&](int a, int b) {
+            return node.distance[a] < node.distance[b];
+        });
+        queues.push_back(std::move(q));
+
+        uint32_t threads = uint32_t(uint64_t(budget) * cpusBefore / total) - threadsBefore;
+        threadsBefore += threads;
+        idleNode      |= threads == 0;
+        for (uint32_t i = 0; i < threads; i++) {
+            auto w  = std::make_unique<Worker>();
+            w->node = int(n);
+            w->cpu  = node.cpus[i % node.cpus.size()];
+            workers.push_back(std::move(w));
+        }
+        stats.nodes.push_back({ node.id, threads, queues[n]->end - queues[n]->begin, 0, 0, 0, 0 });
+    }
+
+    quit = false;
+    generation = 0;
+    allowSteal = idleNode;
+    placementChecked = false;
+    for (auto &w : workers)
+        w->thread = std::thread(workerMain, w.get());
+}
+
+void cpuRenderShutdown() {
+    {
+        std::lock_guard<std::mutex> l(poolLock);
+        quit = true;
+    }
+    wake.notify_all();
+    for (auto &w : workers) w->thread.join();
+    workers.clear();
+    queues.clear();
+    if (mapping) {
+#ifdef __linux__
+        munmap(mapping, mappingSize);
+#else
+        std::free(mapping);
+#endif
+    }
+    mapping = nullptr;
+    framebuffer = target = nullptr;
+}
+
+void cpuRenderSetTarget(uint8_t* t) {
+    target = t ? t : framebuffer;
+}
+
+void cpuRenderFrame(const Camera &cam) {
+    auto t0 = std::chrono::steady_clock::now();
+    frameCam = cam;
+    for (auto &q : queues) q->next = q->begin;
+    for (auto &w : workers) w->localTiles = w->stolenTiles = 0;
+    {
+        std::lock_guard<std::mutex> l(poolLock);
+        generation++;
+        running = uint32_t(workers.size());
+    }
+    wake.notify_all();
+    {
+        std::unique_lock<std::mutex> l(poolLock);
+        finished.wait(l, [] { return running == 0; });
+    }
+
+    stats.frameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    stats.tiles = stats.stolenTiles = 0;
+    for (CpuNodeStats &ns : stats.nodes) ns.localTiles = ns.stolenTiles = 0;
+    for (auto &w : workers) {
+        stats.nodes[w->node].localTiles  += w->localTiles;
+        stats.nodes[w->node].stolenTiles += w->stolenTiles;
+        stats.tiles       += w->localTiles + w->stolenTiles;
+        stats.stolenTiles += w->stolenTiles;
+    }
+    // a stolen tile is written by one node into the other's memory
+    stats.remoteBytes = stats.stolenTiles * CPU_TILE_BYTES;
+
+    if (!placementChecked) {
+        checkPlacement();
+        placementChecked = true;
+        allowSteal = true;
+    }
+}
+
+uint8_t* cpuFramebuffer()     { return framebuffer; }
+size_t   cpuFramebufferSize() { return framebufferSize; }
+uint32_t cpuTilesX()          { return tilesX; }
+uint32_t cpuTilesY()          { return tilesY; }
+
+const CpuRenderStats &cpuRenderStats() { return stats; }
+
+void cpuRenderPrintStats(std::ostream &out) {
+    out << "cpu render: " << stats.frameMs << " ms, " << stats.tiles << " tiles, "
+        << stats.stolenTiles << " stolen, " << stats.remoteBytes / 1024 << " KiB cross-node\n";
+    for (const CpuNodeStats &n : stats.nodes) {
+        uint64_t pages = n.localPages + n.remotePages;
+        out << "  node " << n.node << ": " << n.threads << " threads, " << n.ownedTiles
+            << " tiles owned, " << n.localTiles << " rendered + " << n.stolenTiles << " stolen";
+        if (pages)
+            out << ", " << 100.0 * n.localPages / pages << "% of its pages local";
+        out << "\n";
+    }
+}
@@ -0,0 +1,64 @@
+// src/cpurender.h
+//
+// CPU port of comp.glsl's plain raymarch (no cone AA or statistics), on
+// de.h's SIMD distance estimator. The framebuffer is tile-major RGBA8:
+// CPU_TILE x CPU_TILE tiles of exactly one 4 KiB page each, in row-major
+// tile order, so each tile's memory is first-touched by the thread that
+// renders it. Workers are pinned per NUMA node (topology.h), each node
+// owns a band of tiles, and a node that runs out steals from the nearest
+// other node. The first frame after init never steals, so page placement
+// follows tile ownership.
+//
+// The framebuffer can be imported by Vulkan (VK_EXT_external_memory_host):
+// cpuRenderInit aligns its start and size to the import alignment. Or the
+// frame can be rendered straight into other memory of the same layout, such
+// as a mapped staging buffer, with cpuRenderSetTarget.
+#pragma once
+
+#include "camera.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+const uint32_t CPU_TILE       = 32;
+const size_t   CPU_TILE_BYTES = CPU_TILE * CPU_TILE * 4;
+
+struct CpuNodeStats {
+    int      node;
+    uint32_t threads;
+    uint32_t ownedTiles;
+    uint64_t localTiles;    // rendered by this node, last frame
+    uint64_t stolenTiles;   // taken from other nodes' bands, last frame
+    uint64_t localPages;    // owned tiles found in this node's memory (after the first frame)
+    uint64_t remotePages;
+};
+
+struct CpuRenderStats {
+    double   frameMs = 0;
+    uint64_t tiles = 0, stolenTiles = 0;
+    uint64_t remoteBytes = 0;   // framebuffer bytes written across nodes, last frame
+    std::vector<CpuNodeStats> nodes;
+};
+
+// maxThreads 0 = every allowed CPU. alignment (a power of two) applies to
+// the framebuffer's address and size, at least one tile. Re-init to resize.
+void cpuRenderInit(uint32_t width, uint32_t height, uint32_t maxThreads = 0,
+                   size_t alignment = 0);
+void cpuRenderShutdown();
+
+// Frames go to target, cpuFramebufferSize() bytes in the framebuffer's
+// layout, until reset with nullptr or re-init
+void cpuRenderSetTarget(uint8_t* target);
+
+// Blocks until the frame is done
+void cpuRenderFrame(const Camera &cam);
+
+uint8_t* cpuFramebuffer();
+size_t   cpuFramebufferSize();   // tiles * CPU_TILE_BYTES rounded up to the alignment
+uint32_t cpuTilesX();
+uint32_t cpuTilesY();
+
+const CpuRenderStats &cpuRenderStats();
+void cpuRenderPrintStats(std::ostream &out);
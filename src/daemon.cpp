@@ -0,0 +1,314 @@
+// src/daemon.cpp
+#include "daemon.h"
+#include "json.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct Client {
+    int         fd = -1;
+    std::string inbox;       // bytes of an incomplete request line
+    std::string shmName;
+    uint8_t*    slots = nullptr;
+    uint32_t    nextSlot = 0;
+};
+
+int                 listenFd = -1;
+std::string         listenPath;
+size_t              slotSize = 0;
+uint32_t            maxW = 0, maxH = 0;
+std::vector<Client> clients;   // indexed by DaemonRequest::client, fd -1 once gone
+uint32_t            accepted = 0;  // names each client's shared memory
+volatile std::sig_atomic_t stopRequested = 0;
+
+void onSignal(int) { stopRequested = 1; }
+
+// Enough digits that the client reads back the id it sent
+std::string formatNumber(double v) {
+    std::ostringstream s;
+    s << std::setprecision(17) << v;
+    return s.str();
+}
+
+#ifndef _WIN32
+
+// A request field, refused unless the JSON number fits it
+uint32_t wholeNumber(double x, const char* field) {
+    if (!(x >= 0.0 && x <= double(std::numeric_limits<uint32_t>::max())) || x != std::floor(x))
+        throw std::runtime_error(std::string(field) + " must be a whole number");
+    return uint32_t(x);
+}
+
+float finiteNumber(double x, const char* field) {
+    if (!(std::fabs(x) <= double(std::numeric_limits<float>::max())))
+        throw std::runtime_error(std::string(field) + " must be a finite number");
+    return float(x);
+}
+
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int SEND_FLAGS = 0;
+#endif
+
+void dropClient(Client &c) {
+    if (c.fd >= 0) close(c.fd);
+    if (c.slots) munmap(c.slots, DAEMON_SLOTS * slotSize);
+    if (!c.shmName.empty()) shm_unlink(c.shmName.c_str());
+    c = Client{};
+}
+
+void sendLine(Client &c, const std::string &line) {
+    const char* p = line.data();
+    size_t n = line.size();
+    while (n && c.fd >= 0) {
+        ssize_t k = send(c.fd, p, n, SEND_FLAGS);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) { dropClient(c); return; }
+        p += k;
+        n -= size_t(k);
+    }
+}
+
+void sendError(Client &c, double id, const std::string &message) {
+    std::ostringstream s;
+    s << "{\"id\":" << formatNumber(id) << ",\"error\":";
+    jsonWriteString(s, message);
+    s << "}\n";
+    sendLine(c, s.str());
+}
+
+// Entries of clients that went are reused, except those with requests
+// still in `pending`, whose replies must find the client gone
+void acceptClient(const std::vector<DaemonRequest> &pending) {
+    int fd = accept(listenFd, nullptr, nullptr);
+    if (fd < 0) return;
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+    Client c;
+    c.fd      = fd;
+    c.shmName = "/metharizon-" + std::to_string(getpid()) + "-" + std::to_string(accepted++);
+    int shm = shm_open(c.shmName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (shm >= 0 && ftruncate(shm, off_t(DAEMON_SLOTS * slotSize)) == 0) {
+        void* mem = mmap(nullptr, DAEMON_SLOTS * slotSize, PROT_READ | PROT_WRITE, MAP_SHARED, shm, 0);
+        if (mem != MAP_FAILED) c.slots = static_cast<uint8_t*>(mem);
+    }
+    if (shm >= 0) close(shm);
+    size_t index = 0;
+    while (index < clients.size() && (clients[index].fd >= 0 ||
+           std::any_of(pending.begin(), pending.end(),
+                       [&](const DaemonRequest &r) { return r.client == int(index); })))
+        index++;
+    if (index == clients.size()) clients.emplace_back();
+    Client &added = clients[index];
+    added = c;
+    if (!added.slots) {
+        sendError(added, 0, "failed to create shared memory");
+        dropClient(added);
+        return;
+    }
+    std::ostringstream s;
+    s << "{\"shm\":";
+    jsonWriteString(s, added.shmName);
+    s << ",\"slots\":" << DAEMON_SLOTS << ",\"slot_bytes\":" << slotSize
+      << ",\"max_width\":" << maxW << ",\"max_height\":" << maxH << "}\n";
+    sendLine(added, s.str());
+}
+
+// Parse one request line, answering it here if it's malformed
+bool parseRequest(int client, const std::string &line, DaemonRequest &req) {
+    req = DaemonRequest{};
+    req.client = client;
+    try {
+        JsonValue v = jsonParse(line);
+        if (v.type != JsonValue::OBJECT || !v.find("id"))
+            throw std::runtime_error("request needs an id");
+        if (!std::isfinite(v.num("id")))
+            throw std::runtime_error("id must be a finite number");
+        req.id      = v.num("id");
+        req.scene   = v.str("scene");
+        req.width   = wholeNumber(v.num("width", maxW), "width");
+        req.height  = wholeNumber(v.num("height", maxH), "height");
+        req.quality = v.str("quality", req.quality);
+        req.spp     = wholeNumber(v.num("spp", req.spp), "spp");
+        req.bounces = wholeNumber(v.num("bounces", req.bounces), "bounces");
+        req.yaw     = finiteNumber(v.num("yaw"), "yaw");
+        req.pitch   = finiteNumber(v.num("pitch"), "pitch");
+        req.power   = finiteNumber(v.num("power", req.power), "power");
+        if (const JsonValue* pos = v.find("pos")) {
+            if (pos->type != JsonValue::ARRAY || pos->array.size() != 3)
+                throw std::runtime_error("pos needs three numbers");
+            for (int i = 0; i < 3; i++) {
+                if (pos->array[i].type != JsonValue::NUMBER)
+                    throw std::runtime_error("pos needs three numbers");
+                req.pos[i] = finiteNumber(pos->array[i].number, "pos");
+            }
+        }
+        if (req.width < 16 || req.height < 16 || req.width > maxW || req.height > maxH)
+            throw std::runtime_error("size must be 16x16 to " + std::to_string(maxW) + "x" + std::to_string(maxH));
+        if (req.quality != "fast" && req.quality != "aa" && req.quality != "pathtrace")
+            throw std::runtime_error("quality must be fast, aa or pathtrace");
+        if (req.spp < 1 || req.spp > 4096 || req.bounces < 1 || req.bounces > 16)
+            throw std::runtime_error("spp must be 1-4096 and bounces 1-16");
+    } catch (const std::exception &e) {
+        sendError(clients[client], req.id, e.what());
+        return false;
+    }
+    return true;
+}
+
+// Read what the client sent; complete lines become requests
+void readClient(int index, std::vector<DaemonRequest> &out) {
+    Client &c = clients[index];
+    char buf[4096];
+    ssize_t k = recv(c.fd, buf, sizeof(buf), 0);
+    if (k <= 0) {
+        if (k < 0 && errno == EINTR) return;
+        dropClient(c);
+        return;
+    }
+    c.inbox.append(buf, size_t(k));
+    size_t nl;
+    while (c.fd >= 0 && (nl = c.inbox.find('\n')) != std::string::npos) {
+        std::string line = c.inbox.substr(0, nl);
+        c.inbox.erase(0, nl + 1);
+        DaemonRequest req;
+        if (line.find_first_not_of(" \t\r") != std::string::npos && parseRequest(index, line, req))
+            out.push_back(req);
+    }
+    if (c.inbox.size() > 65536) {
+        sendError(c, 0, "request line too long");
+        dropClient(c);
+    }
+}
+
+#endif
+
+} // namespace
+
+#ifdef _WIN32
+
+void daemonOpen(const std::string &, size_t, uint32_t, uint32_t) {
+    throw std::runtime_error("The render daemon needs Unix domain sockets");
+}
+void daemonClose() {}
+bool daemonPoll(float, std::vector<DaemonRequest> &) { return false; }
+uint8_t* daemonResultSlot(const DaemonRequest &, uint32_t &) { return nullptr; }
+bool daemonConnected(const DaemonRequest &) { return false; }
+void daemonReply(const DaemonRequest &, uint32_t, uint32_t, double, bool) {}
+void daemonReplyError(const DaemonRequest &, const std::string &) {}
+
+#else
+
+void daemonOpen(const std::string &socketPath, size_t slotBytes, uint32_t maxWidth, uint32_t maxHeight) {
+    slotSize   = (slotBytes + 4095) & ~size_t(4095);
+    maxW       = maxWidth;
+    maxH       = maxHeight;
+    listenPath = socketPath;
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path))
+        throw std::runtime_error("Socket path too long: " + socketPath);
+    std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) throw std::runtime_error("Failed to create a socket");
+    unlink(socketPath.c_str());
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listenFd, 64) != 0)
+        throw std::runtime_error("Failed to listen on " + socketPath);
+
+    // no SA_RESTART: poll must return so the daemon can clean up
+    struct sigaction sa{};
+    sa.sa_handler = onSignal;
+    sigaction(SIGINT,  &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+}
+
+void daemonClose() {
+    for (Client &c : clients)
+        if (c.fd >= 0) dropClient(c);
+    clients.clear();
+    if (listenFd >= 0) {
+        close(listenFd);
+        unlink(listenPath.c_str());
+    }
+    listenFd = -1;
+}
+
+bool daemonPoll(float windowMs, std::vector<DaemonRequest> &out) {
+    out.clear();
+    auto deadline = std::chrono::steady_clock::time_point::max();
+    while (!stopRequested) {
+        int timeout = -1;
+        if (!out.empty()) {
+            auto now = std::chrono::steady_clock::now();
+            if (deadline == std::chrono::steady_clock::time_point::max())
+                deadline = now + std::chrono::microseconds(int64_t(windowMs * 1000.f));
+            if (now >= deadline) break;
+            timeout = int(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count());
+        }
+        std::vector<pollfd> fds{ { listenFd, POLLIN, 0 } };
+        std::vector<int>    index{ -1 };
+        for (size_t i = 0; i < clients.size(); i++) {
+            if (clients[i].fd < 0) continue;
+            fds.push_back({ clients[i].fd, POLLIN, 0 });
+            index.push_back(int(i));
+        }
+        int n = poll(fds.data(), fds.size(), timeout);
+        if (n < 0 && errno != EINTR) throw std::runtime_error("poll failed");
+        if (n <= 0) continue;
+        for (size_t i = 1; i < fds.size(); i++)
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+                readClient(index[i], out);
+        if (fds[0].revents & POLLIN)
+            acceptClient(out);
+    }
+    return !stopRequested;
+}
+
+uint8_t* daemonResultSlot(const DaemonRequest &req, uint32_t &slot) {
+    Client &c = clients[req.client];
+    if (c.fd < 0) return nullptr;
+    slot = c.nextSlot;
+    c.nextSlot = (c.nextSlot + 1) % DAEMON_SLOTS;
+    return c.slots + slot * slotSize;
+}
+
+bool daemonConnected(const DaemonRequest &req) {
+    return clients[req.client].fd >= 0;
+}
+
+void daemonReply(const DaemonRequest &req, uint32_t slot, uint32_t batch, double ms, bool cached) {
+    Client &c = clients[req.client];
+    std::ostringstream s;
+    s << "{\"id\":" << formatNumber(req.id) << ",\"slot\":" << slot << ",\"offset\":" << slot * slotSize
+      << ",\"width\":" << req.width << ",\"height\":" << req.height
+      << ",\"batch\":" << batch << ",\"ms\":" << ms << (cached ? ",\"cached\":true}\n" : "}\n");
+    sendLine(c, s.str());
+}
+
+void daemonReplyError(const DaemonRequest &req, const std::string &message) {
+    sendError(clients[req.client], req.id, message);
+}
+
+#endif
@@ -0,0 +1,61 @@
+// src/daemon.h
+//
+// Render daemon transport (Metharizon --serve SOCKET). Clients connect to a
+// Unix domain socket and are greeted with one JSON line naming a POSIX
+// shared memory object of DAEMON_SLOTS result slots:
+//
+//   {"shm":"/metharizon-123-1","slots":8,"slot_bytes":8294400,
+//    "max_width":1920,"max_height":1080}
+//
+// Requests are JSON lines; everything but "id" is optional:
+//
+//   {"id":7,"scene":"overview"}
+//   {"id":8,"pos":[0,0,2.5],"yaw":0.3,"pitch":0,"width":256,"height":256,
+//    "quality":"pathtrace","spp":16,"bounces":4,"power":8}
+//
+// quality is "fast" (raymarch), "aa" (raymarch with cone AA) or "pathtrace".
+// Each is answered with a line giving the slot holding the RGBA8 pixels,
+// tightly packed, or an error:
+//
+//   {"id":7,"slot":3,"offset":24883200,"width":1920,"height":1080,"batch":4,"ms":2.1}
+//   {"id":8,"slot":4,"offset":33177600,"width":1920,"height":1080,"batch":0,"ms":0.4,"cached":true}
+//   {"id":9,"error":"unknown scene"}
+//
+// Slots are used in turn, so a result stays readable until the client has
+// had DAEMON_SLOTS - 1 more answers: keep fewer requests than that in flight.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+const uint32_t DAEMON_SLOTS = 8;
+
+struct DaemonRequest {
+    int         client = -1;
+    double      id = 0;
+    std::string scene;                        // empty = pos, yaw, pitch
+    float       pos[3] = { 0.f, 0.f, 3.f };
+    float       yaw = 0.f, pitch = 0.f;
+    uint32_t    width = 0, height = 0;        // 0 = the daemon's --size
+    std::string quality = "fast";
+    uint32_t    spp = 16, bounces = 4;        // pathtrace only
+    float       power = 8.f;
+};
+
+// Listen on socketPath with result slots of slotBytes. Throws on errors.
+void daemonOpen(const std::string &socketPath, size_t slotBytes, uint32_t maxWidth, uint32_t maxHeight);
+void daemonClose();
+
+// Block until requests arrive, then keep collecting for windowMs so that
+// concurrent clients share a batch. False once SIGINT or SIGTERM arrived.
+// Malformed requests are answered here and not returned.
+bool daemonPoll(float windowMs, std::vector<DaemonRequest> &out);
+
+// Next result slot of the request's client, nullptr if it has gone. The
+// slots are unmapped when the client goes, which any reply may discover.
+uint8_t* daemonResultSlot(const DaemonRequest &req, uint32_t &slot);
+bool     daemonConnected(const DaemonRequest &req);
+void     daemonReply(const DaemonRequest &req, uint32_t slot, uint32_t batch, double ms, bool cached = false);
+void     daemonReplyError(const DaemonRequest &req, const std::string &message);
@@ -0,0 +1,109 @@
+// src/de.h
+//
+// CPU kernels for the Mandelbulb distance estimator, for the benchmarks and
+// CPU-side work, all instantiated from de_source.h. mandelbulbTrig is the
+// source the shader's de.glsl is generated from: the scalar form on libm
+// runs the shader's operations in its order, the lane form runs them on
+// vmath.h. Both take the power and iteration count as template arguments.
+// mandelbulbAlgebraic is the transcendental-free power-8 source the CPU
+// renderer marches.
+#pragma once
+
+#include "de_source.h"
+#include "simd.h"
+#include "vmath.h"
+
+#include <algorithm>
+#include <cmath>
+
+struct Vec3 {
+    float x, y, z;
+};
+
+inline Vec3  operator+(Vec3 a, Vec3 b)  { return { a.x+b.x, a.y+b.y, a.z+b.z }; }
+inline Vec3  operator-(Vec3 a, Vec3 b)  { return { a.x-b.x, a.y-b.y, a.z-b.z }; }
+inline Vec3  operator*(Vec3 a, float s) { return { a.x*s, a.y*s, a.z*s }; }
+inline float dot(Vec3 a, Vec3 b)        { return a.x*b.x + a.y*b.y + a.z*b.z; }
+inline float length(Vec3 a)             { return std::sqrt(dot(a, a)); }
+inline Vec3  normalize(Vec3 a)          { return a * (1.f / length(a)); }
+
+// de_source.h ops: one float on libm, and N lanes on vmath.h
+struct ScalarOps {
+    using F = float;
+    using M = bool;
+    static F    lit(float x)                  { return x; }
+    static F    sqrt(F x)                     { return std::sqrt(x); }
+    static F    max(F x, F y)                 { return std::max(x, y); }
+    static F    acos(F x)                     { return std::acos(x); }
+    static F    atan2(F y, F x)               { return std::atan2(y, x); }
+    static F    pow(F x, F y)                 { return std::pow(x, y); }
+    static F    log(F x)                      { return std::log(x); }
+    static void sincos(F x, F &s, F &c)       { s = std::sin(x); c = std::cos(x); }
+    static M    always()                      { return true; }
+    static M    andNotAbove(M m, F x, float b) { return m && !(x > b); }
+    static F    select(M m, F a, F b)         { return m ? a : b; }
+    static bool any(M m)                      { return m; }
+};
+
+template<int N> struct SimdOps {
+    using F = vfloat<N>;
+    using M = vmask<N>;
+    static F    lit(float x)                  { return splat<N>(x); }
+    static F    sqrt(F x)                     { return vsqrt<N>(x); }
+    static F    max(F x, F y)                 { return vmax<N>(x, y); }
+    static F    acos(F x)                     { return vacos<N>(x); }
+    static F    atan2(F y, F x)               { return vatan2<N>(y, x); }
+    static F    pow(F x, F y)                 { return vpow<N>(x, y); }
+    static F    log(F x)                      { return vlog<N>(x); }
+    static void sincos(F x, F &s, F &c)       { vsincos<N>(x, s, c); }
+    static M    always()                      { return splat<N>(0.f) == splat<N>(0.f); }
+    static M    andNotAbove(M m, F x, float b) { return m & ~(x > b); }
+    static F    select(M m, F a, F b)         { return ::select<N>(m, a, b); }
+    static bool any(M m)                      { return ::any<N>(m); }
+};
+
+// The power need not be an integer; the shader's is 8
+template<class P = DePower<8>, int ITERS = DE_ITER> inline float mandelbulbTrig(Vec3 p) {
+    return mandelbulbDE<MandelbulbSource<ScalarOps, P>, ITERS>(p.x, p.y, p.z);
+}
+
+template<int ITERS = DE_ITER> inline float mandelbulbAlgebraic(Vec3 p) {
+    return mandelbulbDE<MandelbulbAlgebraicSource<ScalarOps>, ITERS>(p.x, p.y, p.z);
+}
+
+// N points at once
+template<int N, int ITERS = DE_ITER>
+inline vfloat<N> mandelbulbAlgebraic(vfloat<N> px, vfloat<N> py, vfloat<N> pz) {
+    return mandelbulbDE<MandelbulbAlgebraicSource<SimdOps<N>>, ITERS>(px, py, pz);
+}
+
+// The trig form at N lanes on vmath.h
+template<int N, class P = DePower<8>, int ITERS = DE_ITER>
+inline vfloat<N> mandelbulbTrig(vfloat<N> px, vfloat<N> py, vfloat<N> pz) {
+    return mandelbulbDE<MandelbulbSource<SimdOps<N>, P>, ITERS>(px, py, pz);
+}
+
+// Normal estimators over any scalar DE. normalCentral is the shader's
+// getNormal (6 evaluations); tetrahedral and forward differences need 4.
+template<class DE> inline Vec3 normalCentral(Vec3 p, DE de, float e = 0.0005f) {
+    return normalize(Vec3{
+        de(p + Vec3{e,0,0}) - de(p - Vec3{e,0,0}),
+        de(p + Vec3{0,e,0}) - de(p - Vec3{0,e,0}),
+        de(p + Vec3{0,0,e}) - de(p - Vec3{0,0,e}) });
+}
+
+template<class DE> inline Vec3 normalTetrahedral(Vec3 p, DE de, float e = 0.0005f) {
+    const Vec3 k[4] = { {1,-1,-1}, {-1,-1,1}, {-1,1,-1}, {1,1,1} };
+    Vec3 n{0,0,0};
+    for (const Vec3 &kk : k)
+        n = n + kk * de(p + kk * e);
+    return normalize(n);
+}
+
+template<class DE> inline Vec3 normalForward(Vec3 p, DE de, float e = 0.0005f) {
+    float d0 = de(p);
+    return normalize(Vec3{
+        de(p + Vec3{e,0,0}) - d0,
+        de(p + Vec3{0,e,0}) - d0,
+        de(p + Vec3{0,0,e}) - d0 });
+}
@@ -0,0 +1,126 @@
+// src/de_source.h
+//
+// The Mandelbulb distance estimator, written once. The GPU kernel
+// (shaders/include/de.glsl, generated by MetharizonDeGen from this file)
+// and the CPU kernels in de.h are instantiations of the same templates,
+// so a change here reaches both.
+//
+// The code is templated on an ops type O that supplies the value type
+// O::F and the operations. It stays inside a subset every backend can
+// express: straight-line arithmetic on O::F with + - * /, constants only
+// through O::lit, and the functions sqrt, max, acos, atan2, pow, sincos
+// and log. No branches on values and no float literals mixed into
+// expressions; the GLSL ops record each operation as a statement and
+// don't compile anything else. The bailout loop around step() is the one
+// piece of control flow; mandelbulbDE spells it with masks so it serves
+// scalars and lanes alike, and the generator emits the same loop in GLSL.
+//
+// A source supplies Ops, radius, step and distance. MandelbulbSource is
+// the shader's trig form; MandelbulbAlgebraicSource is the CPU renderer's.
+#pragma once
+
+const int DE_ITER = 8;
+
+// The power as a compile-time rational, e.g. DePower<15, 2> for 7.5
+template<int NUM, int DEN = 1> struct DePower {
+    static constexpr float value = float(NUM) / float(DEN);
+};
+
+template<class O, class P> struct MandelbulbSource {
+    using Ops = O;
+    using F   = typename O::F;
+
+    static constexpr float BAILOUT = 2.f;
+
+    static F radius(F zx, F zy, F zz) {
+        return O::sqrt(zx*zx + zy*zy + zz*zz);
+    }
+
+    // z -> z^P + p in spherical form, with r = |z| and the running
+    // derivative dr
+    static void step(F px, F py, F pz, F r, F &zx, F &zy, F &zz, F &dr) {
+        F power = O::lit(P::value);
+        F theta = O::acos(zz / r) * power;
+        F phi   = O::atan2(zy, zx) * power;
+        F rp1   = O::pow(r, O::lit(P::value - 1.f));
+        F st, ct, sp, cp;
+        O::sincos(theta, st, ct);
+        O::sincos(phi, sp, cp);
+        F zr = rp1 * r;
+        dr = rp1 * power * dr + O::lit(1.f);
+        zx = st*cp*zr + px;
+        zy = sp*st*zr + py;
+        zz = ct*zr + pz;
+    }
+
+    static F distance(F r, F dr) {
+        return O::lit(0.5f) * O::log(r) * r / dr;
+    }
+};
+
+// The power-8 map without transcendentals inside the loop: with cos/sin
+// theta and cos/sin phi read off the point, the 8x angles are eighth
+// powers of unit complex numbers, i.e. three complex squarings each
+template<class O> struct MandelbulbAlgebraicSource {
+    using Ops = O;
+    using F   = typename O::F;
+
+    static constexpr float BAILOUT = 2.f;
+
+    static F radius(F zx, F zy, F zz) {
+        return O::sqrt(zx*zx + zy*zy + zz*zz);
+    }
+
+    // (re + i im)^8 in place
+    static void pow8(F &re, F &im) {
+        for (int k = 0; k < 3; k++) {
+            F t = re*re - im*im;
+            im  = O::lit(2.f)*re*im;
+            re  = t;
+        }
+    }
+
+    static void step(F px, F py, F pz, F r, F &zx, F &zy, F &zz, F &dr) {
+        F tiny   = O::lit(1e-30f);
+        F rho    = O::sqrt(zx*zx + zy*zy);
+        F invR   = O::lit(1.f) / O::max(r, tiny);
+        F invRho = O::lit(1.f) / O::max(rho, tiny);
+        F ct = zz*invR, st = rho*invR;    // theta
+        F cp = zx*invRho, sp = zy*invRho; // phi
+        pow8(ct, st);
+        pow8(cp, sp);
+        F r2 = r*r, r4 = r2*r2, r8 = r4*r4;
+        dr = r8*invR*O::lit(8.f)*dr + O::lit(1.f);
+        zx = st*cp*r8 + px;
+        zy = sp*st*r8 + py;
+        zz = ct*r8 + pz;
+    }
+
+    static F distance(F r, F dr) {
+        return O::lit(0.5f) * O::log(r) * r / dr;
+    }
+};
+
+// ITERS iterations of source S or until |z| passes the bailout. Lanes
+// that escape keep their r and dr, which for one lane is the shader's break.
+template<class S, int ITERS = DE_ITER>
+typename S::F mandelbulbDE(typename S::F px, typename S::F py, typename S::F pz) {
+    using O = typename S::Ops;
+    using F = typename S::F;
+    F zx = px, zy = py, zz = pz;
+    F dr = O::lit(1.f), r = O::lit(0.f);
+    typename O::M live = O::always();
+    for (int i = 0; i < ITERS; i++) {
+        F rNew = S::radius(zx, zy, zz);
+        r    = O::select(live, rNew, r);
+        live = O::andNotAbove(live, rNew, S::BAILOUT);
+        if (!O::any(live)) break;
+        F nx = zx, ny = zy, nz = zz, ndr = dr;
+        S::step(px, py, pz, rNew, nx, ny, nz, ndr);
+        zx = O::select(live, nx, zx);
+        zy = O::select(live, ny, zy);
+        zz = O::select(live, nz, zz);
+        dr = O::select(live, ndr, dr);
+    }
+    return S::distance(r, dr);
+}
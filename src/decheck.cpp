@@ -0,0 +1,98 @@
+// src/decheck.cpp
+//
+// MetharizonBench --de-check: evaluates the generated shader DE (replayed
+// on the CPU, see degen.h) and the CPU kernels at the same points in the
+// bulb's bounding cube, and fails if they disagree by more than libm
+// against vmath.h accounts for. Near the set's boundary a last-ulp
+// difference can move the escape by an iteration, so the bulk of the
+// points is held to a tight bound and only the worst one to a loose one.
+#include "bench.h"
+#include "de.h"
+#include "degen.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+const int    SAMPLES     = 1 << 18;
+const double TAIL_BOUND  = 1e-3;   // at the 99.9th percentile
+const double WORST_BOUND = 0.1;
+
+struct Points {
+    std::vector<float> x, y, z;
+};
+
+template<int N, class Kernel>
+void evalAll(const Points &p, std::vector<float> &out, Kernel kernel) {
+    for (size_t i = 0; i + N <= p.x.size(); i += N)
+        vstore<N>(&out[i], kernel(vload<N>(&p.x[i]), vload<N>(&p.y[i]), vload<N>(&p.z[i])));
+}
+
+// Relative to the shader's distance, absolute below 1e-3
+double error(float got, float want) {
+    if (std::isnan(want) || std::isnan(got)) return std::isnan(want) == std::isnan(got) ? 0.0 : INFINITY;
+    return std::fabs(double(got) - double(want)) / std::max(std::fabs(double(want)), 1e-3);
+}
+
+// Returns 1 if a bound is exceeded
+int report(const char* name, int lanes, const Points &p, const std::vector<float> &want,
+           const std::vector<float> &got) {
+    std::vector<double> e(want.size());
+    for (size_t i = 0; i < want.size(); i++)
+        e[i] = error(got[i], want[i]);
+    size_t at = size_t(std::max_element(e.begin(), e.end()) - e.begin());
+    double worst = e[at];
+    std::vector<double> sorted = e;
+    std::sort(sorted.begin(), sorted.end());
+    double median = sorted[sorted.size() / 2], tail = sorted[sorted.size() * 999 / 1000];
+    bool ok = tail <= TAIL_BOUND && worst <= WORST_BOUND;
+    std::cout << std::left << std::setw(12) << name << std::right << std::setw(7) << lanes
+              << std::setprecision(3) << std::setw(12) << median << std::setw(12) << tail
+              << std::setw(12) << worst << "  " << std::setprecision(9)
+              << p.x[at] << ", " << p.y[at] << ", " << p.z[at] << (ok ? "" : "  FAIL") << "\n";
+    return ok ? 0 : 1;
+}
+
+template<int N> int checkWidth(const Points &p, const std::vector<float> &want) {
+    std::vector<float> got(want.size());
+    evalAll<N>(p, got, [](vfloat<N> x, vfloat<N> y, vfloat<N> z) { return mandelbulbTrig<N>(x, y, z); });
+    int failures = report("trig/vmath", N, p, want, got);
+    evalAll<N>(p, got, [](vfloat<N> x, vfloat<N> y, vfloat<N> z) { return mandelbulbAlgebraic<N>(x, y, z); });
+    return failures + report("alg/simd", N, p, want, got);
+}
+
+} // namespace
+
+int runDeCheck() {
+    Points p;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> u(-1.5f, 1.5f);
+    std::vector<float> want(SAMPLES), got(SAMPLES);
+    for (int i = 0; i < SAMPLES; i++) {
+        p.x.push_back(u(rng));
+        p.y.push_back(u(rng));
+        p.z.push_back(u(rng));
+        want[i] = deEvalGenerated(p.x[i], p.y[i], p.z[i], DE_ITER);
+    }
+
+    std::cout << std::left << std::setw(12) << "kernel" << std::right << std::setw(7) << "lanes"
+              << std::setw(12) << "median" << std::setw(12) << "99.9%" << std::setw(12) << "worst"
+              << "  worst input\n";
+    for (int i = 0; i < SAMPLES; i++)
+        got[i] = mandelbulbTrig(Vec3{ p.x[i], p.y[i], p.z[i] });
+    int failures = report("trig/libm", 1, p, want, got);
+    for (int i = 0; i < SAMPLES; i++)
+        got[i] = mandelbulbAlgebraic(Vec3{ p.x[i], p.y[i], p.z[i] });
+    failures += report("alg/scalar", 1, p, want, got);
+
+    failures += checkWidth<1>(p, want);
+    if (SIMD_LANES == 16)     failures += checkWidth<16>(p, want);
+    else if (SIMD_LANES == 8) failures += checkWidth<8>(p, want);
+    else                      failures += checkWidth<4>(p, want);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,251 @@
+// src/degen.cpp
+#include "degen.h"
+#include "de_source.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+enum Op { INPUT, CONST, ADD, SUB, MUL, DIV, SQRT, MAX, ACOS, ATAN2, POW, SIN, COS, LOG };
+
+// One recorded operation; a and b index earlier nodes
+struct Node {
+    Op          op;
+    int         a = -1, b = -1;
+    float       value = 0.f;     // CONST
+    std::string name;            // INPUT: the GLSL it reads
+    int         temp = -1;       // the rest: n of its tn in the shader
+};
+
+std::vector<Node> nodes;
+
+int record(Op op, int a = -1, int b = -1) {
+    Node n;
+    n.op = op;
+    n.a  = a;
+    n.b  = b;
+    nodes.push_back(n);
+    return int(nodes.size()) - 1;
+}
+
+// Ops for de_source.h that record instead of compute
+struct GlslOps {
+    struct F {
+        int id = -1;
+    };
+    static F input(const char* name) {
+        Node n;
+        n.op   = INPUT;
+        n.name = name;
+        nodes.push_back(n);
+        return { int(nodes.size()) - 1 };
+    }
+    static F lit(float x) {
+        F f{ record(CONST) };
+        nodes[f.id].value = x;
+        return f;
+    }
+    static F    sqrt(F x)               { return { record(SQRT, x.id) }; }
+    static F    max(F x, F y)           { return { record(MAX, x.id, y.id) }; }
+    static F    acos(F x)               { return { record(ACOS, x.id) }; }
+    static F    atan2(F y, F x)         { return { record(ATAN2, y.id, x.id) }; }
+    static F    pow(F x, F y)           { return { record(POW, x.id, y.id) }; }
+    static F    log(F x)                { return { record(LOG, x.id) }; }
+    static void sincos(F x, F &s, F &c) { s = { record(SIN, x.id) }; c = { record(COS, x.id) }; }
+};
+
+inline GlslOps::F operator+(GlslOps::F a, GlslOps::F b) { return { record(ADD, a.id, b.id) }; }
+inline GlslOps::F operator-(GlslOps::F a, GlslOps::F b) { return { record(SUB, a.id, b.id) }; }
+inline GlslOps::F operator*(GlslOps::F a, GlslOps::F b) { return { record(MUL, a.id, b.id) }; }
+inline GlslOps::F operator/(GlslOps::F a, GlslOps::F b) { return { record(DIV, a.id, b.id) }; }
+
+using Source = MandelbulbSource<GlslOps, DePower<8>>;
+
+// Nodes reaching `id` not yet in `order`, operands left to right first.
+// Walking from the outputs rather than in recording order keeps the
+// shader independent of the compiler's operand evaluation order.
+void schedule(int id, std::vector<int> &order, std::vector<bool> &done) {
+    if (id < 0 || done[id]) return;
+    schedule(nodes[id].a, order, done);
+    schedule(nodes[id].b, order, done);
+    done[id] = true;
+    order.push_back(id);
+}
+
+// The recording, in the three straight-line pieces of the loop
+struct Kernel {
+    std::vector<int> pieces[3];  // radius, step, distance: nodes in statement order
+    int radius;
+    int zx, zy, zz, dr;          // step outputs
+    int distance;
+};
+
+const Kernel &kernel() {
+    static Kernel k = [] {
+        Kernel k;
+        nodes.clear();
+        k.radius = Source::radius(GlslOps::input("z.x"), GlslOps::input("z.y"), GlslOps::input("z.z")).id;
+
+        GlslOps::F zx = GlslOps::input("z.x"), zy = GlslOps::input("z.y"), zz = GlslOps::input("z.z");
+        GlslOps::F dr = GlslOps::input("dr");
+        Source::step(GlslOps::input("p.x"), GlslOps::input("p.y"), GlslOps::input("p.z"),
+                     GlslOps::input("r"), zx, zy, zz, dr);
+        k.zx = zx.id;
+        k.zy = zy.id;
+        k.zz = zz.id;
+        k.dr = dr.id;
+
+        k.distance = Source::distance(GlslOps::input("r"), GlslOps::input("dr")).id;
+
+        std::vector<bool> done(nodes.size());
+        schedule(k.radius, k.pieces[0], done);
+        for (int out : { k.zx, k.zy, k.zz, k.dr })
+            schedule(out, k.pieces[1], done);
+        schedule(k.distance, k.pieces[2], done);
+
+        int temps = 0;
+        for (const std::vector<int> &piece : k.pieces)
+            for (int i : piece)
+                if (nodes[i].op != INPUT && nodes[i].op != CONST) nodes[i].temp = temps++;
+        return k;
+    }();
+    return k;
+}
+
+std::string literal(float x) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.9g", x);
+    std::string s = buf;
+    if (s.find_first_of(".en") == std::string::npos) s += ".0";
+    return s;
+}
+
+// How node i is read: inputs and constants inline, the rest by name
+std::string ref(int i) {
+    const Node &n = nodes[i];
+    if (n.op == INPUT) return n.name;
+    if (n.op == CONST) return literal(n.value);
+    return "t" + std::to_string(n.temp);
+}
+
+std::string expression(const Node &n) {
+    static const char* infix[]   = { "", "", " + ", " - ", " * ", " / " };
+    static const char* call[]    = { "", "", "", "", "", "", "sqrt", "max", "acos", "atan", "pow", "sin", "cos", "log" };
+    if (n.op >= ADD && n.op <= DIV) return ref(n.a) + infix[n.op] + ref(n.b);
+    if (n.b >= 0) return std::string(call[n.op]) + "(" + ref(n.a) + ", " + ref(n.b) + ")";
+    return std::string(call[n.op]) + "(" + ref(n.a) + ")";
+}
+
+void emitPiece(std::ostream &out, const std::vector<int> &piece, const char* indent) {
+    for (int i : piece)
+        if (nodes[i].op != INPUT && nodes[i].op != CONST)
+            out << indent << "float " << ref(i) << " = " << expression(nodes[i]) << ";\n";
+}
+
+// The shader's variables, as inputs read them
+struct Vars {
+    float p[3], z[3], r, dr;
+
+    float read(const std::string &name) const {
+        if (name == "p.x") return p[0];
+        if (name == "p.y") return p[1];
+        if (name == "p.z") return p[2];
+        if (name == "z.x") return z[0];
+        if (name == "z.y") return z[1];
+        if (name == "z.z") return z[2];
+        return name == "r" ? r : dr;
+    }
+};
+
+// Run a piece's statements into v, indexed by node
+void evalPiece(std::vector<float> &v, const std::vector<int> &piece, const Vars &vars) {
+    for (int i : piece) {
+        const Node &n = nodes[i];
+        float a = n.a >= 0 ? v[n.a] : 0.f, b = n.b >= 0 ? v[n.b] : 0.f;
+        switch (n.op) {
+        case INPUT: v[i] = vars.read(n.name); break;
+        case CONST: v[i] = n.value; break;
+        case ADD:   v[i] = a + b; break;
+        case SUB:   v[i] = a - b; break;
+        case MUL:   v[i] = a * b; break;
+        case DIV:   v[i] = a / b; break;
+        case SQRT:  v[i] = std::sqrt(a); break;
+        case MAX:   v[i] = std::max(a, b); break;
+        case ACOS:  v[i] = std::acos(a); break;
+        case ATAN2: v[i] = std::atan2(a, b); break;
+        case POW:   v[i] = std::pow(a, b); break;
+        case SIN:   v[i] = std::sin(a); break;
+        case COS:   v[i] = std::cos(a); break;
+        case LOG:   v[i] = std::log(a); break;
+        }
+    }
+}
+
+} // namespace
+
+std::string deGenerateGlsl() {
+    const Kernel &k = kernel();
+    std::ostringstream s;
+    s << "// Mandelbulb distance estimator shared by every raymarching kernel.\n"
+         "// Generated from src/de_source.h by MetharizonDeGen: edit that, not this.\n"
+         "#ifndef DE_GLSL\n"
+         "#define DE_GLSL\n"
+         "\n"
+         "const int DE_ITER = " << DE_ITER << ";\n"
+         "\n"
+         "// power-" << DePower<8>::value << " Mandelbulb, with a caller-chosen iteration budget\n"
+         "float mandelbulbN(vec3 p, int iters) {\n"
+         "    vec3  z  = p;\n"
+         "    float dr = 1.0;\n"
+         "    float r  = 0.0;\n"
+         "    for(int i=0;i<iters;i++){\n";
+    emitPiece(s, k.pieces[0], "        ");
+    s << "        r = " << ref(k.radius) << ";\n"
+         "        if(r>" << literal(Source::BAILOUT) << ") break;\n";
+    emitPiece(s, k.pieces[1], "        ");
+    s << "        z  = vec3(" << ref(k.zx) << ", " << ref(k.zy) << ", " << ref(k.zz) << ");\n"
+         "        dr = " << ref(k.dr) << ";\n"
+         "    }\n";
+    emitPiece(s, k.pieces[2], "    ");
+    s << "    return " << ref(k.distance) << ";\n"
+         "}\n"
+         "\n"
+         "float mandelbulb(vec3 p) {\n"
+         "    return mandelbulbN(p, DE_ITER);\n"
+         "}\n"
+         "\n"
+         "// estimate normal\n"
+         "vec3 getNormal(vec3 p) {\n"
+         "    float e = 0.0005;\n"
+         "    return normalize(vec3(\n"
+         "        mandelbulb(p+vec3(e,0,0)) - mandelbulb(p-vec3(e,0,0)),\n"
+         "        mandelbulb(p+vec3(0,e,0)) - mandelbulb(p-vec3(0,e,0)),\n"
+         "        mandelbulb(p+vec3(0,0,e)) - mandelbulb(p-vec3(0,0,e))\n"
+         "    ));\n"
+         "}\n"
+         "\n"
+         "#endif\n";
+    return s.str();
+}
+
+float deEvalGenerated(float x, float y, float z, int iters) {
+    const Kernel &k = kernel();
+    std::vector<float> v(nodes.size());
+    Vars vars = { { x, y, z }, { x, y, z }, 0.f, 1.f };
+    for (int i = 0; i < iters; i++) {
+        evalPiece(v, k.pieces[0], vars);
+        vars.r = v[k.radius];
+        if (vars.r > Source::BAILOUT) break;
+        evalPiece(v, k.pieces[1], vars);
+        vars.z[0] = v[k.zx];
+        vars.z[1] = v[k.zy];
+        vars.z[2] = v[k.zz];
+        vars.dr   = v[k.dr];
+    }
+    evalPiece(v, k.pieces[2], vars);
+    return v[k.distance];
+}
@@ -0,0 +1,18 @@
+// src/degen.h
+//
+// GLSL backend of de_source.h. The source is run once with ops that
+// record every operation instead of computing it; the recording becomes
+// the body of mandelbulbN in shaders/include/de.glsl, one statement per
+// operation. MetharizonDeGen writes the file at build time, and
+// MetharizonBench --de-check replays the same recording on the CPU to
+// hold it against the CPU kernels.
+#pragma once
+
+#include <string>
+
+// The text of shaders/include/de.glsl
+std::string deGenerateGlsl();
+
+// mandelbulbN of the generated shader, statement for statement, with
+// libm standing in for the GPU's built-ins
+float deEvalGenerated(float x, float y, float z, int iters);
@@ -0,0 +1,23 @@
+// src/degen_main.cpp
+//
+// MetharizonDeGen OUT.glsl: writes the GLSL distance estimator generated
+// from de_source.h (see degen.h). The build runs it before glslc.
+#include "degen.h"
+
+#include <fstream>
+#include <iostream>
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cerr << "usage: " << argv[0] << " OUT.glsl\n";
+        return 2;
+    }
+    std::ofstream out(argv[1], std::ios::binary);
+    out << deGenerateGlsl();
+    out.close();
+    if (!out) {
+        std::cerr << "Failed to write " << argv[1] << "\n";
+        return 1;
+    }
+    return 0;
+}
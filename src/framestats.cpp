@@ -0,0 +1,154 @@
+// src/framestats.cpp
+#include "framestats.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <ostream>
+#include <stdexcept>
+
+namespace {
+
+const uint64_t SUB_COUNT = 1u << LatencyHistogram::SUB_BITS;
+const double   QUANTILES[] = { 0.5, 0.9, 0.99, 0.999 };
+const char*    QUANTILE_NAMES[] = { "p50", "p90", "p99", "p99.9" };
+
+LatencyHistogram cpuInterval, gpuInterval, cpuTotal, gpuTotal;
+
+int msb(uint64_t v) {
+    int n = 0;
+    while (v >>= 1) n++;
+    return n;
+}
+
+// Values below SUB_COUNT have a bucket each; above, the top SUB_BITS+1
+// bits select the bucket and the rest is dropped
+size_t bucketOf(uint64_t us) {
+    if (us < SUB_COUNT) return us;
+    int shift = msb(us) - LatencyHistogram::SUB_BITS;
+    return (shift + 1) * SUB_COUNT + ((us >> shift) & (SUB_COUNT - 1));
+}
+
+uint64_t bucketLow(size_t b) {
+    if (b < SUB_COUNT) return b;
+    int shift = int(b / SUB_COUNT) - 1;
+    return (SUB_COUNT + b % SUB_COUNT) << shift;
+}
+
+uint64_t bucketHigh(size_t b) {
+    return bucketLow(b + 1) - 1;
+}
+
+void writeSummary(std::ostream &out, const LatencyHistogram &h) {
+    out << "{\"count\":" << h.count << ",\"mean\":" << h.meanMs();
+    for (int i = 0; i < 4; i++)
+        out << ",\"" << QUANTILE_NAMES[i] << "\":" << h.percentile(QUANTILES[i]);
+    out << ",\"max\":" << h.maxMs() << ",\"buckets_us\":[";
+    bool sep = false;
+    for (size_t b = 0; b < h.counts.size(); b++) {
+        if (!h.counts[b]) continue;
+        out << (sep ? "," : "") << "[" << bucketLow(b) << "," << bucketHigh(b) << ","
+            << h.counts[b] << "]";
+        sep = true;
+    }
+    out << "]}";
+}
+
+void writeMetric(std::ostream &out, const char* name, const LatencyHistogram &interval,
+                 const LatencyHistogram &total) {
+    out << "# TYPE " << name << " summary\n";
+    for (int i = 0; i < 4; i++)
+        out << name << "{quantile=\"" << QUANTILES[i] << "\"} " << interval.percentile(QUANTILES[i]) << "\n";
+    out << name << "_max " << interval.maxMs() << "\n";
+    out << name << "_sum " << total.sumMs << "\n";
+    out << name << "_count " << total.count << "\n";
+}
+
+} // namespace
+
+void LatencyHistogram::record(double ms) {
+    uint64_t us = ms > 0.0 ? uint64_t(ms * 1000.0 + 0.5) : 0;
+    counts[std::min(bucketOf(us), counts.size() - 1)]++;
+    count++;
+    maxUs = std::max(maxUs, us);
+    sumMs += ms;
+}
+
+double LatencyHistogram::percentile(double q) const {
+    if (!count) return 0.0;
+    uint64_t want = uint64_t(q * count + 0.5), seen = 0;
+    want = std::max<uint64_t>(want, 1);
+    for (size_t b = 0; b < counts.size(); b++) {
+        seen += counts[b];
+        if (seen >= want)
+            return std::min(bucketHigh(b), maxUs) / 1000.0;
+    }
+    return maxMs();
+}
+
+void LatencyHistogram::reset() {
+    std::fill(counts.begin(), counts.end(), 0);
+    count = 0;
+    maxUs = 0;
+    sumMs = 0.0;
+}
+
+void frameStatsRecord(double cpuMs, double gpuMs) {
+    cpuInterval.record(cpuMs);
+    cpuTotal.record(cpuMs);
+    if (gpuMs >= 0.0) {
+        gpuInterval.record(gpuMs);
+        gpuTotal.record(gpuMs);
+    }
+}
+
+void frameStatsPrintInterval(std::ostream &out) {
+    auto line = [&](const char* label, const LatencyHistogram &h) {
+        out << label;
+        for (int i = 0; i < 4; i++)
+            out << " " << QUANTILE_NAMES[i] << " " << h.percentile(QUANTILES[i]);
+        out << " max " << h.maxMs() << " ms";
+    };
+    if (!cpuInterval.count) return;
+    line("frame: cpu", cpuInterval);
+    if (gpuInterval.count)
+        line(", gpu", gpuInterval);
+    out << " (" << cpuInterval.count << " frames)\n";
+}
+
+void frameStatsNewInterval() {
+    cpuInterval.reset();
+    gpuInterval.reset();
+}
+
+void frameStatsWriteJson(const std::string &path, double runSeconds) {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("Failed to open " + path);
+    out << "{\"frames\":" << cpuTotal.count << ",\"duration_s\":" << runSeconds
+        << ",\"cpu_ms\":";
+    writeSummary(out, cpuTotal);
+    out << ",\"gpu_ms\":";
+    writeSummary(out, gpuTotal);
+    out << "}\n";
+}
+
+void frameStatsWriteMetrics(const std::string &path) {
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp);
+        writeMetric(out, "metharizon_frame_cpu_ms", cpuInterval, cpuTotal);
+        if (gpuTotal.count)
+            writeMetric(out, "metharizon_frame_gpu_ms", gpuInterval, gpuTotal);
+        out.close();
+        if (!out) {
+            std::cerr << "Failed to write " << tmp << ", metrics skipped\n";
+            std::remove(tmp.c_str());
+            return;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::cerr << "Failed to replace " << path << ", metrics skipped\n";
+        std::remove(tmp.c_str());
+    }
+}
@@ -0,0 +1,42 @@
+// src/framestats.h
+//
+// Frame-time distributions. LatencyHistogram is HDR-histogram style:
+// log2 buckets each split into 32 linear sub-buckets, so any recorded
+// value is reported within ~3% regardless of magnitude, in fixed memory.
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+struct LatencyHistogram {
+    static const int SUB_BITS = 5;
+
+    std::vector<uint64_t> counts = std::vector<uint64_t>(64 << SUB_BITS);
+    uint64_t count = 0;
+    uint64_t maxUs = 0;
+    double   sumMs = 0.0;
+
+    void   record(double ms);
+    double percentile(double q) const;   // ms, upper edge of the bucket holding quantile q
+    double maxMs()  const { return maxUs / 1000.0; }
+    double meanMs() const { return count ? sumMs / count : 0.0; }
+    void   reset();
+};
+
+// CPU time is frame-to-frame wall time; pass gpuMs < 0 when unknown.
+// Every frame goes to both the current interval and the whole-run totals.
+void frameStatsRecord(double cpuMs, double gpuMs);
+
+// One line of percentiles for the current interval
+void frameStatsPrintInterval(std::ostream &out);
+void frameStatsNewInterval();
+
+// Whole run: JSON with percentiles and the non-empty buckets
+void frameStatsWriteJson(const std::string &path, double runSeconds);
+
+// Prometheus text exposition: interval quantiles, run count and sum.
+// Written to a temporary file and renamed so scrapers never see half a file.
+// Runs inside the render loop, so an I/O error warns and skips the write.
+void frameStatsWriteMetrics(const std::string &path);
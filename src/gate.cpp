@@ -0,0 +1,235 @@
+// src/gate.cpp
+#include "gate.h"
+#include "json.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// Gated metrics; larger is worse for all of them
+struct MetricDef {
+    const char* key;
+    bool        steps;   // judged by stepsThreshold
+};
+const MetricDef METRICS[] = { { "cpu_ms", false }, { "gpu_ms", false }, { "steps_per_px", true } };
+
+struct Metric {
+    bool                present = false;
+    double              mean = 0, ci = 0;   // ci: half width of the 95% interval
+    std::vector<double> trials;
+};
+
+struct SceneResult {
+    std::string name, device;
+    int         width = 0, height = 0;
+    Metric      metrics[3];
+};
+
+// Two-sided 95% Student t quantiles for 1..30 degrees of freedom
+double tQuantile(size_t dof) {
+    static const double T[30] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+    return dof == 0 ? 0.0 : dof <= 30 ? T[dof - 1] : 1.960;
+}
+
+Metric summarise(const std::vector<double> &v) {
+    Metric m;
+    m.present = !v.empty();
+    m.trials  = v;
+    if (v.empty()) return m;
+    for (double x : v) m.mean += x;
+    m.mean /= double(v.size());
+    if (v.size() > 1) {
+        double var = 0;
+        for (double x : v) var += (x - m.mean) * (x - m.mean);
+        var /= double(v.size() - 1);
+        m.ci = tQuantile(v.size() - 1) * std::sqrt(var / double(v.size()));
+    }
+    return m;
+}
+
+std::string shellQuote(const std::string &s) {
+    std::string q = "'";
+    for (char c : s) q += c == '\'' ? std::string("'\\''") : std::string(1, c);
+    return q + "'";
+}
+
+std::vector<std::string> split(const std::string &s, char sep) {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, sep))
+        if (!item.empty()) out.push_back(item);
+    return out;
+}
+
+std::vector<std::string> listScenes(const GateOptions &opt) {
+    if (!opt.scenes.empty()) return split(opt.scenes, ',');
+    std::string cmd = shellQuote(opt.renderer) + " --list-scenes";
+    FILE* pipe = popen(cmd.c_str(), "r");
+    if (!pipe) throw std::runtime_error("Failed to run " + cmd);
+    std::string text;
+    char buf[256];
+    while (size_t n = std::fread(buf, 1, sizeof(buf), pipe))
+        text.append(buf, n);
+    if (pclose(pipe) != 0) throw std::runtime_error(cmd + " failed");
+    return split(text, '\n');
+}
+
+SceneResult runScene(const GateOptions &opt, const std::string &scene) {
+    std::string report = (std::filesystem::temp_directory_path() /
+                          ("metharizon_gate_" + scene + ".json")).string();
+    std::ostringstream cmd;
+    cmd << shellQuote(opt.renderer) << " --headless --scene " << shellQuote(scene)
+        << " --size " << shellQuote(opt.size) << " --warmup " << opt.warmup
+        << " --frames " << opt.frames << " --trials " << opt.trials
+        << " --scene-report " << shellQuote(report);
+    if (opt.device >= 0) cmd << " --device " << opt.device;
+    if (opt.readback) cmd << " --readback";
+    std::cout << "gate: " << scene << "..." << std::flush;
+    if (std::system((cmd.str() + " > /dev/null").c_str()) != 0)
+        throw std::runtime_error("renderer failed: " + cmd.str());
+
+    JsonValue j = jsonReadFile(report);
+    std::remove(report.c_str());
+    SceneResult r;
+    r.name   = scene;
+    r.device = j.str("device");
+    r.width  = int(j.num("width"));
+    r.height = int(j.num("height"));
+    for (size_t i = 0; i < 3; i++) {
+        const JsonValue* v = j.find(METRICS[i].key);
+        std::vector<double> samples;
+        if (v && v->type == JsonValue::ARRAY)
+            for (const JsonValue &x : v->array) samples.push_back(x.number);
+        else if (v && v->type == JsonValue::NUMBER)
+            samples.push_back(v->number);   // deterministic, measured once
+        r.metrics[i] = summarise(samples);
+    }
+    std::cout << " done\n";
+    return r;
+}
+
+void writeBaseline(const std::string &path, const std::vector<SceneResult> &results,
+                   const GateOptions &opt) {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("Failed to open " + path);
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    out << std::setprecision(9);
+    out << "{\n  \"context\": {\"date\": \"" << date << "\", \"device\": ";
+    jsonWriteString(out, results.empty() ? "" : results[0].device);
+    out << ", \"warmup\": " << opt.warmup << ", \"frames\": " << opt.frames
+        << ", \"trials\": " << opt.trials << "},\n  \"scenes\": [";
+    for (size_t s = 0; s < results.size(); s++) {
+        const SceneResult &r = results[s];
+        out << (s ? ",\n    " : "\n    ") << "{\"name\": ";
+        jsonWriteString(out, r.name);
+        out << ", \"width\": " << r.width << ", \"height\": " << r.height;
+        for (size_t i = 0; i < 3; i++) {
+            const Metric &m = r.metrics[i];
+            if (!m.present) continue;
+            out << ", \"" << METRICS[i].key << "\": {\"mean\": " << m.mean << ", \"ci\": " << m.ci
+                << ", \"trials\": [";
+            for (size_t k = 0; k < m.trials.size(); k++) out << (k ? ", " : "") << m.trials[k];
+            out << "]}";
+        }
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+std::string meanCi(const Metric &m) {
+    std::ostringstream s;
+    s << std::fixed << std::setprecision(3) << m.mean << " +-" << m.ci;
+    return s.str();
+}
+
+int compare(const std::string &path, const std::vector<SceneResult> &results, const GateOptions &opt) {
+    JsonValue base = jsonReadFile(path);
+    const JsonValue* scenes = base.find("scenes");
+    if (!scenes || scenes->type != JsonValue::ARRAY)
+        throw std::runtime_error(path + " has no \"scenes\" array");
+    const JsonValue* ctx = base.find("context");
+    std::string baseDevice = ctx ? ctx->str("device") : "";
+    if (!results.empty() && baseDevice != results[0].device)
+        std::cout << "warning: baseline was recorded on '" << baseDevice << "', this run is on '"
+                  << results[0].device << "'\n";
+
+    std::cout << "\nGate against " << path << " (time threshold " << opt.threshold
+              << "%, steps threshold " << opt.stepsThreshold << "%, 95% intervals)\n"
+              << std::left << std::setw(12) << "scene" << std::setw(14) << "metric" << std::right
+              << std::setw(20) << "baseline" << std::setw(20) << "current"
+              << std::setw(10) << "change" << "  verdict\n";
+
+    int regressions = 0;
+    for (const SceneResult &r : results) {
+        const JsonValue* old = nullptr;
+        for (const JsonValue &s : scenes->array)
+            if (s.str("name") == r.name && int(s.num("width")) == r.width &&
+                int(s.num("height")) == r.height) old = &s;
+        for (size_t i = 0; i < 3; i++) {
+            const Metric &cur = r.metrics[i];
+            const JsonValue* b = old ? old->find(METRICS[i].key) : nullptr;
+            if (!cur.present && !b) continue;
+            std::cout << std::left << std::setw(12) << r.name << std::setw(14) << METRICS[i].key
+                      << std::right;
+            if (!cur.present || !b) {
+                std::cout << std::setw(20) << (b ? "present" : "-") << std::setw(20)
+                          << (cur.present ? meanCi(cur) : "-") << std::setw(10) << "-"
+                          << "  not compared\n";
+                continue;
+            }
+            Metric before;
+            before.mean = b->num("mean");
+            before.ci   = b->num("ci");
+            double change    = before.mean > 0 ? (cur.mean / before.mean - 1.0) * 100.0 : 0.0;
+            double threshold = METRICS[i].steps ? opt.stepsThreshold : opt.threshold;
+            // a verdict needs both a change past the threshold and disjoint intervals
+            bool apart = cur.mean - cur.ci > before.mean + before.ci ||
+                         cur.mean + cur.ci < before.mean - before.ci;
+            const char* verdict = "same";
+            if (apart && change > threshold)       { verdict = "REGRESSION"; regressions++; }
+            else if (apart && change < -threshold) verdict = "improved";
+            else if (!apart && std::fabs(change) > threshold) verdict = "noisy";
+
+            std::ostringstream pct;
+            pct << std::showpos << std::fixed << std::setprecision(1) << change << "%";
+            std::cout << std::setw(20) << meanCi(before) << std::setw(20) << meanCi(cur)
+                      << std::setw(10) << pct.str() << "  " << verdict << "\n";
+        }
+    }
+    std::cout << (regressions ? "gate: FAIL, " : "gate: pass, ") << regressions << " regression"
+              << (regressions == 1 ? "" : "s") << "\n";
+    return regressions;
+}
+
+} // namespace
+
+int runGate(const GateOptions &opt) {
+    std::vector<SceneResult> results;
+    for (const std::string &scene : listScenes(opt))
+        results.push_back(runScene(opt, scene));
+
+    if (!opt.writeBaseline.empty()) {
+        writeBaseline(opt.writeBaseline, results, opt);
+        std::cout << "gate: wrote baseline " << opt.writeBaseline << "\n";
+    }
+    if (!opt.baseline.empty() && compare(opt.baseline, results, opt) > 0)
+        return 1;
+    return 0;
+}
@@ -0,0 +1,26 @@
+// src/gate.h
+//
+// Performance regression gate: runs the renderer's canonical headless
+// scenes (Metharizon --headless --scene ...) with warm-up and repeated
+// trials, and compares CPU time, GPU time and steps per pixel against a
+// stored baseline. Works on any Vulkan device, lavapipe included; a
+// baseline is only meaningful on the device it was recorded on.
+#pragma once
+
+#include <string>
+
+struct GateOptions {
+    std::string baseline;         // compare against this file
+    std::string writeBaseline;    // write this run as a new baseline
+    std::string renderer;         // Metharizon executable
+    std::string scenes;           // comma separated, empty = all the renderer lists
+    std::string size = "800x600";
+    int         device = -1;
+    int         warmup = 20, frames = 60, trials = 5;
+    double      threshold      = 5.0;   // percent, CPU and GPU time
+    double      stepsThreshold = 1.0;   // percent, steps per pixel
+    bool        readback = false;       // time reading every frame back, as exporters do
+};
+
+// 0 = pass, 1 = at least one regression; throws on errors
+int runGate(const GateOptions &opt);
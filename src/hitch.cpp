@@ -0,0 +1,98 @@
+// src/hitch.cpp
+#include "hitch.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+const size_t   HISTORY       = 256;   // frames kept, must cover PRE + POST
+const size_t   MEDIAN_WINDOW = 120;
+const uint64_t PRE_FRAMES    = 60;    // frames before the hitch in a dump
+const uint64_t POST_FRAMES   = 15;    // and after it
+const uint64_t NONE          = UINT64_MAX;
+
+float                   threshold = 0.f;
+std::string             prefix;
+std::vector<HitchFrame> history(HISTORY);
+uint64_t                recorded = 0;
+std::vector<float>      scratch;      // median workspace, reused
+
+uint64_t pendingFrame = NONE;         // hitch waiting for its POST frames
+float    pendingMedian;
+
+float rollingMedian() {
+    scratch.clear();
+    for (uint64_t i = recorded - MEDIAN_WINDOW; i < recorded; i++)
+        scratch.push_back(history[i % HISTORY].cpuMs);
+    std::nth_element(scratch.begin(), scratch.begin() + scratch.size()/2, scratch.end());
+    return scratch[scratch.size()/2];
+}
+
+void dump() {
+    uint64_t first = pendingFrame >= PRE_FRAMES ? pendingFrame - PRE_FRAMES : 0;
+    uint64_t last  = pendingFrame + POST_FRAMES;
+
+    std::ostringstream other;
+    other << "\"hitch_frame\":" << pendingFrame << ",\"median_ms\":" << pendingMedian
+          << ",\"threshold\":" << threshold << ",\"frames\":[";
+    bool sep = false;
+    uint64_t oldest = recorded > HISTORY ? recorded - HISTORY : 0;
+    for (uint64_t i = oldest; i < recorded; i++) {
+        const HitchFrame &f = history[i % HISTORY];
+        if (f.frame < first || f.frame > last) continue;
+        other << (sep ? "," : "") << "{\"frame\":" << f.frame
+              << ",\"cpu_ms\":" << f.cpuMs << ",\"gpu_ms\":" << f.gpuMs
+              << ",\"pos\":[" << f.pos[0] << "," << f.pos[1] << "," << f.pos[2] << "]"
+              << ",\"forward\":[" << f.forward[0] << "," << f.forward[1] << "," << f.forward[2] << "]"
+              << ",\"extent\":[" << f.width << "," << f.height << "]}";
+        sep = true;
+    }
+    other << "]";
+
+    std::string path = prefix + "_" + std::to_string(pendingFrame) + ".json";
+    // a hitch report must not end the session it was meant to diagnose
+    try {
+        traceExport(path, first, last, other.str());
+        std::cout << "hitch: frame " << pendingFrame << " took over " << threshold
+                  << "x the median " << pendingMedian << " ms, wrote " << path << "\n";
+    } catch (const std::exception &e) {
+        std::cerr << "hitch: frame " << pendingFrame << ": " << e.what() << ", report skipped\n";
+    }
+    pendingFrame = NONE;
+}
+
+} // namespace
+
+void hitchEnable(float t, const std::string &p) {
+    threshold = t;
+    prefix    = p;
+    traceEnable(true);
+}
+
+bool hitchEnabled() {
+    return threshold > 0.f;
+}
+
+void hitchRecord(const HitchFrame &f) {
+    if (threshold <= 0.f) return;
+    traceCounter("frame ms", f.cpuMs);
+
+    // compare against the frames before this one, then add it
+    if (pendingFrame == NONE && recorded >= MEDIAN_WINDOW) {
+        float median = rollingMedian();
+        if (f.cpuMs > threshold * median) {
+            pendingFrame  = f.frame;
+            pendingMedian = median;
+            traceInstant("hitch");
+        }
+    }
+    history[recorded++ % HISTORY] = f;
+
+    if (pendingFrame != NONE && f.frame >= pendingFrame + POST_FRAMES)
+        dump();
+}
@@ -0,0 +1,26 @@
+// src/hitch.h
+//
+// Hitch detector: keeps a bounded history of frame timings alongside the
+// trace rings and, when a frame takes longer than a multiple of the
+// rolling median, writes the surrounding window as a Chrome trace whose
+// "otherData" carries the per-frame timings, camera and swapchain state.
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+struct HitchFrame {
+    uint64_t frame;
+    float    cpuMs;          // frame-to-frame wall time
+    float    gpuMs;
+    float    pos[3], forward[3];
+    uint32_t width, height;  // swapchain extent
+};
+
+// threshold: multiple of the rolling median that counts as a hitch.
+// Dumps go to <prefix>_<frame>.json. Turns tracing on.
+void hitchEnable(float threshold, const std::string &prefix);
+bool hitchEnabled();
+
+// Call once per finished frame
+void hitchRecord(const HitchFrame &f);
@@ -0,0 +1,169 @@
+// src/json.cpp
+#include "json.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+struct Parser {
+    const std::string &s;
+    size_t             pos = 0;
+
+    [[noreturn]] void fail(const char* what) {
+        throw std::runtime_error("JSON: " + std::string(what) + " at offset " + std::to_string(pos));
+    }
+
+    void skipSpace() {
+        while (pos < s.size() && (s[pos] == ' ' || s[pos] == '\t' || s[pos] == '\n' || s[pos] == '\r'))
+            pos++;
+    }
+
+    bool consume(char c) {
+        skipSpace();
+        if (pos < s.size() && s[pos] == c) { pos++; return true; }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!consume(c)) fail(("expected '" + std::string(1, c) + "'").c_str());
+    }
+
+    bool literal(const char* word) {
+        size_t n = std::char_traits<char>::length(word);
+        if (s.compare(pos, n, word) != 0) return false;
+        pos += n;
+        return true;
+    }
+
+    std::string parseString() {
+        expect('"');
+        std::string out;
+        while (pos < s.size() && s[pos] != '"') {
+            char c = s[pos++];
+            if (c != '\\') { out += c; continue; }
+            if (pos >= s.size()) break;
+            char e = s[pos++];
+            switch (e) {
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'r': out += '\r'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'u': {
+                // BMP only, encoded as UTF-8; our own files are ASCII
+                if (pos + 4 > s.size()) fail("bad \\u escape");
+                unsigned cp = (unsigned)std::strtoul(s.substr(pos, 4).c_str(), nullptr, 16);
+                pos += 4;
+                if (cp < 0x80) out += (char)cp;
+                else if (cp < 0x800) { out += (char)(0xC0 | (cp >> 6)); out += (char)(0x80 | (cp & 0x3F)); }
+                else { out += (char)(0xE0 | (cp >> 12)); out += (char)(0x80 | ((cp >> 6) & 0x3F));
+                       out += (char)(0x80 | (cp & 0x3F)); }
+                break;
+            }
+            default: out += e;
+            }
+        }
+        if (pos >= s.size()) fail("unterminated string");
+        pos++;
+        return out;
+    }
+
+    JsonValue parseValue() {
+        skipSpace();
+        if (pos >= s.size()) fail("unexpected end");
+        JsonValue v;
+        char c = s[pos];
+        if (c == '{') {
+            pos++;
+            v.type = JsonValue::OBJECT;
+            if (consume('}')) return v;
+            do {
+                skipSpace();
+                std::string key = parseString();
+                expect(':');
+                v.object.emplace_back(std::move(key), parseValue());
+            } while (consume(','));
+            expect('}');
+        } else if (c == '[') {
+            pos++;
+            v.type = JsonValue::ARRAY;
+            if (consume(']')) return v;
+            do v.array.push_back(parseValue()); while (consume(','));
+            expect(']');
+        } else if (c == '"') {
+            v.type   = JsonValue::STRING;
+            v.string = parseString();
+        } else if (literal("true")) {
+            v.type = JsonValue::BOOL; v.boolean = true;
+        } else if (literal("false")) {
+            v.type = JsonValue::BOOL;
+        } else if (literal("null")) {
+            v.type = JsonValue::NUL;
+        } else {
+            const char* begin = s.c_str() + pos;
+            char*       end   = nullptr;
+            v.type   = JsonValue::NUMBER;
+            v.number = std::strtod(begin, &end);
+            if (end == begin) fail("unexpected character");
+            pos += (size_t)(end - begin);
+        }
+        return v;
+    }
+};
+
+} // namespace
+
+const JsonValue* JsonValue::find(const std::string &key) const {
+    for (auto &kv : object)
+        if (kv.first == key) return &kv.second;
+    return nullptr;
+}
+
+double JsonValue::num(const std::string &key, double fallback) const {
+    const JsonValue* v = find(key);
+    return v && v->type == NUMBER ? v->number : fallback;
+}
+
+std::string JsonValue::str(const std::string &key, const std::string &fallback) const {
+    const JsonValue* v = find(key);
+    return v && v->type == STRING ? v->string : fallback;
+}
+
+JsonValue jsonParse(const std::string &text) {
+    Parser p{ text };
+    JsonValue v = p.parseValue();
+    p.skipSpace();
+    if (p.pos != text.size()) p.fail("trailing data");
+    return v;
+}
+
+JsonValue jsonReadFile(const std::string &path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("Failed to open " + path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return jsonParse(ss.str());
+}
+
+void jsonWriteString(std::ostream &out, const std::string &s) {
+    out << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\')    out << '\\' << c;
+        else if (c == '\n')           out << "\\n";
+        else if (c == '\t')           out << "\\t";
+        else if (c == '\r')           out << "\\r";
+        else if (uint8_t(c) < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", unsigned(uint8_t(c)));
+            out << buf;
+        }
+        else                          out << c;
+    }
+    out << '"';
+}
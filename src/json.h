@@ -0,0 +1,32 @@
+// src/json.h
+//
+// Just enough JSON reading for baselines the tools wrote themselves:
+// objects, arrays, strings, numbers, booleans and null. Writers format
+// their output directly, like trace.cpp.
+#pragma once
+
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct JsonValue {
+    enum Type { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT };
+
+    Type                                           type = NUL;
+    bool                                           boolean = false;
+    double                                         number = 0.0;
+    std::string                                    string;
+    std::vector<JsonValue>                         array;
+    std::vector<std::pair<std::string, JsonValue>> object;   // in file order
+
+    const JsonValue* find(const std::string &key) const;     // nullptr if absent
+    double           num(const std::string &key, double fallback = 0.0) const;
+    std::string      str(const std::string &key, const std::string &fallback = "") const;
+};
+
+// Throw std::runtime_error with the byte offset on malformed input
+JsonValue jsonParse(const std::string &text);
+JsonValue jsonReadFile(const std::string &path);
+
+void jsonWriteString(std::ostream &out, const std::string &s);
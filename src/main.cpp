@@ -5,14 +5,32 @@
 #include <algorithm>
 #include <array>
 #include <chrono>
+#include <cctype>
+#include <cstdio>
 #include <cstring>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <map>
 #include <optional>
 #include <stdexcept>
+#include <tuple>
 #include <vector>
 #include <cmath>
 
+#include "camera.h"
+#include "checkpoint.h"
+#include "cluster.h"
+#include "daemon.h"
+#include "resultcache.h"
+#ifdef METHARIZON_CPU_RENDER
+#include "cpurender.h"
+#endif
+#include "framestats.h"
+#include "hitch.h"
+#include "json.h"
+#include "trace.h"
+
 const uint32_t WIDTH  = 800;
 const uint32_t HEIGHT = 600;
 
@@ -24,53 +42,21 @@ const uint32_t HEIGHT = 600;
             throw std::runtime_error(std::string("Vulkan error at ") + #fn);    \
     } while (0)
 
-struct Camera {
-    alignas(16) float pos[3];
-    alignas(16) float forward[3];
-    alignas(16) float up[3];
-    alignas(16) float right[3];
-};
-
-struct Quat {
-    float w, x, y, z;
-};
-
-static Quat quatMul(const Quat& a, const Quat& b) {
-    return {
-        a.w*b.w - a.x*b.x - a.y*b.y - a.z*b.z,
-        a.w*b.x + a.x*b.w + a.y*b.z - a.z*b.y,
-        a.w*b.y - a.x*b.z + a.y*b.w + a.z*b.x,
-        a.w*b.z + a.x*b.y - a.y*b.x + a.z*b.w
-    };
-}
-
-static Quat quatFromAxisAngle(const float axis[3], float angle) {
-    float half = angle * 0.5f;
-    float s = std::sin(half);
-    return { std::cos(half), axis[0]*s, axis[1]*s, axis[2]*s };
-}
-
-static void quatNormalize(Quat& q) {
-    float len = std::sqrt(q.w*q.w + q.x*q.x + q.y*q.y + q.z*q.z);
-    q.w/=len; q.x/=len; q.y/=len; q.z/=len;
-}
-
-static void rotateVec(const Quat& q, const float in[3], float out[3]) {
-    Quat v{0.f, in[0], in[1], in[2]};
-    Quat iq{q.w, -q.x, -q.y, -q.z};
-    Quat r = quatMul(quatMul(q, v), iq);
-    out[0] = r.x; out[1] = r.y; out[2] = r.z;
-}
-
-static const float BASE_FORWARD[3] = {0.f, 0.f, -1.f};
-static const float BASE_UP[3]      = {0.f, 1.f, 0.f};
-static const float BASE_RIGHT[3]   = {1.f, 0.f, 0.f};
-
 static auto now = [](){
     return std::chrono::high_resolution_clock::now();
 };
 
+enum RenderMode { MODE_RAYMARCH, MODE_PATHTRACE, MODE_DENOISED, MODE_ADAPTIVE, MODE_FOVEATED,
+                  MODE_CPU, MODE_COUNT };
+
 bool fullscreen = false;
+bool coneAA = false;
+bool statsEnabled = false;   // comp.glsl STATS variant plus the per-second report
+bool clockProfile = false;   // shader-clock heatmap in place of comp.glsl, if supported
+bool hudEnabled = false;
+bool screenshotPending = false;   // F12, written after the next frame
+RenderMode renderMode = MODE_RAYMARCH;
+RenderMode lastFrameMode = MODE_RAYMARCH;   // mode of the previously recorded frame
 int windowX, windowY;
 int windowW = WIDTH, windowH = HEIGHT;
 
@@ -89,6 +75,26 @@ void keyCallback(GLFWwindow* win, int key, int scancode, int action, int mods) {
             glfwSetWindowMonitor(win, nullptr, windowX, windowY, windowW, windowH, 0);
         }
     }
+    if (key == GLFW_KEY_P && action == GLFW_PRESS)
+        renderMode = renderMode == MODE_PATHTRACE ? MODE_RAYMARCH : MODE_PATHTRACE;
+    if (key == GLFW_KEY_V && action == GLFW_PRESS)
+        renderMode = renderMode == MODE_ADAPTIVE ? MODE_RAYMARCH : MODE_ADAPTIVE;
+    if (key == GLFW_KEY_F && action == GLFW_PRESS)
+        renderMode = renderMode == MODE_FOVEATED ? MODE_RAYMARCH : MODE_FOVEATED;
+    if (key == GLFW_KEY_C && action == GLFW_PRESS)
+        coneAA = !coneAA;
+    if (key == GLFW_KEY_T && action == GLFW_PRESS)
+        statsEnabled = !statsEnabled;
+    if (key == GLFW_KEY_K && action == GLFW_PRESS)
+        clockProfile = !clockProfile;
+    if (key == GLFW_KEY_H && action == GLFW_PRESS)
+        hudEnabled = !hudEnabled;
+    if (key == GLFW_KEY_O && action == GLFW_PRESS)
+        renderMode = renderMode == MODE_DENOISED ? MODE_RAYMARCH : MODE_DENOISED;
+    if (key == GLFW_KEY_R && action == GLFW_PRESS)
+        renderMode = renderMode == MODE_CPU ? MODE_RAYMARCH : MODE_CPU;
+    if (key == GLFW_KEY_F12 && action == GLFW_PRESS)
+        screenshotPending = true;
 }
 
 GLFWwindow*           window;
@@ -110,6 +116,18 @@ VkDeviceMemory        storageMemory;
 VkImageView           storageView;
 VkExtent2D            storageExtent;
 
+// Frame readback for screenshots (F12, --screenshot), --record and headless
+// --readback. On UMA devices the storage image is linear in
+// DEVICE_LOCAL|HOST_VISIBLE memory and readers use it in place; elsewhere
+// drawFrame copies the frame to a host-visible buffer on request.
+bool                  storageLinear = false;
+void*                 storageMapped = nullptr;    // first texel, when storageLinear
+VkDeviceSize          storageRowPitch = 0;
+bool                  storageCoherent = true;
+bool                  readbackPending = false;    // the next drawFrame keeps its pixels
+uint32_t              recordedFrames = 0;
+uint64_t              readbackSum = 0;            // --readback touches every byte
+
 VkBuffer              cameraBuffer;
 VkDeviceMemory        cameraMemory;
 VkDescriptorBufferInfo cameraBufferInfo;
@@ -120,8 +138,30 @@ VkDescriptorSet       ds;
 VkDescriptorImageInfo storageImageInfo;
 
 VkPipelineLayout      pipelineLayout;
-VkPipeline            pipeline;
+VkPipeline            pipeline;        // comp.glsl with every specialization constant off
 VkShaderModule        compShader;
+// comp_subgroup.glsl when the device has subgroup arithmetic and ballot in
+// compute shaders, which Vulkan 1.1 doesn't require; else comp.glsl
+std::string           compModule = "comp";
+
+// comp.glsl specialization constants, indexed by constant_id
+enum CompSpec { SPEC_CONE_AA, SPEC_STATS, SPEC_COUNT };
+const char* const SPEC_NAMES[SPEC_COUNT] = { "cone_aa", "stats" };
+
+struct PipelineVariant {
+    std::string           name;       // "comp" plus "+<spec>" for each enabled constant
+    std::vector<uint32_t> spec;       // value of constant_id i
+    VkPipeline            pipeline = VK_NULL_HANDLE;
+};
+std::map<std::vector<uint32_t>, PipelineVariant> compVariants;
+
+// VK_KHR_pipeline_executable_properties, when the driver has it: every
+// pipeline is built with statistics capture and dumped to opts.pipelineReport
+bool                  hasExecutableProperties = false;
+PFN_vkGetPipelineExecutablePropertiesKHR             pfnGetExecutableProperties;
+PFN_vkGetPipelineExecutableStatisticsKHR             pfnGetExecutableStatistics;
+PFN_vkGetPipelineExecutableInternalRepresentationsKHR pfnGetExecutableInternalReps;
+std::ofstream         pipelineReport;
 
 VkCommandPool         cmdPool;
 std::vector<VkCommandBuffer> cmdBuffers;
@@ -129,6 +169,293 @@ std::vector<VkCommandBuffer> cmdBuffers;
 VkSemaphore           semImageAvailable;
 VkSemaphore           semRenderFinished;
 
+struct Buffer {
+    VkBuffer       buffer = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize   size   = 0;
+    void*          mapped = nullptr;   // persistently mapped if HOST_VISIBLE
+    VkDeviceSize   allocated = 0;      // memory actually allocated, for the budget report
+    uint32_t       heap = 0;
+};
+
+Buffer                readbackBuffer;   // copy target when the storage image can't be mapped
+
+struct Options {
+    RenderMode mode          = MODE_RAYMARCH;
+    uint32_t samplesPerFrame = 1;
+    uint32_t maxBounces      = 4;
+    uint32_t stochasticRays  = 2;   // MODE_DENOISED rays per pixel per frame
+    uint32_t atrousPasses    = 4;
+    uint32_t vrBlockSize     = 4;       // MODE_ADAPTIVE coarse block, 2 or 4
+    float    vrDepthThreshold = 0.02f;
+    float    vrColorThreshold = 0.03f;
+    bool     vrShowBlocks    = false;
+    float    foveaScale      = 2.0f;    // MODE_FOVEATED: buffer is 1/scale of the image per axis
+    float    foveaAlpha      = 4.0f;
+    bool     memoryReport    = false;   // per-second heap usage and budget
+    std::string pipelineReport;   // --pipeline-report PATH; empty disables the report
+    std::string clockCsv       = "clock.csv";       // per-tile cycles, rewritten each second
+    std::string traceFile;                          // Chrome trace JSON, empty = no tracing
+    uint64_t    traceFirst = 0, traceLast = UINT64_MAX;   // frame range to export
+    float       hitchThreshold = 0.f;                   // x rolling median, 0 = detector off
+    std::string hitchPrefix    = "hitch";
+    std::string frameStatsFile;    // whole-run frame-time JSON, also enables the per-second line
+    std::string metricsFile;       // Prometheus text, rewritten each second
+    bool        headless = false;  // no window or swapchain, render a --scene and exit
+    uint32_t    width = WIDTH, height = HEIGHT;   // headless image size
+    int         device = -1;       // physical device index, -1 = first suitable
+    std::string scene;             // canonical camera, see SCENES
+    uint32_t    warmupFrames = 20, sceneFrames = 60, sceneTrials = 5;
+    std::string sceneReport;       // headless results JSON, for the regression gate
+    bool        listScenes = false;
+    uint32_t    cpuThreads = 0;        // MODE_CPU workers, 0 = every allowed CPU
+    bool        hostImport = true;     // VK_EXT_external_memory_host when available
+    std::string screenshot;            // headless: PPM of the final frame
+    std::string recordPrefix;          // every frame as <prefix>NNNNNN.ppm
+    bool        readback = false;      // headless: read every frame, as a video encoder would
+    bool        uma = true;            // render into host-visible device memory when it pays
+    std::string offlineOut;            // path-traced still (PPM), implies headless
+    uint32_t    offlineSpp = 256;
+    uint32_t    tileRows = 64;         // offline work and checkpoint unit
+    std::string checkpointFile;        // default <offlineOut>.ckpt
+    float       checkpointSecs = 60.f; // also written whenever a tile completes
+    std::string coordinateOut;         // PPM rendered by --workers child processes
+    uint32_t    workerCount = 2;       // on --device, unless --worker-devices lists them
+    std::vector<int> workerDevices;
+    float       workerTimeout = 0.f;   // seconds per band, 0 = never
+    std::string workerSocket;          // run as a coordinator's worker, implies headless
+    std::string serveSocket;           // render daemon, implies headless; --size is the largest request
+    float       serveWindowMs = 2.f;   // how long a batch waits for more requests
+    uint32_t    cacheMemoryMB = 256;   // daemon result cache, 0 = off
+    std::string cacheFile;             // its disk tier, empty = memory only
+    uint32_t    cacheDiskMB = 1024;
+    std::string zoomPrefix;            // exponential-map zoom video as <prefix>NNNNNN.ppm, implies headless
+    float       zoom = 1000.f;         // total magnification
+    uint32_t    zoomFrames = 300;
+    float       zoomInner = 48.f;      // pixels around each frame's centre marched directly
+    bool        zoomDirect = false;    // march every frame with comp.glsl instead
+};
+Options opts;
+
+// Memory budget (VK_EXT_memory_budget when present, else heap sizes and
+// our own allocations). Under pressure the inactive modes give up their
+// buffers and the path-tracer pool and foveated buffer shrink.
+enum MemoryPressure { PRESSURE_NORMAL, PRESSURE_HIGH, PRESSURE_CRITICAL };
+const char* const PRESSURE_NAMES[] = { "normal", "high", "critical" };
+
+bool           hasMemoryBudget = false;
+MemoryPressure memoryPressure  = PRESSURE_NORMAL;
+VkDeviceSize   appAllocated[VK_MAX_MEMORY_HEAPS] = {};   // by heap
+VkDeviceSize   heapUsage[VK_MAX_MEMORY_HEAPS]    = {};
+VkDeviceSize   heapBudget[VK_MAX_MEMORY_HEAPS]   = {};
+uint32_t       heapCount = 0;
+uint32_t       heapDeviceLocal = 0;                      // bit per device-local heap
+VkDeviceSize   storageAllocated = 0;
+uint32_t       storageHeap = 0;
+bool           modeLive[MODE_COUNT] = {};                // mode's resources exist
+
+// Wavefront path tracer (shaders/pt_*.glsl): generate -> [extend -> shade
+// -> shadow] x maxBounces -> resolve, with queues between the kernels.
+const uint32_t PT_POOL_SIZE = 1u << 20;   // paths in flight per chunk
+enum PtQueue { PT_QUEUE_EXTEND_A, PT_QUEUE_EXTEND_B, PT_QUEUE_SHADE, PT_QUEUE_SHADOW, PT_QUEUE_COUNT };
+enum PtPhase { PT_PHASE_EXTEND, PT_PHASE_SHADE, PT_PHASE_SHADOW };
+
+struct PtPush {
+    uint32_t frame, sampleCount, bounce, maxBounces, phase, extendIn;
+    uint32_t width, height, chunkBase, chunkSize, poolSize;
+};
+
+// must match the std430 layouts in shaders/include/pathtrace.glsl
+const VkDeviceSize PT_PATH_STRIDE   = 3 * 16;
+const VkDeviceSize PT_SHADOW_STRIDE = 3 * 16;
+const VkDeviceSize PT_COUNTERS_SIZE = 16 + 3 * 16;
+
+uint32_t              ptPoolSize;
+uint32_t              ptSampleCount = 0;
+uint32_t              ptFrame       = 0;
+uint64_t              ptSamplesTraced = 0;   // never reset, for the spp/s report
+Camera                ptLastCam{};
+Buffer                ptPaths, ptShadowRays, ptQueues, ptCounters, ptAccum;
+VkDescriptorSetLayout ptSetLayout;
+VkDescriptorPool      ptPool = VK_NULL_HANDLE;
+VkDescriptorSet       ptSet;
+VkPipelineLayout      ptPipelineLayout;
+VkPipeline            ptGenerate, ptArgs, ptExtend, ptShade, ptShadow, ptResolve;
+
+// Stochastic AO + soft shadows (shaders/sd_*.glsl): gbuffer -> trace 1-2 rays
+// -> temporal accumulation -> a-trous passes -> composite.
+struct SdPush {
+    float    prevPos[4], prevForward[4], prevUp[4], prevRight[4];
+    uint32_t frame, width, height, parity;
+    uint32_t step, srcBuf, historyValid, rays;
+};
+
+Buffer                sdGBuffer, sdNoisy, sdHistory, sdFiltered;
+VkDescriptorSetLayout sdSetLayout;
+VkDescriptorPool      sdPool = VK_NULL_HANDLE;
+VkDescriptorSet       sdSet;
+VkPipelineLayout      sdPipelineLayout;
+VkPipeline            sdGBufferPass, sdTrace, sdTemporal, sdAtrous, sdComposite;
+uint32_t              sdFrame = 0;
+bool                  sdHistoryValid = false;
+Camera                sdPrevCam{};
+
+// Content-adaptive variable rate (shaders/vr_*.glsl): one ray per block
+// corner, interpolate smooth blocks, march the rest at full rate.
+struct VrPush {
+    uint32_t width, height, blockSize, gridW, gridH;
+    float    depthThreshold, colorThreshold;
+    uint32_t showBlocks;
+};
+
+Buffer                vrCoarse, vrQueue, vrCounters;   // vrCounters is host-visible for the report
+VkDescriptorSetLayout vrSetLayout;
+VkDescriptorPool      vrPool = VK_NULL_HANDLE;
+VkDescriptorSet       vrSet;
+VkPipelineLayout      vrPipelineLayout;
+VkPipeline            vrCoarsePass, vrClassify, vrRefine;
+uint32_t              vrBlocks = 0;          // blocks in the current frame
+uint64_t              vrBlocksTotal = 0, vrBlocksRefined = 0;
+
+// Foveated rendering (shaders/fv_*.glsl): log-polar buffer around the focus
+// point, reconstructed to the full image.
+struct FvPush {
+    uint32_t width, height, bufW, bufH;
+    float    focus[2], logMaxR, alpha;
+};
+
+float                 focusPoint[2] = { 0.5f, 0.5f };   // normalized, updated per frame
+Buffer                fvBuffer;
+VkExtent2D            fvExtent;
+VkDescriptorSetLayout fvSetLayout;
+VkDescriptorPool      fvPool = VK_NULL_HANDLE;
+VkDescriptorSet       fvSet;
+VkPipelineLayout      fvPipelineLayout;
+VkPipeline            fvRender, fvReconstruct;
+
+// CPU rendering (cpurender.h) presented without a host-side copy. With
+// VK_EXT_external_memory_host the CPU framebuffer itself is imported as
+// the transfer source; otherwise the CPU renders straight into a ring of
+// persistently mapped staging buffers. Each tile is one copy region.
+const uint32_t CPU_STAGING_RING = 2;
+
+bool                  hasExternalMemoryHost = false;
+VkDeviceSize          hostPointerAlignment  = 0;
+PFN_vkGetMemoryHostPointerPropertiesEXT pfnGetMemoryHostPointerProperties;
+Buffer                cpuImported;                    // wraps cpuFramebuffer()
+Buffer                cpuStaging[CPU_STAGING_RING];   // used when the import is unavailable
+uint32_t              cpuStagingSlot = 0;
+VkBuffer              cpuSource = VK_NULL_HANDLE;     // holds the current frame
+std::vector<VkBufferImageCopy> cpuRegions;
+
+// March statistics written by the comp.glsl STATS variant. Must match the
+// Stats block in comp.glsl. drawFrame waits for the queue, so the block is
+// read back right after the frame that wrote it.
+const uint32_t STATS_STEP_BUCKETS = 32;   // 4 march steps per bucket
+struct StatsBlock {
+    uint32_t marchStepsLo, marchStepsHi;
+    uint32_t deEvalsLo, deEvalsHi;
+    uint32_t normalEvals;
+    uint32_t hitPixels, missPixels, cappedPixels;
+    uint32_t stepHistogram[STATS_STEP_BUCKETS];
+};
+
+Buffer                 statsBuffer;
+VkDescriptorBufferInfo statsBufferInfo;
+bool                   statsWritten = false;   // holds a finished STATS frame
+uint64_t               frameIndex = 0;
+
+// Accumulated over the report interval
+struct StatsTotals {
+    uint64_t frames, steps, deEvals, normals, hits, misses, capped;
+    uint64_t histogram[STATS_STEP_BUCKETS];
+};
+StatsTotals statsTotals{};
+
+// Shader-clock profile (shaders/clk_*.glsl), needs VK_KHR_shader_clock.
+// Replaces the comp.glsl dispatch while clockProfile is on.
+struct ClkPush {
+    uint32_t width, height, tilesX;
+};
+struct ClkTile {
+    uint32_t lo[4], hi[4];   // march, normal, shade, total cycles summed over the workgroup
+
+    uint64_t cycles(int phase) const { return (uint64_t(hi[phase]) << 32) | lo[phase]; }
+};
+const VkDeviceSize CLK_HEADER_SIZE = 16;
+
+bool                  hasShaderClock = false;
+Buffer                clkBuffer;   // host-visible: header then one ClkTile per 16x16 tile
+uint32_t              clkTilesX, clkTilesY;
+VkDescriptorSetLayout clkSetLayout;
+VkDescriptorPool      clkPool = VK_NULL_HANDLE;
+VkDescriptorSet       clkSet;
+VkPipelineLayout      clkPipelineLayout;
+VkPipeline            clkProfile, clkHeatmap;
+uint64_t              clkPhaseTotals[3] = {};   // march, normal, shade over the report interval
+
+// GPU timestamps bracketing each frame's compute work and swapchain copy.
+// VK_EXT_calibrated_timestamps maps them onto the trace clock; without it
+// the copy end is pinned to the CPU time the queue wait returned.
+enum GpuStamp { STAMP_BEGIN, STAMP_COMPUTE, STAMP_HUD, STAMP_COPY, STAMP_COUNT };
+
+VkQueryPool           timestampPool = VK_NULL_HANDLE;
+double                timestampPeriodNs = 1.0;
+bool                  hasCalibratedTimestamps = false;
+PFN_vkGetCalibratedTimestampsEXT pfnGetCalibratedTimestamps;
+double                gpuComputeMs = 0, gpuHudMs = 0, gpuCopyMs = 0;   // previous frame
+
+// Performance HUD (shaders/hud.glsl), drawn into the storage image after
+// the render. Must match the Hud block in hud.glsl.
+const uint32_t HUD_COLS    = 48;
+const uint32_t HUD_ROWS    = 6;
+const uint32_t HUD_SAMPLES = 144;
+struct HudBlock {
+    uint32_t text[HUD_ROWS * HUD_COLS];
+    float    graph[HUD_SAMPLES];
+};
+struct HudPush {
+    int32_t origin[2];
+    int32_t scale, rows;
+    float   graphMaxMs, budgetMs;
+};
+const int32_t HUD_PANEL_W = 2*3 + HUD_COLS*6;   // panel pixels, see hud.glsl
+const int32_t HUD_PANEL_H = 3*3 + HUD_ROWS*9 + 32;
+
+Buffer                hudBuffer;   // host-visible HudBlock, rewritten every frame
+VkDescriptorSetLayout hudSetLayout;
+VkDescriptorPool      hudPool = VK_NULL_HANDLE;
+VkDescriptorSet       hudSet;
+VkPipelineLayout      hudPipelineLayout;
+VkPipeline            hudPipeline;
+float                 hudFrameMs[HUD_SAMPLES] = {};   // ring, hudHead is the oldest
+uint32_t              hudHead = 0;
+std::string           hudStatsLine = "STATS OFF (T)";
+
+// Canonical scenes, for headless runs and the benchmark regression gate.
+// yaw turns the default -Z view about +Y, then pitch about the camera's right.
+struct Scene {
+    const char* name;
+    RenderMode  mode;
+    bool        coneAA;
+    float       pos[3];
+    float       yaw, pitch;
+};
+const Scene SCENES[] = {
+    { "overview",  MODE_RAYMARCH,  false, { 0.f,  0.f,  3.f  },  0.f,    0.f   },
+    { "closeup",   MODE_RAYMARCH,  false, { 0.1f, 0.1f, 1.45f }, 0.f,    0.f   },
+    { "grazing",   MODE_RAYMARCH,  false, { 1.6f, 0.9f, 1.6f },  0.785f, -0.38f },
+    { "cone_aa",   MODE_RAYMARCH,  true,  { 0.f,  0.f,  3.f  },  0.f,    0.f   },
+    { "pathtrace", MODE_PATHTRACE, false, { 0.f,  0.f,  3.f  },  0.f,    0.f   },
+    { "denoised",  MODE_DENOISED,  false, { 0.f,  0.f,  3.f  },  0.f,    0.f   },
+    { "adaptive",  MODE_ADAPTIVE,  false, { 0.f,  0.f,  3.f  },  0.f,    0.f   },
+    { "foveated",  MODE_FOVEATED,  false, { 0.f,  0.f,  3.f  },  0.f,    0.f   },
+    { "cpu",       MODE_CPU,       false, { 0.f,  0.f,  3.f  },  0.f,    0.f   },
+};
+
+std::string deviceName;
+double      lastWaitMs = 0;   // drawFrame's queue wait, subtracted for CPU time
+
 //
 // Helpers
 //
@@ -143,13 +470,268 @@ static std::vector<char> readFile(const std::string &path) {
     return buf;
 }
 
-// Find a queue family that supports both compute & present
+uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags props) {
+    VkPhysicalDeviceMemoryProperties mp;
+    vkGetPhysicalDeviceMemoryProperties(physDevice, &mp);
+    for (uint32_t i = 0; i < mp.memoryTypeCount; i++) {
+        if ((typeBits & (1u<<i)) &&
+            (mp.memoryTypes[i].propertyFlags & props) == props)
+            return i;
+    }
+    throw std::runtime_error("No suitable memory type");
+}
+
+uint32_t heapOfType(uint32_t type) {
+    VkPhysicalDeviceMemoryProperties mp;
+    vkGetPhysicalDeviceMemoryProperties(physDevice, &mp);
+    return mp.memoryTypes[type].heapIndex;
+}
+
+Buffer createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props) {
+    Buffer b;
+    b.size = size;
+    VkBufferCreateInfo bci{};
+    bci.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bci.size  = size;
+    bci.usage = usage;
+    VK_CHECK(vkCreateBuffer(device, &bci, nullptr, &b.buffer));
+
+    VkMemoryRequirements mr;
+    vkGetBufferMemoryRequirements(device, b.buffer, &mr);
+    VkMemoryAllocateInfo mai{};
+    mai.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    mai.allocationSize  = mr.size;
+    mai.memoryTypeIndex = findMemoryType(mr.memoryTypeBits, props);
+    VK_CHECK(vkAllocateMemory(device, &mai, nullptr, &b.memory));
+    VK_CHECK(vkBindBufferMemory(device, b.buffer, b.memory, 0));
+    b.allocated = mr.size;
+    b.heap      = heapOfType(mai.memoryTypeIndex);
+    appAllocated[b.heap] += b.allocated;
+
+    if (props & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        VK_CHECK(vkMapMemory(device, b.memory, 0, size, 0, &b.mapped));
+    return b;
+}
+
+void destroyBuffer(Buffer &b) {
+    appAllocated[b.heap] -= b.allocated;
+    if (b.buffer) vkDestroyBuffer(device, b.buffer, nullptr);
+    if (b.memory) vkFreeMemory(device, b.memory, nullptr);
+    b = Buffer{};
+}
+
+// Flags for pipeline creation so reportPipeline() has something to read
+VkPipelineCreateFlags pipelineCaptureFlags() {
+    if (!hasExecutableProperties) return 0;
+    return VK_PIPELINE_CREATE_CAPTURE_STATISTICS_BIT_KHR |
+           VK_PIPELINE_CREATE_CAPTURE_INTERNAL_REPRESENTATIONS_BIT_KHR;
+}
+
+// Append the driver's statistics and internal representations for every
+// executable of `pipe` to the pipeline report
+void reportPipeline(const std::string &name, const std::vector<uint32_t> &spec,
+                    VkPipeline pipe) {
+    if (!hasExecutableProperties || !pipelineReport.is_open()) return;
+
+    std::ostream &out = pipelineReport;
+    out << "== " << name;
+    if (!spec.empty()) {
+        out << " [";
+        for (uint32_t i = 0; i < spec.size(); i++)
+            out << (i ? " " : "") << SPEC_NAMES[i] << "=" << spec[i];
+        out << "]";
+    }
+    out << "\n";
+
+    VkPipelineInfoKHR pinfo{};
+    pinfo.sType    = VK_STRUCTURE_TYPE_PIPELINE_INFO_KHR;
+    pinfo.pipeline = pipe;
+    uint32_t count = 0;
+    VK_CHECK(pfnGetExecutableProperties(device, &pinfo, &count, nullptr));
+    std::vector<VkPipelineExecutablePropertiesKHR> execs(count);
+    for (auto &e : execs) e.sType = VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_PROPERTIES_KHR;
+    VK_CHECK(pfnGetExecutableProperties(device, &pinfo, &count, execs.data()));
+
+    for (uint32_t x = 0; x < count; x++) {
+        out << "  executable " << x << ": " << execs[x].name << " ("
+            << execs[x].description << "), subgroup size " << execs[x].subgroupSize << "\n";
+
+        VkPipelineExecutableInfoKHR einfo{};
+        einfo.sType           = VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_INFO_KHR;
+        einfo.pipeline        = pipe;
+        einfo.executableIndex = x;
+
+        uint32_t nstats = 0;
+        VK_CHECK(pfnGetExecutableStatistics(device, &einfo, &nstats, nullptr));
+        std::vector<VkPipelineExecutableStatisticKHR> stats(nstats);
+        for (auto &st : stats) st.sType = VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_STATISTIC_KHR;
+        VK_CHECK(pfnGetExecutableStatistics(device, &einfo, &nstats, stats.data()));
+        for (auto &st : stats) {
+            out << "    " << st.name << " = ";
+            switch (st.format) {
+            case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_BOOL32_KHR:  out << (st.value.b32 ? "true" : "false"); break;
+            case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_INT64_KHR:   out << st.value.i64; break;
+            case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_UINT64_KHR:  out << st.value.u64; break;
+            case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_FLOAT64_KHR: out << st.value.f64; break;
+            }
+            out << "    # " << st.description << "\n";
+        }
+
+        // two calls per representation: sizes first, then the data
+        uint32_t nreps = 0;
+        VK_CHECK(pfnGetExecutableInternalReps(device, &einfo, &nreps, nullptr));
+        std::vector<VkPipelineExecutableInternalRepresentationKHR> reps(nreps);
+        for (auto &r : reps) r.sType = VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_INTERNAL_REPRESENTATION_KHR;
+        VK_CHECK(pfnGetExecutableInternalReps(device, &einfo, &nreps, reps.data()));
+        std::vector<std::vector<char>> data(nreps);
+        for (uint32_t r = 0; r < nreps; r++) {
+            data[r].resize(reps[r].dataSize);
+            reps[r].pData = data[r].data();
+        }
+        VK_CHECK(pfnGetExecutableInternalReps(device, &einfo, &nreps, reps.data()));
+        for (uint32_t r = 0; r < nreps; r++) {
+            out << "    -- " << reps[r].name << " (" << reps[r].description << ")";
+            if (reps[r].isText && !data[r].empty())
+                out << "\n" << std::string(data[r].data()) << "\n";   // null-terminated
+            else
+                out << ": " << reps[r].dataSize << " bytes of binary data\n";
+        }
+    }
+    out << "\n";
+    out.flush();
+}
+
+// Load ../shaders/<name>.spv and build a compute pipeline for it
+VkPipeline createKernel(const std::string &name, VkPipelineLayout layout) {
+    auto spv = readFile("../shaders/" + name + ".spv");
+    VkShaderModuleCreateInfo smci{};
+    smci.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    smci.codeSize = spv.size();
+    smci.pCode    = reinterpret_cast<const uint32_t*>(spv.data());
+    VkShaderModule module;
+    VK_CHECK(vkCreateShaderModule(device, &smci, nullptr, &module));
+
+    VkComputePipelineCreateInfo cpci{};
+    cpci.sType        = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    cpci.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    cpci.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+    cpci.stage.module = module;
+    cpci.stage.pName  = "main";
+    cpci.layout       = layout;
+    cpci.flags        = pipelineCaptureFlags();
+    VkPipeline pipe;
+    VK_CHECK(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &cpci, nullptr, &pipe));
+    vkDestroyShaderModule(device, module, nullptr);
+    reportPipeline(name, {}, pipe);
+    return pipe;
+}
+
+// Make compute writes visible to later dispatches and indirect arguments
+void computeBarrier(VkCommandBuffer cb) {
+    VkMemoryBarrier mb{};
+    mb.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    mb.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    mb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT |
+                       VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    const VkPipelineStageFlags stages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+    vkCmdPipelineBarrier(cb, stages, stages,
+        0, 1,&mb, 0,nullptr, 0,nullptr);
+}
+
+// Kernel descriptor sets share one shape: binding 0 the storage image,
+// binding 1 the camera UBO, then `buffers` storage buffers from binding 2.
+VkDescriptorSetLayout createKernelSetLayout(uint32_t buffers) {
+    std::vector<VkDescriptorSetLayoutBinding> binds(2 + buffers);
+    for (uint32_t i = 0; i < binds.size(); i++) {
+        binds[i].binding         = i;
+        binds[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        binds[i].descriptorCount = 1;
+        binds[i].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    binds[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    binds[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+
+    VkDescriptorSetLayoutCreateInfo dsli{};
+    dsli.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    dsli.bindingCount = (uint32_t)binds.size();
+    dsli.pBindings    = binds.data();
+    VkDescriptorSetLayout layout;
+    VK_CHECK(vkCreateDescriptorSetLayout(device, &dsli, nullptr, &layout));
+    return layout;
+}
+
+VkPipelineLayout createKernelPipelineLayout(VkDescriptorSetLayout setLayout, uint32_t pushSize) {
+    VkPushConstantRange pcr{ VK_SHADER_STAGE_COMPUTE_BIT, 0, pushSize };
+    VkPipelineLayoutCreateInfo plci{};
+    plci.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    plci.setLayoutCount         = 1;
+    plci.pSetLayouts            = &setLayout;
+    plci.pushConstantRangeCount = 1;
+    plci.pPushConstantRanges    = &pcr;
+    VkPipelineLayout layout;
+    VK_CHECK(vkCreatePipelineLayout(device, &plci, nullptr, &layout));
+    return layout;
+}
+
+// Allocate a set for createKernelSetLayout(buffers.size()) from a pool of its own
+VkDescriptorSet createKernelSet(VkDescriptorSetLayout setLayout,
+                                const std::vector<const Buffer*> &buffers,
+                                VkDescriptorPool &pool) {
+    VkDescriptorPoolSize pss[] = {
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,  1 },
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, (uint32_t)buffers.size() },
+    };
+    VkDescriptorPoolCreateInfo dpci{};
+    dpci.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    dpci.maxSets       = 1;
+    dpci.poolSizeCount = buffers.empty() ? 2 : 3;
+    dpci.pPoolSizes    = pss;
+    VK_CHECK(vkCreateDescriptorPool(device, &dpci, nullptr, &pool));
+
+    VkDescriptorSetAllocateInfo dsai{};
+    dsai.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    dsai.descriptorPool     = pool;
+    dsai.descriptorSetCount = 1;
+    dsai.pSetLayouts        = &setLayout;
+    VkDescriptorSet set;
+    VK_CHECK(vkAllocateDescriptorSets(device, &dsai, &set));
+
+    std::vector<VkDescriptorBufferInfo> infos(buffers.size());
+    std::vector<VkWriteDescriptorSet> writes(2 + buffers.size());
+    for (uint32_t i = 0; i < writes.size(); i++) {
+        writes[i].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet          = set;
+        writes[i].dstBinding      = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    }
+    writes[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    writes[0].pImageInfo     = &storageImageInfo;
+    writes[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    writes[1].pBufferInfo    = &cameraBufferInfo;
+    for (uint32_t i = 0; i < buffers.size(); i++) {
+        infos[i]                = { buffers[i]->buffer, 0, VK_WHOLE_SIZE };
+        writes[i+2].pBufferInfo = &infos[i];
+    }
+    vkUpdateDescriptorSets(device, (uint32_t)writes.size(), writes.data(), 0, nullptr);
+    return set;
+}
+
+// Find a queue family that supports both compute & present (compute only
+// when headless), on opts.device if given
 void pickPhysicalDevice() {
     uint32_t devCount = 0;
     VK_CHECK(vkEnumeratePhysicalDevices(instance, &devCount, nullptr));
     if (!devCount) throw std::runtime_error("No GPU found");
     std::vector<VkPhysicalDevice> devs(devCount);
     VK_CHECK(vkEnumeratePhysicalDevices(instance, &devCount, devs.data()));
+    if (opts.device >= int(devCount))
+        throw std::runtime_error("--device " + std::to_string(opts.device) + ": only " +
+                                 std::to_string(devCount) + " devices");
+    if (opts.device >= 0)
+        devs = { devs[opts.device] };
 
     for (auto &dev : devs) {
         uint32_t qCount = 0;
@@ -159,11 +741,15 @@ void pickPhysicalDevice() {
 
         for (uint32_t i = 0; i < qCount; i++) {
             bool hasCompute = qProps[i].queueFlags & VK_QUEUE_COMPUTE_BIT;
-            VkBool32 presentCap = VK_FALSE;
-            vkGetPhysicalDeviceSurfaceSupportKHR(dev, i, surface, &presentCap);
+            VkBool32 presentCap = opts.headless;
+            if (!opts.headless)
+                vkGetPhysicalDeviceSurfaceSupportKHR(dev, i, surface, &presentCap);
             if (hasCompute && presentCap) {
                 physDevice    = dev;
                 queueFamily   = i;
+                VkPhysicalDeviceProperties props;
+                vkGetPhysicalDeviceProperties(dev, &props);
+                deviceName = props.deviceName;
                 return;
             }
         }
@@ -172,19 +758,21 @@ void pickPhysicalDevice() {
 }
 
 void createInstance() {
-    if (!glfwInit())
-        throw std::runtime_error("GLFW init failed");
-    if (!glfwVulkanSupported())
-        throw std::runtime_error("Vulkan not supported by GLFW");
+    uint32_t extCount = 0;
+    const char** glfwExts = nullptr;
+    if (!opts.headless) {
+        if (!glfwInit())
+            throw std::runtime_error("GLFW init failed");
+        if (!glfwVulkanSupported())
+            throw std::runtime_error("Vulkan not supported by GLFW");
+        glfwExts = glfwGetRequiredInstanceExtensions(&extCount);
+    }
 
     VkApplicationInfo appInfo{};
     appInfo.sType              = VK_STRUCTURE_TYPE_APPLICATION_INFO;
     appInfo.pApplicationName   = "ComputeRaymarch";
     appInfo.apiVersion         = VK_API_VERSION_1_1;
 
-    uint32_t extCount = 0;
-    const char** glfwExts = glfwGetRequiredInstanceExtensions(&extCount);
-
     VkInstanceCreateInfo ci{};
     ci.sType                   = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     ci.pApplicationInfo        = &appInfo;
@@ -202,6 +790,16 @@ void createWindowAndSurface() {
     VK_CHECK(glfwCreateWindowSurface(instance, window, nullptr, &surface));
 }
 
+bool deviceHasExtension(const char* name) {
+    uint32_t count = 0;
+    VK_CHECK(vkEnumerateDeviceExtensionProperties(physDevice, nullptr, &count, nullptr));
+    std::vector<VkExtensionProperties> exts(count);
+    VK_CHECK(vkEnumerateDeviceExtensionProperties(physDevice, nullptr, &count, exts.data()));
+    for (auto &e : exts)
+        if (std::strcmp(e.extensionName, name) == 0) return true;
+    return false;
+}
+
 void createLogicalDeviceAndQueue() {
     float prio = 1.0f;
     VkDeviceQueueCreateInfo qci{};
@@ -211,17 +809,125 @@ void createLogicalDeviceAndQueue() {
     qci.pQueuePriorities = &prio;
 
     // Enable swapchain extension so we can present
-    const char* devExts[] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+    std::vector<const char*> devExts;
+    if (!opts.headless)
+        devExts.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    void* features = nullptr;   // pNext chain of optional feature structs
+
+    VkPhysicalDevicePipelineExecutablePropertiesFeaturesKHR execFeatures{};
+    execFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PIPELINE_EXECUTABLE_PROPERTIES_FEATURES_KHR;
+    if (!opts.pipelineReport.empty() &&
+        deviceHasExtension(VK_KHR_PIPELINE_EXECUTABLE_PROPERTIES_EXTENSION_NAME)) {
+        VkPhysicalDeviceFeatures2 f2{};
+        f2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        f2.pNext = &execFeatures;
+        vkGetPhysicalDeviceFeatures2(physDevice, &f2);
+        execFeatures.pNext = nullptr;
+        if (execFeatures.pipelineExecutableInfo) {
+            devExts.push_back(VK_KHR_PIPELINE_EXECUTABLE_PROPERTIES_EXTENSION_NAME);
+            execFeatures.pNext = features;
+            features = &execFeatures;
+            hasExecutableProperties = true;
+        }
+    }
+
+    VkPhysicalDeviceShaderClockFeaturesKHR clockFeatures{};
+    clockFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_CLOCK_FEATURES_KHR;
+    if (deviceHasExtension(VK_KHR_SHADER_CLOCK_EXTENSION_NAME)) {
+        VkPhysicalDeviceFeatures2 f2{};
+        f2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        f2.pNext = &clockFeatures;
+        vkGetPhysicalDeviceFeatures2(physDevice, &f2);
+        clockFeatures.pNext             = nullptr;
+        clockFeatures.shaderDeviceClock = VK_FALSE;
+        if (clockFeatures.shaderSubgroupClock) {
+            devExts.push_back(VK_KHR_SHADER_CLOCK_EXTENSION_NAME);
+            clockFeatures.pNext = features;
+            features = &clockFeatures;
+            hasShaderClock = true;
+        }
+    }
+
+    if (deviceHasExtension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)) {
+        devExts.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        hasMemoryBudget = true;
+    }
+
+    // VK_KHR_external_memory, which it needs, is core in 1.1
+    if (opts.hostImport && deviceHasExtension(VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME)) {
+        devExts.push_back(VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME);
+        hasExternalMemoryHost = true;
+    }
+
+    // the trace clock is std::chrono::steady_clock, CLOCK_MONOTONIC on Linux
+#ifdef __linux__
+    if (deviceHasExtension(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME)) {
+        auto getDomains = (PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT)
+            vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT");
+        uint32_t n = 0;
+        VK_CHECK(getDomains(physDevice, &n, nullptr));
+        std::vector<VkTimeDomainEXT> domains(n);
+        VK_CHECK(getDomains(physDevice, &n, domains.data()));
+        auto has = [&](VkTimeDomainEXT d) {
+            return std::find(domains.begin(), domains.end(), d) != domains.end();
+        };
+        if (has(VK_TIME_DOMAIN_DEVICE_EXT) && has(VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT)) {
+            devExts.push_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+            hasCalibratedTimestamps = true;
+        }
+    }
+#endif
 
     VkDeviceCreateInfo di{};
     di.sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    di.pNext                   = features;
     di.queueCreateInfoCount    = 1;
     di.pQueueCreateInfos       = &qci;
-    di.enabledExtensionCount   = 1;
-    di.ppEnabledExtensionNames = devExts;
+    di.enabledExtensionCount   = (uint32_t)devExts.size();
+    di.ppEnabledExtensionNames = devExts.data();
 
     VK_CHECK(vkCreateDevice(physDevice, &di, nullptr, &device));
     vkGetDeviceQueue(device, queueFamily, 0, &queue);
+
+    if (hasCalibratedTimestamps)
+        pfnGetCalibratedTimestamps = (PFN_vkGetCalibratedTimestampsEXT)
+            vkGetDeviceProcAddr(device, "vkGetCalibratedTimestampsEXT");
+
+    if (hasExternalMemoryHost) {
+        VkPhysicalDeviceExternalMemoryHostPropertiesEXT hostProps{};
+        hostProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_MEMORY_HOST_PROPERTIES_EXT;
+        VkPhysicalDeviceProperties2 props2{};
+        props2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        props2.pNext = &hostProps;
+        vkGetPhysicalDeviceProperties2(physDevice, &props2);
+        hostPointerAlignment = hostProps.minImportedHostPointerAlignment;
+        pfnGetMemoryHostPointerProperties = (PFN_vkGetMemoryHostPointerPropertiesEXT)
+            vkGetDeviceProcAddr(device, "vkGetMemoryHostPointerPropertiesEXT");
+    }
+
+    VkPhysicalDeviceSubgroupProperties subgroupProps{};
+    subgroupProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+    VkPhysicalDeviceProperties2 subgroupProps2{};
+    subgroupProps2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    subgroupProps2.pNext = &subgroupProps;
+    vkGetPhysicalDeviceProperties2(physDevice, &subgroupProps2);
+    const VkSubgroupFeatureFlags statsOps = VK_SUBGROUP_FEATURE_BASIC_BIT |
+        VK_SUBGROUP_FEATURE_ARITHMETIC_BIT | VK_SUBGROUP_FEATURE_BALLOT_BIT;
+    if ((subgroupProps.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) &&
+        (subgroupProps.supportedOperations & statsOps) == statsOps)
+        compModule = "comp_subgroup";
+
+    if (hasExecutableProperties) {
+        pfnGetExecutableProperties = (PFN_vkGetPipelineExecutablePropertiesKHR)
+            vkGetDeviceProcAddr(device, "vkGetPipelineExecutablePropertiesKHR");
+        pfnGetExecutableStatistics = (PFN_vkGetPipelineExecutableStatisticsKHR)
+            vkGetDeviceProcAddr(device, "vkGetPipelineExecutableStatisticsKHR");
+        pfnGetExecutableInternalReps = (PFN_vkGetPipelineExecutableInternalRepresentationsKHR)
+            vkGetDeviceProcAddr(device, "vkGetPipelineExecutableInternalRepresentationsKHR");
+        pipelineReport.open(opts.pipelineReport);
+        if (!pipelineReport) throw std::runtime_error("Failed to open " + opts.pipelineReport);
+        std::cout << "pipeline statistics: " << opts.pipelineReport << "\n";
+    }
 }
 
 void createSwapchain(uint32_t width, uint32_t height) {
@@ -288,6 +994,42 @@ void createSwapchain(uint32_t width, uint32_t height) {
     }
 }
 
+// Device-local memory the host can map, HOST_CACHED preferred since
+// readers stream the whole frame. -1 if there is none.
+int umaMemoryType(uint32_t typeBits) {
+    const VkMemoryPropertyFlags uma = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    VkPhysicalDeviceMemoryProperties mp;
+    vkGetPhysicalDeviceMemoryProperties(physDevice, &mp);
+    int best = -1;
+    for (uint32_t i = 0; i < mp.memoryTypeCount; i++) {
+        VkMemoryPropertyFlags f = mp.memoryTypes[i].propertyFlags;
+        if (!(typeBits & (1u << i)) || (f & uma) != uma) continue;
+        if (best < 0 || (f & VK_MEMORY_PROPERTY_HOST_CACHED_BIT)) best = int(i);
+        if (f & VK_MEMORY_PROPERTY_HOST_CACHED_BIT) break;
+    }
+    return best;
+}
+
+// Linear storage only pays when frames are read continuously, or on CPU
+// devices (lavapipe) where tiling buys nothing anyway. Otherwise optimal
+// tiling keeps the march fast and the odd screenshot pays one copy.
+// Only integrated and CPU devices share memory with the host: a discrete
+// GPU's host-visible device memory is the BAR, uncached across PCIe.
+bool wantLinearStorage() {
+    if (!opts.uma) return false;
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(physDevice, &props);
+    if (props.deviceType != VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU &&
+        props.deviceType != VK_PHYSICAL_DEVICE_TYPE_CPU)
+        return false;
+    if (opts.recordPrefix.empty() && !opts.readback &&
+        props.deviceType != VK_PHYSICAL_DEVICE_TYPE_CPU)
+        return false;
+    VkFormatProperties fp;
+    vkGetPhysicalDeviceFormatProperties(physDevice, VK_FORMAT_R8G8B8A8_UNORM, &fp);
+    return (fp.linearTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT) != 0;
+}
+
 void createStorageImage() {
     storageExtent = swapchainExtent;
     VkImageCreateInfo ici{};
@@ -298,25 +1040,56 @@ void createStorageImage() {
     ici.mipLevels   = 1;
     ici.arrayLayers = 1;
     ici.usage       = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-    VK_CHECK(vkCreateImage(device, &ici, nullptr, &storageImage));
 
-    VkMemoryRequirements mr;
-    vkGetImageMemoryRequirements(device, storageImage, &mr);
     VkPhysicalDeviceMemoryProperties mp;
     vkGetPhysicalDeviceMemoryProperties(physDevice, &mp);
+    VkMemoryRequirements mr;
     VkMemoryAllocateInfo mai{};
-    mai.sType          = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    mai.allocationSize = mr.size;
-    for (uint32_t i = 0; i < mp.memoryTypeCount; i++) {
-        if ((mr.memoryTypeBits & (1<<i)) &&
-            (mp.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
-           == VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) {
-            mai.memoryTypeIndex = i;
+    mai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    storageLinear = wantLinearStorage();
+    for (;;) {
+        ici.tiling = storageLinear ? VK_IMAGE_TILING_LINEAR : VK_IMAGE_TILING_OPTIMAL;
+        VK_CHECK(vkCreateImage(device, &ici, nullptr, &storageImage));
+        vkGetImageMemoryRequirements(device, storageImage, &mr);
+        mai.allocationSize = mr.size;
+        if (!storageLinear) break;
+        int type = umaMemoryType(mr.memoryTypeBits);
+        if (type >= 0) {
+            mai.memoryTypeIndex = uint32_t(type);
             break;
         }
+        // no mappable device memory for the linear image, fall back
+        vkDestroyImage(device, storageImage, nullptr);
+        storageLinear = false;
+    }
+    if (!storageLinear) {
+        for (uint32_t i = 0; i < mp.memoryTypeCount; i++) {
+            if ((mr.memoryTypeBits & (1<<i)) &&
+                (mp.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+               == VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) {
+                mai.memoryTypeIndex = i;
+                break;
+            }
+        }
     }
     VK_CHECK(vkAllocateMemory(device, &mai, nullptr, &storageMemory));
     VK_CHECK(vkBindImageMemory(device, storageImage, storageMemory, 0));
+    storageAllocated = mr.size;
+    storageHeap      = mp.memoryTypes[mai.memoryTypeIndex].heapIndex;
+    appAllocated[storageHeap] += storageAllocated;
+
+    storageMapped = nullptr;
+    if (storageLinear) {
+        VkImageSubresource sub{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 0 };
+        VkSubresourceLayout layout;
+        vkGetImageSubresourceLayout(device, storageImage, &sub, &layout);
+        void* ptr;
+        VK_CHECK(vkMapMemory(device, storageMemory, 0, VK_WHOLE_SIZE, 0, &ptr));
+        storageMapped   = static_cast<uint8_t*>(ptr) + layout.offset;
+        storageRowPitch = layout.rowPitch;
+        storageCoherent = (mp.memoryTypes[mai.memoryTypeIndex].propertyFlags &
+                           VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+    }
 
     VkImageViewCreateInfo ivci{};
     ivci.sType                = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -333,7 +1106,7 @@ void createCameraBuffer() {
     VkBufferCreateInfo bci{};
     bci.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     bci.size  = sizeof(Camera);
-    bci.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    bci.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
     VK_CHECK(vkCreateBuffer(device, &bci, nullptr, &cameraBuffer));
 
     VkMemoryRequirements mr;
@@ -360,6 +1133,59 @@ void createCameraBuffer() {
     cameraBufferInfo.range  = sizeof(Camera);
 }
 
+void createStatsBuffer() {
+    statsBuffer = createBuffer(sizeof(StatsBlock),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    statsBufferInfo = { statsBuffer.buffer, 0, sizeof(StatsBlock) };
+}
+
+// Fold the last frame's statistics into statsTotals
+void collectStats() {
+    if (!statsWritten) return;
+    statsWritten = false;
+
+    auto st = static_cast<const StatsBlock*>(statsBuffer.mapped);
+    statsTotals.frames++;
+    statsTotals.steps   += (uint64_t(st->marchStepsHi) << 32) | st->marchStepsLo;
+    statsTotals.deEvals += (uint64_t(st->deEvalsHi) << 32) | st->deEvalsLo;
+    statsTotals.normals += st->normalEvals;
+    statsTotals.hits    += st->hitPixels;
+    statsTotals.misses  += st->missPixels;
+    statsTotals.capped  += st->cappedPixels;
+    for (uint32_t i = 0; i < STATS_STEP_BUCKETS; i++)
+        statsTotals.histogram[i] += st->stepHistogram[i];
+}
+
+void printStatsReport() {
+    const StatsTotals &t = statsTotals;
+    uint64_t pixels = t.hits + t.misses + t.capped;
+    if (!pixels) return;
+    // step count at a quantile, to bucket resolution
+    auto quantile = [&](double q) {
+        uint64_t want = uint64_t(q * pixels), seen = 0;
+        for (uint32_t i = 0; i < STATS_STEP_BUCKETS; i++) {
+            seen += t.histogram[i];
+            if (seen > want) return (i + 1) * 4;
+        }
+        return STATS_STEP_BUCKETS * 4;
+    };
+    double px = double(pixels);
+    std::cout << "stats: " << t.steps / px << " steps/px, "
+              << t.deEvals / px << " DE/px, "
+              << (t.hits ? double(t.deEvals) / t.hits : 0.0) << " DE/hit, "
+              << t.normals / px << " normals/px, hit/miss/capped "
+              << 100.0 * t.hits / px << "/" << 100.0 * t.misses / px << "/"
+              << 100.0 * t.capped / px << "%, steps p50<=" << quantile(0.5)
+              << " p90<=" << quantile(0.9) << " (" << t.frames << " frames)\n";
+
+    char line[HUD_COLS + 1];
+    std::snprintf(line, sizeof(line), "STEPS/PX %.1f DE/HIT %.0f HIT %.0f%% CAP %.1f%%",
+                  t.steps / px, t.hits ? double(t.deEvals) / t.hits : 0.0,
+                  100.0 * t.hits / px, 100.0 * t.capped / px);
+    hudStatsLine = line;
+}
+
 void createDescriptorSet() {
     // storage image binding
     VkDescriptorSetLayoutBinding b0{};  
@@ -375,7 +1201,14 @@ void createDescriptorSet() {
     b1.descriptorCount = 1;
     b1.stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
 
-    std::array<VkDescriptorSetLayoutBinding,2> binds = { b0, b1 };
+    // statistics binding
+    VkDescriptorSetLayoutBinding b2{};
+    b2.binding         = 2;
+    b2.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    b2.descriptorCount = 1;
+    b2.stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    std::array<VkDescriptorSetLayoutBinding,3> binds = { b0, b1, b2 };
     VkDescriptorSetLayoutCreateInfo dsli{};
     dsli.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
     dsli.bindingCount = (uint32_t)binds.size();
@@ -385,7 +1218,8 @@ void createDescriptorSet() {
     // pool sizes
     VkDescriptorPoolSize ps0{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,  1 };
     VkDescriptorPoolSize ps1{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 };
-    std::array<VkDescriptorPoolSize,2> pss = { ps0, ps1 };
+    VkDescriptorPoolSize ps2{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 };
+    std::array<VkDescriptorPoolSize,3> pss = { ps0, ps1, ps2 };
     VkDescriptorPoolCreateInfo dpci{};
     dpci.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
     dpci.maxSets       = 1;
@@ -419,14 +1253,69 @@ void createDescriptorSet() {
     w1.descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
     w1.pBufferInfo     = &cameraBufferInfo;
 
-    std::array<VkWriteDescriptorSet,2> writes = { w0, w1 };
+    VkWriteDescriptorSet w2{};
+    w2.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    w2.dstSet          = ds;
+    w2.dstBinding      = 2;
+    w2.descriptorCount = 1;
+    w2.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    w2.pBufferInfo     = &statsBufferInfo;
+
+    std::array<VkWriteDescriptorSet,3> writes = { w0, w1, w2 };
     vkUpdateDescriptorSets(device,
                            (uint32_t)writes.size(), writes.data(),
                             0, nullptr);
 }
 
+std::vector<uint32_t> currentSpec() {
+    std::vector<uint32_t> spec(SPEC_COUNT, 0);
+    spec[SPEC_CONE_AA] = coneAA ? 1 : 0;
+    spec[SPEC_STATS]   = statsEnabled ? 1 : 0;
+    return spec;
+}
+
+// Build (once) the comp.glsl pipeline for one set of specialization values.
+// compShader stays alive so variants can be created on demand.
+VkPipeline getComputeVariant(const std::vector<uint32_t> &spec) {
+    auto it = compVariants.find(spec);
+    if (it != compVariants.end())
+        return it->second.pipeline;
+
+    PipelineVariant v;
+    v.spec = spec;
+    v.name = "comp";
+    for (uint32_t i = 0; i < spec.size(); i++)
+        if (spec[i]) v.name += std::string("+") + SPEC_NAMES[i];
+
+    std::vector<VkSpecializationMapEntry> entries(spec.size());
+    for (uint32_t i = 0; i < spec.size(); i++)
+        entries[i] = { i, i * (uint32_t)sizeof(uint32_t), sizeof(uint32_t) };
+    VkSpecializationInfo si{};
+    si.mapEntryCount = (uint32_t)entries.size();
+    si.pMapEntries   = entries.data();
+    si.dataSize      = spec.size() * sizeof(uint32_t);
+    si.pData         = spec.data();
+
+    VkComputePipelineCreateInfo cpci{};
+    cpci.sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    cpci.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    cpci.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+    cpci.stage.module = compShader;
+    cpci.stage.pName  = "main";
+    cpci.stage.pSpecializationInfo = &si;
+    cpci.layout       = pipelineLayout;
+    cpci.flags        = pipelineCaptureFlags();
+    VK_CHECK(vkCreateComputePipelines(device,
+                                      VK_NULL_HANDLE, 1,
+                                      &cpci, nullptr,
+                                      &v.pipeline));
+    reportPipeline(v.name, v.spec, v.pipeline);
+    compVariants[spec] = v;
+    return v.pipeline;
+}
+
 void createComputePipeline() {
-    auto spv = readFile("../shaders/comp.spv");
+    auto spv = readFile("../shaders/" + compModule + ".spv");
     VkShaderModuleCreateInfo smci{};
     smci.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
     smci.codeSize = spv.size();
@@ -439,120 +1328,993 @@ void createComputePipeline() {
     plci.pSetLayouts    = &dsLayout;
     VK_CHECK(vkCreatePipelineLayout(device, &plci, nullptr, &pipelineLayout));
 
-    VkComputePipelineCreateInfo cpci{};
-    cpci.sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-    cpci.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    cpci.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
-    cpci.stage.module = compShader;
-    cpci.stage.pName  = "main";
-    cpci.layout       = pipelineLayout;
-    VK_CHECK(vkCreateComputePipelines(device,
-                                      VK_NULL_HANDLE, 1,
-                                      &cpci, nullptr,
-                                      &pipeline));
+    pipeline = getComputeVariant(std::vector<uint32_t>(SPEC_COUNT, 0));
 }
 
-void createCommandPoolAndBuffers() {
-    VkCommandPoolCreateInfo cpi{};
-    cpi.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    cpi.queueFamilyIndex = queueFamily;
-    VK_CHECK(vkCreateCommandPool(device, &cpi, nullptr, &cmdPool));
+void createPathTracerPipelines() {
+    ptSetLayout      = createKernelSetLayout(5);
+    ptPipelineLayout = createKernelPipelineLayout(ptSetLayout, sizeof(PtPush));
 
-    cmdBuffers.resize(swapImageViews.size());
-    VkCommandBufferAllocateInfo cbai{};
-    cbai.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    cbai.commandPool        = cmdPool;
-    cbai.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    cbai.commandBufferCount = (uint32_t)cmdBuffers.size();
-    VK_CHECK(vkAllocateCommandBuffers(device, &cbai, cmdBuffers.data()));
+    ptGenerate = createKernel("pt_generate", ptPipelineLayout);
+    ptArgs     = createKernel("pt_args",     ptPipelineLayout);
+    ptExtend   = createKernel("pt_extend",   ptPipelineLayout);
+    ptShade    = createKernel("pt_shade",    ptPipelineLayout);
+    ptShadow   = createKernel("pt_shadow",   ptPipelineLayout);
+    ptResolve  = createKernel("pt_resolve",  ptPipelineLayout);
 }
 
-void createSyncObjects() {
-    VkSemaphoreCreateInfo sci{};
-    sci.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-    VK_CHECK(vkCreateSemaphore(device, &sci, nullptr, &semImageAvailable));
-    VK_CHECK(vkCreateSemaphore(device, &sci, nullptr, &semRenderFinished));
+// Pool, queues and accumulation buffer depend on the storage image size
+void createPathTracerResources() {
+    uint32_t pixels = storageExtent.width * storageExtent.height;
+    ptPoolSize = std::min(PT_POOL_SIZE >> (2 * memoryPressure), pixels);
+
+    const VkBufferUsageFlags ssbo = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    ptPaths      = createBuffer(PT_PATH_STRIDE * ptPoolSize,   ssbo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    ptShadowRays = createBuffer(PT_SHADOW_STRIDE * ptPoolSize, ssbo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    ptQueues     = createBuffer(sizeof(uint32_t) * PT_QUEUE_COUNT * ptPoolSize, ssbo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    ptCounters   = createBuffer(PT_COUNTERS_SIZE, ssbo | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    ptAccum      = createBuffer(16 * (VkDeviceSize)pixels, ssbo | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    ptSampleCount = 0;
+
+    ptSet = createKernelSet(ptSetLayout,
+        { &ptPaths, &ptShadowRays, &ptQueues, &ptCounters, &ptAccum }, ptPool);
 }
 
-void cleanupSwapchain() {
-    for (auto view : swapImageViews)
-        vkDestroyImageView(device, view, nullptr);
-    swapImageViews.clear();
-    if (swapchain)
-        vkDestroySwapchainKHR(device, swapchain, nullptr);
+void destroyPathTracerResources() {
+    if (ptPool)
+        vkDestroyDescriptorPool(device, ptPool, nullptr);
+    ptPool = VK_NULL_HANDLE;
+    destroyBuffer(ptPaths);
+    destroyBuffer(ptShadowRays);
+    destroyBuffer(ptQueues);
+    destroyBuffer(ptCounters);
+    destroyBuffer(ptAccum);
+}
 
-    if (storageView)
-        vkDestroyImageView(device, storageView, nullptr);
-    if (storageImage)
-        vkDestroyImage(device, storageImage, nullptr);
-    if (storageMemory)
-        vkFreeMemory(device, storageMemory, nullptr);
+// Push constants shared by every path-tracing dispatch of this frame size
+PtPush ptPush() {
+    PtPush pc{};
+    pc.maxBounces = opts.maxBounces;
+    pc.width      = storageExtent.width;
+    pc.height     = storageExtent.height;
+    pc.poolSize   = ptPoolSize;
+    return pc;
+}
 
-    if (dsPool)
-        vkDestroyDescriptorPool(device, dsPool, nullptr);
-    if (cmdPool)
-        vkDestroyCommandPool(device, cmdPool, nullptr);
+void ptDispatch(VkCommandBuffer cb, const PtPush &pc, VkPipeline pipe, uint32_t groups) {
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, pipe);
+    vkCmdPushConstants(cb, ptPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+    vkCmdDispatch(cb, groups, 1, 1);
+    computeBarrier(cb);
 }
 
-void recreateSwapchain(uint32_t width, uint32_t height) {
-    vkDeviceWaitIdle(device);
-    cleanupSwapchain();
-    createSwapchain(width, height);
-    createStorageImage();
-    createDescriptorSet();
-    createCommandPoolAndBuffers();
+void ptDispatchQueue(VkCommandBuffer cb, PtPush &pc, VkPipeline pipe, PtPhase phase) {
+    pc.phase = phase;
+    ptDispatch(cb, pc, ptArgs, 1);
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, pipe);
+    vkCmdDispatchIndirect(cb, ptCounters.buffer, 16 + 16 * (VkDeviceSize)phase);
+    computeBarrier(cb);
 }
 
-// One‐time record & submit per frame:
-void drawFrame(uint32_t /*unused*/, Camera &cam) {
-    // acquire
-    uint32_t imageIndex;
-    VK_CHECK(vkAcquireNextImageKHR(device, swapchain,
-        UINT64_MAX, semImageAvailable, VK_NULL_HANDLE,
-        &imageIndex));
+// One sample (seeded by pc.frame) for pixels [first, end), in pool-sized
+// chunks. ptSet must be bound.
+void recordPtSample(VkCommandBuffer cb, PtPush &pc, uint32_t first, uint32_t end) {
+    for (pc.chunkBase = first; pc.chunkBase < end; pc.chunkBase += ptPoolSize) {
+        pc.chunkSize = std::min(ptPoolSize, end - pc.chunkBase);
+        uint32_t counts[PT_QUEUE_COUNT] = { pc.chunkSize, 0, 0, 0 };
+        vkCmdUpdateBuffer(cb, ptCounters.buffer, 0, sizeof(counts), counts);
+        computeBarrier(cb);
+
+        pc.bounce = 0;
+        ptDispatch(cb, pc, ptGenerate, (pc.chunkSize + 63) / 64);
+        for (pc.bounce = 0; pc.bounce < opts.maxBounces; pc.bounce++) {
+            pc.extendIn = (pc.bounce & 1) ? PT_QUEUE_EXTEND_B : PT_QUEUE_EXTEND_A;
+            ptDispatchQueue(cb, pc, ptExtend, PT_PHASE_EXTEND);
+            ptDispatchQueue(cb, pc, ptShade,  PT_PHASE_SHADE);
+            ptDispatchQueue(cb, pc, ptShadow, PT_PHASE_SHADOW);
+        }
+    }
+}
 
-    // update camera UBO
-    void* ptr;
-    vkMapMemory(device, cameraMemory, 0,
-                sizeof(cam), 0, &ptr);
-    std::memcpy(ptr, &cam, sizeof(cam));
-    vkUnmapMemory(device, cameraMemory);
+// Record opts.samplesPerFrame progressive samples, then resolve to storageImage.
+// Accumulation restarts whenever the camera moves.
+void recordPathTrace(VkCommandBuffer cb, const Camera &cam) {
+    if (std::memcmp(&cam, &ptLastCam, sizeof(Camera)) != 0) {
+        ptLastCam     = cam;
+        ptSampleCount = 0;
+    }
+    if (ptSampleCount == 0)
+        vkCmdFillBuffer(cb, ptAccum.buffer, 0, VK_WHOLE_SIZE, 0);
 
-    // record
-    VkCommandBuffer cb = cmdBuffers[imageIndex];
-    vkResetCommandBuffer(cb, 0);
-    VkCommandBufferBeginInfo bi{};
-    bi.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    VK_CHECK(vkBeginCommandBuffer(cb, &bi));
+    vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
+        ptPipelineLayout, 0, 1, &ptSet, 0, nullptr);
+
+    PtPush pc = ptPush();
+    uint32_t pixels = pc.width * pc.height;
+    for (uint32_t s = 0; s < opts.samplesPerFrame; s++) {
+        pc.frame       = ptFrame++;
+        pc.sampleCount = ++ptSampleCount;
+        ptSamplesTraced++;
+        recordPtSample(cb, pc, 0, pixels);
+    }
 
-    // transition storageImage -> GENERAL for compute
-    {
-        VkImageMemoryBarrier barrier{};
-        barrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        barrier.oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
-        barrier.newLayout           = VK_IMAGE_LAYOUT_GENERAL;
-        barrier.image               = storageImage;
-        barrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
-        barrier.subresourceRange.levelCount     = 1;
-        barrier.subresourceRange.layerCount     = 1;
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, ptResolve);
+    vkCmdPushConstants(cb, ptPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+    vkCmdDispatch(cb,
+        (storageExtent.width  +15)/16,
+        (storageExtent.height +15)/16,
+        1);
+}
+
+void createDenoiserPipelines() {
+    sdSetLayout      = createKernelSetLayout(4);
+    sdPipelineLayout = createKernelPipelineLayout(sdSetLayout, sizeof(SdPush));
+
+    sdGBufferPass = createKernel("sd_gbuffer",   sdPipelineLayout);
+    sdTrace       = createKernel("sd_trace",     sdPipelineLayout);
+    sdTemporal    = createKernel("sd_temporal",  sdPipelineLayout);
+    sdAtrous      = createKernel("sd_atrous",    sdPipelineLayout);
+    sdComposite   = createKernel("sd_composite", sdPipelineLayout);
+}
+
+void createDenoiserResources() {
+    VkDeviceSize pixels = (VkDeviceSize)storageExtent.width * storageExtent.height;
+    const VkBufferUsageFlags ssbo = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    sdGBuffer  = createBuffer(2 * 16 * pixels, ssbo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    sdNoisy    = createBuffer(8 * pixels,      ssbo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    sdHistory  = createBuffer(2 * 16 * pixels, ssbo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    sdFiltered = createBuffer(2 * 8 * pixels,  ssbo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    sdHistoryValid = false;
+
+    sdSet = createKernelSet(sdSetLayout, { &sdGBuffer, &sdNoisy, &sdHistory, &sdFiltered }, sdPool);
+}
+
+void destroyDenoiserResources() {
+    if (sdPool)
+        vkDestroyDescriptorPool(device, sdPool, nullptr);
+    sdPool = VK_NULL_HANDLE;
+    destroyBuffer(sdGBuffer);
+    destroyBuffer(sdNoisy);
+    destroyBuffer(sdHistory);
+    destroyBuffer(sdFiltered);
+}
+
+// 1-2 stochastic shadow/AO rays per pixel, denoised temporally then spatially
+void recordDenoised(VkCommandBuffer cb, const Camera &cam) {
+    if (lastFrameMode != MODE_DENOISED)
+        sdHistoryValid = false;
+
+    SdPush pc{};
+    std::memcpy(pc.prevPos,     sdPrevCam.pos,     sizeof(float)*3);
+    std::memcpy(pc.prevForward, sdPrevCam.forward, sizeof(float)*3);
+    std::memcpy(pc.prevUp,      sdPrevCam.up,      sizeof(float)*3);
+    std::memcpy(pc.prevRight,   sdPrevCam.right,   sizeof(float)*3);
+    pc.frame        = sdFrame++;
+    pc.width        = storageExtent.width;
+    pc.height       = storageExtent.height;
+    pc.parity       = pc.frame & 1;
+    pc.historyValid = sdHistoryValid ? 1 : 0;
+    pc.rays         = opts.stochasticRays;
+
+    vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
+        sdPipelineLayout, 0, 1, &sdSet, 0, nullptr);
+    auto dispatch = [&](VkPipeline pipe) {
+        vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, pipe);
+        vkCmdPushConstants(cb, sdPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+        vkCmdDispatch(cb,
+            (storageExtent.width  +15)/16,
+            (storageExtent.height +15)/16,
+            1);
+    };
+
+    dispatch(sdGBufferPass); computeBarrier(cb);
+    dispatch(sdTrace);       computeBarrier(cb);
+    dispatch(sdTemporal);    computeBarrier(cb);
+    for (uint32_t i = 0; i < opts.atrousPasses; i++) {
+        pc.step   = 1u << i;
+        pc.srcBuf = i & 1;
+        dispatch(sdAtrous);
+        computeBarrier(cb);
+    }
+    pc.srcBuf = opts.atrousPasses & 1;
+    dispatch(sdComposite);
+
+    sdPrevCam      = cam;
+    sdHistoryValid = true;
+}
+
+void createAdaptivePipelines() {
+    vrSetLayout      = createKernelSetLayout(3);
+    vrPipelineLayout = createKernelPipelineLayout(vrSetLayout, sizeof(VrPush));
+
+    vrCoarsePass = createKernel("vr_coarse",   vrPipelineLayout);
+    vrClassify   = createKernel("vr_classify", vrPipelineLayout);
+    vrRefine     = createKernel("vr_refine",   vrPipelineLayout);
+}
+
+void createAdaptiveResources() {
+    uint32_t b = opts.vrBlockSize;
+    VkDeviceSize blocks = (VkDeviceSize)((storageExtent.width  + b-1) / b) *
+                                        ((storageExtent.height + b-1) / b);
+    VkDeviceSize grid   = (VkDeviceSize)((storageExtent.width  + b-1) / b + 1) *
+                                        ((storageExtent.height + b-1) / b + 1);
+    vrCoarse   = createBuffer(16 * grid, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    vrQueue    = createBuffer(4 * blocks, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    vrCounters = createBuffer(32, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                              VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                              VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    vrSet = createKernelSet(vrSetLayout, { &vrCoarse, &vrQueue, &vrCounters }, vrPool);
+}
+
+void destroyAdaptiveResources() {
+    if (vrPool)
+        vkDestroyDescriptorPool(device, vrPool, nullptr);
+    vrPool = VK_NULL_HANDLE;
+    destroyBuffer(vrCoarse);
+    destroyBuffer(vrQueue);
+    destroyBuffer(vrCounters);
+}
+
+void recordAdaptive(VkCommandBuffer cb) {
+    VrPush pc{};
+    pc.width          = storageExtent.width;
+    pc.height         = storageExtent.height;
+    pc.blockSize      = opts.vrBlockSize;
+    pc.gridW          = (pc.width  + pc.blockSize-1) / pc.blockSize + 1;
+    pc.gridH          = (pc.height + pc.blockSize-1) / pc.blockSize + 1;
+    pc.depthThreshold = opts.vrDepthThreshold;
+    pc.colorThreshold = opts.vrColorThreshold;
+    pc.showBlocks     = opts.vrShowBlocks ? 1 : 0;
+    vrBlocks = (pc.gridW - 1) * (pc.gridH - 1);
+
+    // refineArgs = {0,1,1}, refineCount = 0; vr_classify grows refineArgs.x
+    const uint32_t reset[5] = { 0, 1, 1, 0, 0 };
+    vkCmdUpdateBuffer(cb, vrCounters.buffer, 0, sizeof(reset), reset);
+
+    vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
+        vrPipelineLayout, 0, 1, &vrSet, 0, nullptr);
+    vkCmdPushConstants(cb, vrPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, vrCoarsePass);
+    vkCmdDispatch(cb, (pc.gridW + 15)/16, (pc.gridH + 15)/16, 1);
+    computeBarrier(cb);
+
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, vrClassify);
+    vkCmdDispatch(cb, (pc.gridW - 1 + 15)/16, (pc.gridH - 1 + 15)/16, 1);
+    computeBarrier(cb);
+
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, vrRefine);
+    vkCmdDispatchIndirect(cb, vrCounters.buffer, 0);
+}
+
+void createFoveatedPipelines() {
+    fvSetLayout      = createKernelSetLayout(1);
+    fvPipelineLayout = createKernelPipelineLayout(fvSetLayout, sizeof(FvPush));
+
+    fvRender      = createKernel("fv_render",      fvPipelineLayout);
+    fvReconstruct = createKernel("fv_reconstruct", fvPipelineLayout);
+}
+
+void createFoveatedResources() {
+    float scale = opts.foveaScale * (1.f + 0.5f * memoryPressure);
+    fvExtent.width  = std::max(1u, uint32_t(storageExtent.width  / scale));
+    fvExtent.height = std::max(1u, uint32_t(storageExtent.height / scale));
+    fvBuffer = createBuffer(16 * (VkDeviceSize)fvExtent.width * fvExtent.height,
+                            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    fvSet = createKernelSet(fvSetLayout, { &fvBuffer }, fvPool);
+}
+
+void destroyFoveatedResources() {
+    if (fvPool)
+        vkDestroyDescriptorPool(device, fvPool, nullptr);
+    fvPool = VK_NULL_HANDLE;
+    destroyBuffer(fvBuffer);
+}
+
+void recordFoveated(VkCommandBuffer cb) {
+    FvPush pc{};
+    pc.width    = storageExtent.width;
+    pc.height   = storageExtent.height;
+    pc.bufW     = fvExtent.width;
+    pc.bufH     = fvExtent.height;
+    pc.focus[0] = focusPoint[0] * pc.width;
+    pc.focus[1] = focusPoint[1] * pc.height;
+    pc.alpha    = opts.foveaAlpha;
+    // the log-polar buffer must reach the farthest image corner
+    float fx = std::max(pc.focus[0], pc.width  - pc.focus[0]);
+    float fy = std::max(pc.focus[1], pc.height - pc.focus[1]);
+    pc.logMaxR  = std::log(std::max(2.f, std::sqrt(fx*fx + fy*fy)));
+
+    vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
+        fvPipelineLayout, 0, 1, &fvSet, 0, nullptr);
+    vkCmdPushConstants(cb, fvPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, fvRender);
+    vkCmdDispatch(cb, (pc.bufW + 15)/16, (pc.bufH + 15)/16, 1);
+    computeBarrier(cb);
+
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, fvReconstruct);
+    vkCmdDispatch(cb, (pc.width + 15)/16, (pc.height + 15)/16, 1);
+}
+
+// Wrap host memory in a transfer-source buffer without copying it. ptr and
+// size must be multiples of hostPointerAlignment, and the memory must
+// outlive the buffer. False if the driver can't import it coherently.
+bool importHostBuffer(void* ptr, VkDeviceSize size, Buffer &b) {
+    const auto handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+    VkMemoryHostPointerPropertiesEXT hp{};
+    hp.sType = VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT;
+    if (pfnGetMemoryHostPointerProperties(device, handleType, ptr, &hp) != VK_SUCCESS)
+        return false;
+
+    VkExternalMemoryBufferCreateInfo ext{};
+    ext.sType       = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO;
+    ext.handleTypes = handleType;
+    VkBufferCreateInfo bci{};
+    bci.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bci.pNext = &ext;
+    bci.size  = size;
+    bci.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    VK_CHECK(vkCreateBuffer(device, &bci, nullptr, &b.buffer));
+
+    // CPU writes must be visible to the copy without flushes
+    VkMemoryRequirements mr;
+    vkGetBufferMemoryRequirements(device, b.buffer, &mr);
+    VkPhysicalDeviceMemoryProperties mp;
+    vkGetPhysicalDeviceMemoryProperties(physDevice, &mp);
+    uint32_t bits = mr.memoryTypeBits & hp.memoryTypeBits;
+    uint32_t type = UINT32_MAX;
+    for (uint32_t i = 0; i < mp.memoryTypeCount && type == UINT32_MAX; i++)
+        if ((bits & (1u << i)) &&
+            (mp.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+            type = i;
+
+    VkImportMemoryHostPointerInfoEXT imp{};
+    imp.sType        = VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT;
+    imp.handleType   = handleType;
+    imp.pHostPointer = ptr;
+    VkMemoryAllocateInfo mai{};
+    mai.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    mai.pNext           = &imp;
+    mai.allocationSize  = size;
+    mai.memoryTypeIndex = type;
+    if (type == UINT32_MAX || mr.size > size ||
+        vkAllocateMemory(device, &mai, nullptr, &b.memory) != VK_SUCCESS) {
+        vkDestroyBuffer(device, b.buffer, nullptr);
+        b = Buffer{};
+        return false;
+    }
+    VK_CHECK(vkBindBufferMemory(device, b.buffer, b.memory, 0));
+    b.size   = size;
+    b.mapped = ptr;
+    b.heap   = heapOfType(type);   // allocated stays 0, the pages are ours already
+    return true;
+}
+
+#ifdef METHARIZON_CPU_RENDER
+void createCpuResources() {
+    cpuRenderInit(storageExtent.width, storageExtent.height, opts.cpuThreads,
+                  hasExternalMemoryHost ? size_t(hostPointerAlignment) : 0);
+    VkDeviceSize size = cpuFramebufferSize();
+    bool imported = hasExternalMemoryHost && importHostBuffer(cpuFramebuffer(), size, cpuImported);
+    if (!imported)
+        for (Buffer &b : cpuStaging)
+            b = createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    static bool reported = false;
+    if (!reported)
+        std::cout << "cpu render: " << (imported ? "presenting imported host memory"
+                                                 : "presenting through a mapped staging ring") << "\n";
+    reported = true;
+
+    // one region per tile, clipped at the right and bottom edges
+    cpuRegions.clear();
+    for (uint32_t ty = 0; ty < cpuTilesY(); ty++)
+        for (uint32_t tx = 0; tx < cpuTilesX(); tx++) {
+            VkBufferImageCopy r{};
+            r.bufferOffset      = VkDeviceSize(ty * cpuTilesX() + tx) * CPU_TILE_BYTES;
+            r.bufferRowLength   = CPU_TILE;
+            r.bufferImageHeight = CPU_TILE;
+            r.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            r.imageSubresource.layerCount = 1;
+            r.imageOffset = { int32_t(tx * CPU_TILE), int32_t(ty * CPU_TILE), 0 };
+            r.imageExtent = { std::min(CPU_TILE, storageExtent.width  - tx * CPU_TILE),
+                              std::min(CPU_TILE, storageExtent.height - ty * CPU_TILE), 1 };
+            cpuRegions.push_back(r);
+        }
+    cpuStagingSlot = 0;
+}
+
+void destroyCpuResources() {
+    // imported memory must be released before the pages it wraps
+    destroyBuffer(cpuImported);
+    for (Buffer &b : cpuStaging)
+        destroyBuffer(b);
+    cpuRegions.clear();
+    cpuRenderShutdown();
+}
+
+// Render the frame on the CPU into the imported framebuffer or the next
+// staging slot. Unless it goes straight to the swapchain (direct), copy
+// it into the storage image for the HUD and headless readers.
+void recordCpu(VkCommandBuffer cb, const Camera &cam, bool direct) {
+    Buffer &src = cpuImported.buffer ? cpuImported : cpuStaging[cpuStagingSlot];
+    cpuStagingSlot = (cpuStagingSlot + 1) % CPU_STAGING_RING;
+    cpuRenderSetTarget(static_cast<uint8_t*>(src.mapped));
+    {
+        TRACE_SCOPE("cpu render");
+        cpuRenderFrame(cam);
+    }
+    cpuSource = src.buffer;
+    if (direct) return;
+
+    vkCmdCopyBufferToImage(cb, src.buffer, storageImage, VK_IMAGE_LAYOUT_GENERAL,
+                           (uint32_t)cpuRegions.size(), cpuRegions.data());
+    VkMemoryBarrier mb{};
+    mb.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    mb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(cb,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 1,&mb, 0,nullptr, 0,nullptr);
+}
+#else
+void createCpuResources() {
+    throw std::runtime_error("Built without the CPU renderer (needs GCC or Clang)");
+}
+void destroyCpuResources() {}
+void recordCpu(VkCommandBuffer, const Camera &, bool) {}
+#endif
+
+void createClockPipelines() {
+    if (!hasShaderClock) return;
+    clkSetLayout      = createKernelSetLayout(1);
+    clkPipelineLayout = createKernelPipelineLayout(clkSetLayout, sizeof(ClkPush));
+
+    clkProfile = createKernel("clk_profile", clkPipelineLayout);
+    clkHeatmap = createKernel("clk_heatmap", clkPipelineLayout);
+}
+
+void createClockResources() {
+    if (!hasShaderClock) return;
+    clkTilesX = (storageExtent.width  + 15) / 16;
+    clkTilesY = (storageExtent.height + 15) / 16;
+    clkBuffer = createBuffer(CLK_HEADER_SIZE + sizeof(ClkTile) * clkTilesX * clkTilesY,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    clkSet = createKernelSet(clkSetLayout, { &clkBuffer }, clkPool);
+}
+
+void destroyClockResources() {
+    if (clkPool)
+        vkDestroyDescriptorPool(device, clkPool, nullptr);
+    clkPool = VK_NULL_HANDLE;
+    destroyBuffer(clkBuffer);
+}
+
+void recordClockProfile(VkCommandBuffer cb) {
+    ClkPush pc{ storageExtent.width, storageExtent.height, clkTilesX };
+
+    vkCmdFillBuffer(cb, clkBuffer.buffer, 0, CLK_HEADER_SIZE, 0);
+    computeBarrier(cb);
+
+    vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
+        clkPipelineLayout, 0, 1, &clkSet, 0, nullptr);
+    vkCmdPushConstants(cb, clkPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, clkProfile);
+    vkCmdDispatch(cb, clkTilesX, clkTilesY, 1);
+    computeBarrier(cb);
+
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, clkHeatmap);
+    vkCmdDispatch(cb, clkTilesX, clkTilesY, 1);
+
+    VkMemoryBarrier mb{};
+    mb.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    mb.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    mb.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(cb,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+        0, 1,&mb, 0,nullptr, 0,nullptr);
+}
+
+const ClkTile* clockTiles() {
+    return reinterpret_cast<const ClkTile*>(
+        static_cast<const char*>(clkBuffer.mapped) + CLK_HEADER_SIZE);
+}
+
+void collectClock() {
+    const ClkTile* tiles = clockTiles();
+    for (uint32_t i = 0; i < clkTilesX * clkTilesY; i++) {
+        for (int phase = 0; phase < 3; phase++)
+            clkPhaseTotals[phase] += tiles[i].cycles(phase);
+    }
+}
+
+// Per-tile cycles of the last profiled frame. A failed write only warns,
+// the profile keeps running.
+void writeClockCsv(const std::string &path) {
+    std::ofstream f(path);
+    f << "tile_x,tile_y,march,normal,shade,total\n";
+    const ClkTile* tiles = clockTiles();
+    for (uint32_t y = 0; y < clkTilesY; y++)
+        for (uint32_t x = 0; x < clkTilesX; x++) {
+            const ClkTile &t = tiles[y*clkTilesX + x];
+            f << x << "," << y << "," << t.cycles(0) << "," << t.cycles(1) << ","
+              << t.cycles(2) << "," << t.cycles(3) << "\n";
+        }
+    f.close();
+    if (!f) std::cerr << "Failed to write " << path << ", clock CSV skipped\n";
+}
+
+void createTimestampPool() {
+    uint32_t qCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physDevice, &qCount, nullptr);
+    std::vector<VkQueueFamilyProperties> qProps(qCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physDevice, &qCount, qProps.data());
+    if (qProps[queueFamily].timestampValidBits == 0) return;
+
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(physDevice, &props);
+    timestampPeriodNs = props.limits.timestampPeriod;
+
+    VkQueryPoolCreateInfo qpci{};
+    qpci.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    qpci.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+    qpci.queryCount = STAMP_COUNT;
+    VK_CHECK(vkCreateQueryPool(device, &qpci, nullptr, &timestampPool));
+}
+
+// After the queue wait: update the GPU times and add them to the trace
+void readTimestamps(uint64_t frame, uint64_t waitEndNs) {
+    if (!timestampPool) return;
+    uint64_t stamps[STAMP_COUNT];
+    if (vkGetQueryPoolResults(device, timestampPool, 0, STAMP_COUNT, sizeof(stamps), stamps,
+                              sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+        return;
+    gpuComputeMs = (stamps[STAMP_COMPUTE] - stamps[STAMP_BEGIN])   * timestampPeriodNs / 1e6;
+    gpuHudMs     = (stamps[STAMP_HUD]     - stamps[STAMP_COMPUTE]) * timestampPeriodNs / 1e6;
+    gpuCopyMs    = (stamps[STAMP_COPY]    - stamps[STAMP_HUD])     * timestampPeriodNs / 1e6;
+    if (!traceEnabled) return;
+
+    // a (device, host) pair of the same instant anchors the conversion
+    uint64_t gpuRef = stamps[STAMP_COPY], cpuRef = waitEndNs;
+    if (hasCalibratedTimestamps) {
+        VkCalibratedTimestampInfoEXT info[2]{};
+        info[0].sType      = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+        info[0].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+        info[1].sType      = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+        info[1].timeDomain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+        uint64_t ts[2], deviation;
+        if (pfnGetCalibratedTimestamps(device, 2, info, ts, &deviation) == VK_SUCCESS) {
+            gpuRef = ts[0];
+            cpuRef = ts[1];
+        }
+    }
+    auto toCpu = [&](uint64_t t) {
+        return cpuRef - uint64_t(double(gpuRef - t) * timestampPeriodNs);
+    };
+    traceGpu("compute", toCpu(stamps[STAMP_BEGIN]),   toCpu(stamps[STAMP_COMPUTE]), frame);
+    if (stamps[STAMP_HUD] != stamps[STAMP_COMPUTE])
+        traceGpu("hud", toCpu(stamps[STAMP_COMPUTE]), toCpu(stamps[STAMP_HUD]), frame);
+    traceGpu("copy",    toCpu(stamps[STAMP_HUD]),     toCpu(stamps[STAMP_COPY]),    frame);
+}
+
+void createHudPipelines() {
+    hudSetLayout      = createKernelSetLayout(1);
+    hudPipelineLayout = createKernelPipelineLayout(hudSetLayout, sizeof(HudPush));
+    hudPipeline       = createKernel("hud", hudPipelineLayout);
+    hudBuffer = createBuffer(sizeof(HudBlock), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+}
+
+// The set references the storage image, so it follows the swapchain
+void createHudResources() {
+    hudSet = createKernelSet(hudSetLayout, { &hudBuffer }, hudPool);
+}
+
+void destroyHudResources() {
+    if (hudPool)
+        vkDestroyDescriptorPool(device, hudPool, nullptr);
+    hudPool = VK_NULL_HANDLE;
+}
+
+const char* modeName(RenderMode m) {
+    switch (m) {
+    case MODE_PATHTRACE: return "PATHTRACE";
+    case MODE_DENOISED:  return "DENOISED";
+    case MODE_ADAPTIVE:  return "ADAPTIVE";
+    case MODE_FOVEATED:  return "FOVEATED";
+    case MODE_CPU:       return "CPU";
+    default:             return "RAYMARCH";
+    }
+}
+
+// Format the HUD text from the previous frame's timings. The queue is
+// idle when drawFrame records, so the mapped block can be rewritten.
+void recordHud(VkCommandBuffer cb) {
+    HudBlock &hud = *static_cast<HudBlock*>(hudBuffer.mapped);
+
+    float avgMs = 0.f, maxMs = 0.f;
+    for (uint32_t i = 0; i < HUD_SAMPLES; i++) {
+        hud.graph[i] = hudFrameMs[(hudHead + i) % HUD_SAMPLES];
+        avgMs += hud.graph[i];
+        maxMs  = std::max(maxMs, hud.graph[i]);
+    }
+    avgMs /= HUD_SAMPLES;
+
+    // fraction of full-resolution primary rays the mode traces
+    float scale = renderMode == MODE_FOVEATED ?
+        float(fvExtent.width) * fvExtent.height / (float(storageExtent.width) * storageExtent.height) : 1.f;
+    std::vector<std::string> lines(HUD_ROWS);
+    char buf[128];
+    std::snprintf(buf, sizeof(buf), "FPS %.0f  FRAME %.2f MS  MAX %.2f MS",
+                  avgMs > 0.f ? 1000.f / avgMs : 0.f, avgMs, maxMs);
+    lines[0] = buf;
+    if (timestampPool)
+        std::snprintf(buf, sizeof(buf), "GPU %.2f MS: COMPUTE %.2f HUD %.3f COPY %.2f",
+                      gpuComputeMs + gpuHudMs + gpuCopyMs, gpuComputeMs, gpuHudMs, gpuCopyMs);
+    else
+        std::snprintf(buf, sizeof(buf), "GPU TIMESTAMPS UNAVAILABLE");
+    lines[1] = buf;
+    std::snprintf(buf, sizeof(buf), "%s %ux%u  RAY SCALE %.2f%s%s", modeName(renderMode),
+                  storageExtent.width, storageExtent.height, scale,
+                  coneAA ? "  CONE AA" : "", clockProfile ? "  CLOCK" : "");
+    lines[2] = buf;
+    lines[3] = statsEnabled ? hudStatsLine : "STATS OFF (T)";
+    lines[4] = hitchEnabled() ? "HITCH DETECTOR ON" : "";
+    VkDeviceSize used = 0, budget = 0;
+    for (uint32_t h = 0; h < heapCount; h++)
+        if (heapDeviceLocal & (1u << h)) { used += heapUsage[h]; budget += heapBudget[h]; }
+    std::snprintf(buf, sizeof(buf), "VRAM %llu/%llu MB OURS %llu MB %s",
+                  (unsigned long long)(used >> 20), (unsigned long long)(budget >> 20),
+                  (unsigned long long)(appAllocated[storageHeap] >> 20),
+                  memoryPressure ? PRESSURE_NAMES[memoryPressure] : "");
+    lines[5] = buf;
+
+    uint32_t rows = 0;
+    for (uint32_t r = 0; r < HUD_ROWS; r++) {
+        for (uint32_t c = 0; c < HUD_COLS; c++) {
+            char ch = c < lines[r].size() ? lines[r][c] : ' ';
+            hud.text[r*HUD_COLS + c] = (uint32_t)std::toupper((unsigned char)ch);
+        }
+        if (!lines[r].empty()) rows = r + 1;
+    }
+
+    HudPush pc{};
+    pc.origin[0]  = 8;
+    pc.origin[1]  = 8;
+    pc.scale      = std::max(1, int(storageExtent.height) / 400);
+    pc.rows       = (int32_t)rows;
+    pc.budgetMs   = 1000.f / 60.f;
+    pc.graphMaxMs = std::max(2.f * pc.budgetMs, maxMs);
+
+    computeBarrier(cb);
+    vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
+        hudPipelineLayout, 0, 1, &hudSet, 0, nullptr);
+    vkCmdPushConstants(cb, hudPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, hudPipeline);
+    vkCmdDispatch(cb, (HUD_PANEL_W * pc.scale + 15) / 16, (HUD_PANEL_H * pc.scale + 15) / 16, 1);
+}
+
+struct ModeResources {
+    void (*create)();
+    void (*destroy)();
+    bool onDemand;       // only created once the mode is selected
+};
+const ModeResources MODE_RESOURCES[MODE_COUNT] = {
+    { nullptr,                   nullptr,                    false },
+    { createPathTracerResources, destroyPathTracerResources, false },
+    { createDenoiserResources,   destroyDenoiserResources,   false },
+    { createAdaptiveResources,   destroyAdaptiveResources,   false },
+    { createFoveatedResources,   destroyFoveatedResources,   false },
+    { createCpuResources,        destroyCpuResources,        true },   // spawns the worker pool
+};
+
+// Under memory pressure, free every mode's buffers but the active one's
+void releaseInactiveModes() {
+    if (memoryPressure == PRESSURE_NORMAL) return;
+    bool idle = false;
+    for (int m = 0; m < MODE_COUNT; m++) {
+        if (!modeLive[m] || m == renderMode) continue;
+        if (!idle) VK_CHECK(vkQueueWaitIdle(queue));
+        idle = true;
+        MODE_RESOURCES[m].destroy();
+        modeLive[m] = false;
+    }
+}
+
+// Every mode keeps its buffers for instant switching, unless memory is
+// short; then only the active mode's exist and switching creates them.
+// On-demand modes are never created ahead of use.
+void createModeResources() {
+    releaseInactiveModes();
+    for (int m = 0; m < MODE_COUNT; m++) {
+        if (!MODE_RESOURCES[m].create || modeLive[m]) continue;
+        if ((memoryPressure != PRESSURE_NORMAL || MODE_RESOURCES[m].onDemand) && m != renderMode)
+            continue;
+        MODE_RESOURCES[m].create();
+        modeLive[m] = true;
+    }
+}
+
+void destroyModeResources() {
+    for (int m = 0; m < MODE_COUNT; m++) {
+        if (modeLive[m]) MODE_RESOURCES[m].destroy();
+        modeLive[m] = false;
+    }
+}
+
+// Refresh usage and budget per heap and react to pressure changes. Levels
+// step down one at a time, and only well below the threshold that raised
+// them, so freeing our own buffers cannot make the level oscillate.
+void updateMemoryBudget() {
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT mb{};
+    mb.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    VkPhysicalDeviceMemoryProperties2 mp2{};
+    mp2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    mp2.pNext = hasMemoryBudget ? &mb : nullptr;
+    vkGetPhysicalDeviceMemoryProperties2(physDevice, &mp2);
+    const VkPhysicalDeviceMemoryProperties &mp = mp2.memoryProperties;
+
+    double worst = 0.0;
+    heapCount       = mp.memoryHeapCount;
+    heapDeviceLocal = 0;
+    for (uint32_t h = 0; h < heapCount; h++) {
+        heapBudget[h] = hasMemoryBudget ? mb.heapBudget[h] : mp.memoryHeaps[h].size;
+        heapUsage[h]  = hasMemoryBudget ? mb.heapUsage[h]  : appAllocated[h];
+        if (!(mp.memoryHeaps[h].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) || !heapBudget[h])
+            continue;
+        heapDeviceLocal |= 1u << h;
+        worst = std::max(worst, double(heapUsage[h]) / heapBudget[h]);
+    }
+
+    MemoryPressure level = worst >= 0.95 ? PRESSURE_CRITICAL :
+                           worst >= 0.85 ? PRESSURE_HIGH : PRESSURE_NORMAL;
+    if (level < memoryPressure)
+        level = worst > (memoryPressure == PRESSURE_CRITICAL ? 0.85 : 0.70) ?
+                memoryPressure : MemoryPressure(memoryPressure - 1);
+    if (level == memoryPressure) return;
+
+    std::cout << "memory: pressure " << PRESSURE_NAMES[memoryPressure] << " -> "
+              << PRESSURE_NAMES[level] << " (" << int(worst * 100) << "% of budget)\n";
+    traceInstant("memory pressure");
+    vkDeviceWaitIdle(device);
+    destroyModeResources();
+    destroyBuffer(readbackBuffer);   // the next readback recreates it
+    memoryPressure = level;
+    createModeResources();
+}
+
+void printMemoryReport() {
+    for (uint32_t h = 0; h < heapCount; h++)
+        std::cout << "memory: heap " << h << ((heapDeviceLocal >> h) & 1 ? " (device)" : " (host)")
+                  << " " << (heapUsage[h] >> 20) << " / " << (heapBudget[h] >> 20)
+                  << " MiB, renderer " << (appAllocated[h] >> 20) << " MiB\n";
+}
+
+void createCommandPoolAndBuffers() {
+    VkCommandPoolCreateInfo cpi{};
+    cpi.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    cpi.queueFamilyIndex = queueFamily;
+    VK_CHECK(vkCreateCommandPool(device, &cpi, nullptr, &cmdPool));
+
+    cmdBuffers.resize(std::max<size_t>(1, swapImageViews.size()));
+    VkCommandBufferAllocateInfo cbai{};
+    cbai.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    cbai.commandPool        = cmdPool;
+    cbai.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    cbai.commandBufferCount = (uint32_t)cmdBuffers.size();
+    VK_CHECK(vkAllocateCommandBuffers(device, &cbai, cmdBuffers.data()));
+}
+
+void createSyncObjects() {
+    VkSemaphoreCreateInfo sci{};
+    sci.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    VK_CHECK(vkCreateSemaphore(device, &sci, nullptr, &semImageAvailable));
+    VK_CHECK(vkCreateSemaphore(device, &sci, nullptr, &semRenderFinished));
+}
+
+void cleanupSwapchain() {
+    for (auto view : swapImageViews)
+        vkDestroyImageView(device, view, nullptr);
+    swapImageViews.clear();
+    if (swapchain)
+        vkDestroySwapchainKHR(device, swapchain, nullptr);
+
+    if (storageView)
+        vkDestroyImageView(device, storageView, nullptr);
+    if (storageImage)
+        vkDestroyImage(device, storageImage, nullptr);
+    if (storageMemory)
+        vkFreeMemory(device, storageMemory, nullptr);
+    appAllocated[storageHeap] -= storageAllocated;
+    storageAllocated = 0;
+    storageMapped    = nullptr;
+    destroyBuffer(readbackBuffer);
+
+    if (dsPool)
+        vkDestroyDescriptorPool(device, dsPool, nullptr);
+    destroyModeResources();
+    destroyClockResources();
+    destroyHudResources();
+    if (cmdPool)
+        vkDestroyCommandPool(device, cmdPool, nullptr);
+}
+
+void recreateSwapchain(uint32_t width, uint32_t height) {
+    traceInstant("swapchain recreate");
+    vkDeviceWaitIdle(device);
+    cleanupSwapchain();
+    if (opts.headless)
+        swapchainExtent = { width, height };
+    else
+        createSwapchain(width, height);
+    createStorageImage();
+    createDescriptorSet();
+    createModeResources();
+    createClockResources();
+    createHudResources();
+    createCommandPoolAndBuffers();
+}
+
+void updateCameraBuffer(const Camera &cam) {
+    void* ptr;
+    vkMapMemory(device, cameraMemory, 0,
+                sizeof(cam), 0, &ptr);
+    std::memcpy(ptr, &cam, sizeof(cam));
+    vkUnmapMemory(device, cameraMemory);
+}
+
+// Make the frame in storageImage (TRANSFER_SRC_OPTIMAL) readable by
+// frameReadback: readers map a linear storage image in place, which needs
+// GENERAL; otherwise the frame is copied out when someone asked for it
+void recordReadback(VkCommandBuffer cb) {
+    if (storageLinear) {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout           = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.image               = storageImage;
+        barrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.levelCount     = 1;
+        barrier.subresourceRange.layerCount     = 1;
+        barrier.srcAccessMask       = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.dstAccessMask       = VK_ACCESS_HOST_READ_BIT;
+
+        vkCmdPipelineBarrier(cb,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_HOST_BIT,
+            0,0,nullptr,0,nullptr,
+            1,&barrier);
+    } else if (readbackPending) {
+        VkDeviceSize size = 4 * (VkDeviceSize)storageExtent.width * storageExtent.height;
+        if (readbackBuffer.size != size) {
+            destroyBuffer(readbackBuffer);
+            readbackBuffer = createBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        }
+        VkBufferImageCopy region{};
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = { storageExtent.width, storageExtent.height, 1 };
+        vkCmdCopyImageToBuffer(cb, storageImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                               readbackBuffer.buffer, 1, &region);
+
+        VkMemoryBarrier mb{};
+        mb.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        mb.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(cb,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+            0, 1,&mb, 0,nullptr, 0,nullptr);
+    }
+}
+
+// One‐time record & submit per frame:
+void drawFrame(uint32_t /*unused*/, Camera &cam) {
+    // switching modes under memory pressure frees the old mode's buffers
+    // and creates the new one's
+    releaseInactiveModes();
+    if (MODE_RESOURCES[renderMode].create && !modeLive[renderMode])
+        createModeResources();
+
+    // acquire; headless frames stop at the storage image
+    uint32_t imageIndex = 0;
+    if (!opts.headless) {
+        TRACE_SCOPE("acquire");
+        VK_CHECK(vkAcquireNextImageKHR(device, swapchain,
+            UINT64_MAX, semImageAvailable, VK_NULL_HANDLE,
+            &imageIndex));
+    }
+    uint64_t recordBegin = traceEnabled ? traceNowNs() : 0;
+
+    updateCameraBuffer(cam);
+
+    // record
+    VkCommandBuffer cb = cmdBuffers[imageIndex];
+    vkResetCommandBuffer(cb, 0);
+    VkCommandBufferBeginInfo bi{};
+    bi.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    VK_CHECK(vkBeginCommandBuffer(cb, &bi));
+    if (timestampPool) {
+        vkCmdResetQueryPool(cb, timestampPool, 0, STAMP_COUNT);
+        vkCmdWriteTimestamp(cb, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool, STAMP_BEGIN);
+    }
+
+    // transition storageImage -> GENERAL for compute (and MODE_CPU's copy)
+    {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout           = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.image               = storageImage;
+        barrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.levelCount     = 1;
+        barrier.subresourceRange.layerCount     = 1;
         barrier.srcAccessMask       = 0;
-        barrier.dstAccessMask       = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask       = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
 
         vkCmdPipelineBarrier(cb,
             VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
             0, 0,nullptr, 0,nullptr,
             1,&barrier);
     }
 
-    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
-    vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
-        pipelineLayout, 0, 1, &ds, 0, nullptr);
+    // CPU frames skip the storage image unless the HUD or a reader needs it
+    bool cpuDirect = renderMode == MODE_CPU && !opts.headless && !hudEnabled && !readbackPending;
+    statsWritten = false;
+    if (renderMode == MODE_PATHTRACE) {
+        recordPathTrace(cb, cam);
+    } else if (renderMode == MODE_DENOISED) {
+        recordDenoised(cb, cam);
+    } else if (renderMode == MODE_ADAPTIVE) {
+        recordAdaptive(cb);
+    } else if (renderMode == MODE_FOVEATED) {
+        recordFoveated(cb);
+    } else if (renderMode == MODE_CPU) {
+        recordCpu(cb, cam, cpuDirect);
+    } else if (clockProfile && hasShaderClock) {
+        recordClockProfile(cb);
+    } else {
+        if (statsEnabled) {
+            vkCmdFillBuffer(cb, statsBuffer.buffer, 0, VK_WHOLE_SIZE, 0);
+            computeBarrier(cb);
+        }
 
-    vkCmdDispatch(cb,
-        (storageExtent.width  +15)/16,
-        (storageExtent.height +15)/16,
-        1);
+        vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, getComputeVariant(currentSpec()));
+        vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
+            pipelineLayout, 0, 1, &ds, 0, nullptr);
+
+        vkCmdDispatch(cb,
+            (storageExtent.width  +15)/16,
+            (storageExtent.height +15)/16,
+            1);
+
+        if (statsEnabled) {
+            VkMemoryBarrier mb{};
+            mb.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            mb.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            mb.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+            vkCmdPipelineBarrier(cb,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+                0, 1,&mb, 0,nullptr, 0,nullptr);
+            statsWritten = true;
+        }
+    }
+    lastFrameMode = renderMode;
+    if (timestampPool)
+        vkCmdWriteTimestamp(cb, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, timestampPool, STAMP_COMPUTE);
+    if (hudEnabled)
+        recordHud(cb);
+    if (timestampPool)
+        vkCmdWriteTimestamp(cb, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, timestampPool, STAMP_HUD);
 
     // transition storageImage -> TRANSFER_SRC
     {
@@ -575,7 +2337,7 @@ void drawFrame(uint32_t /*unused*/, Camera &cam) {
     }
 
     // transition swapchain image -> TRANSFER_DST
-    {
+    if (!opts.headless) {
         VkImageMemoryBarrier barrier{};
         barrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
         barrier.oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -594,8 +2356,12 @@ void drawFrame(uint32_t /*unused*/, Camera &cam) {
             1,&barrier);
     }
 
-    // copy storage -> swapchain
-    {
+    // copy storage (or the CPU frame's buffer) -> swapchain
+    if (cpuDirect) {
+        vkCmdCopyBufferToImage(cb, cpuSource,
+            swapImages[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            (uint32_t)cpuRegions.size(), cpuRegions.data());
+    } else if (!opts.headless) {
         VkImageCopy copyRegion{};
         // source subresource
         copyRegion.srcSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -624,8 +2390,12 @@ void drawFrame(uint32_t /*unused*/, Camera &cam) {
             1, &copyRegion);
     }
 
+    recordReadback(cb);
+    if (timestampPool)
+        vkCmdWriteTimestamp(cb, VK_PIPELINE_STAGE_TRANSFER_BIT, timestampPool, STAMP_COPY);
+
     // transition swapchain -> PRESENT_SRC
-    {
+    if (!opts.headless) {
         VkImageMemoryBarrier barrier{};
         barrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
         barrier.oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
@@ -645,20 +2415,25 @@ void drawFrame(uint32_t /*unused*/, Camera &cam) {
     }
 
     VK_CHECK(vkEndCommandBuffer(cb));
+    if (traceEnabled)
+        traceCpu("record", recordBegin, traceNowNs());
 
     // submit
     VkSubmitInfo si{};
     si.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    si.waitSemaphoreCount   = 1;
+    si.waitSemaphoreCount   = opts.headless ? 0 : 1;
     si.pWaitSemaphores      = &semImageAvailable;
     VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_TRANSFER_BIT };
     si.pWaitDstStageMask    = waitStages;
     si.commandBufferCount   = 1;
     si.pCommandBuffers      = &cb;
-    si.signalSemaphoreCount = 1;
+    si.signalSemaphoreCount = opts.headless ? 0 : 1;
     si.pSignalSemaphores    = &semRenderFinished;
 
-    VK_CHECK(vkQueueSubmit(queue, 1, &si, VK_NULL_HANDLE));
+    {
+        TRACE_SCOPE("submit");
+        VK_CHECK(vkQueueSubmit(queue, 1, &si, VK_NULL_HANDLE));
+    }
 
     // present
     VkPresentInfoKHR pi{};
@@ -669,25 +2444,981 @@ void drawFrame(uint32_t /*unused*/, Camera &cam) {
     pi.pSwapchains        = &swapchain;
     pi.pImageIndices      = &imageIndex;
 
-    VK_CHECK(vkQueuePresentKHR(queue, &pi));
-    vkQueueWaitIdle(queue);
+    if (!opts.headless) {
+        TRACE_SCOPE("present");
+        VK_CHECK(vkQueuePresentKHR(queue, &pi));
+    }
+    {
+        TRACE_SCOPE("wait");
+        auto waitBegin = now();
+        vkQueueWaitIdle(queue);
+        lastWaitMs = std::chrono::duration<double, std::milli>(now() - waitBegin).count();
+    }
+    readTimestamps(frameIndex, traceNowNs());
+    frameIndex++;
+}
+
+// RGBA8 pixels of the frame drawFrame just finished, rowPitch bytes apart.
+// That frame must have been drawn with readbackPending set. Valid until
+// the next drawFrame.
+const uint8_t* frameReadback(VkDeviceSize &rowPitch) {
+    if (storageLinear) {
+        if (!storageCoherent) {
+            VkMappedMemoryRange range{};
+            range.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+            range.memory = storageMemory;
+            range.size   = VK_WHOLE_SIZE;
+            VK_CHECK(vkInvalidateMappedMemoryRanges(device, 1, &range));
+        }
+        rowPitch = storageRowPitch;
+        return static_cast<const uint8_t*>(storageMapped);
+    }
+    rowPitch = 4 * VkDeviceSize(storageExtent.width);
+    return static_cast<const uint8_t*>(readbackBuffer.mapped);
+}
+
+void writePpm(const std::string &path) {
+    VkDeviceSize pitch;
+    const uint8_t* px = frameReadback(pitch);
+    std::ofstream out(path, std::ios::binary);
+    if (!out) throw std::runtime_error("Failed to open " + path);
+    out << "P6\n" << storageExtent.width << " " << storageExtent.height << "\n255\n";
+    std::vector<char> row(3 * storageExtent.width);
+    for (uint32_t y = 0; y < storageExtent.height; y++) {
+        const uint8_t* src = px + y * pitch;
+        for (uint32_t x = 0; x < storageExtent.width; x++)
+            std::memcpy(&row[3*x], src + 4*x, 3);
+        out.write(row.data(), row.size());
+    }
 }
 
-int main() {
+// Hand the frame to the readers it was kept for
+void consumeReadback() {
+    if (opts.readback) {
+        VkDeviceSize pitch;
+        const uint8_t* px = frameReadback(pitch);
+        uint32_t sum = 0;
+        for (uint32_t y = 0; y < storageExtent.height; y++)
+            for (uint32_t i = 0; i < 4 * storageExtent.width; i++)
+                sum += px[y * pitch + i];
+        readbackSum += sum;
+    }
+    if (!opts.recordPrefix.empty()) {
+        char name[16];
+        std::snprintf(name, sizeof(name), "%06u.ppm", recordedFrames++);
+        writePpm(opts.recordPrefix + name);
+    }
+    if (screenshotPending) {
+        std::string path = "screenshot-" + std::to_string(frameIndex - 1) + ".ppm";
+        writePpm(path);
+        std::cout << "screenshot: " << path << "\n";
+        screenshotPending = false;
+    }
+}
+
+const Scene* findScene(const std::string &name) {
+    for (const Scene &s : SCENES)
+        if (name == s.name) return &s;
+    return nullptr;
+}
+
+// Switch to the scene's mode and return its camera orientation
+Quat applyScene(const Scene &scene, Camera &cam) {
+    renderMode = scene.mode;
+    coneAA     = scene.coneAA;
+    std::copy(scene.pos, scene.pos + 3, cam.pos);
+    Quat rot = quatFromAxisAngle(BASE_UP, scene.yaw);
+    float rightAxis[3];
+    rotateVec(rot, BASE_RIGHT, rightAxis);
+    rot = quatMul(quatFromAxisAngle(rightAxis, scene.pitch), rot);
+    quatNormalize(rot);
+    rotateVec(rot, BASE_FORWARD, cam.forward);
+    rotateVec(rot, BASE_UP,      cam.up);
+    rotateVec(rot, BASE_RIGHT,   cam.right);
+    return rot;
+}
+
+// Headless benchmark run: warm up, then sceneTrials timed runs of
+// sceneFrames frames, then a few STATS frames for the march work per
+// pixel (raymarch scenes only, the counters come from comp.glsl). Writes
+// the per-trial means to opts.sceneReport for the regression gate.
+void runHeadlessScene() {
+    const Scene* scene = findScene(opts.scene);
+    if (!scene) throw std::runtime_error("Unknown scene '" + opts.scene + "' (--list-scenes)");
+    Camera cam{};
+    applyScene(*scene, cam);
+    bool timestamps = timestampPool != VK_NULL_HANDLE;
+    readbackPending = opts.readback || !opts.recordPrefix.empty();
+    std::cout << "scene " << scene->name << " on " << deviceName << ", "
+              << storageExtent.width << "x" << storageExtent.height << "\n";
+
+    for (uint32_t i = 0; i < opts.warmupFrames; i++)
+        drawFrame(0, cam);
+
+    std::vector<double> frameMs, cpuMs, gpuMs;
+    for (uint32_t t = 0; t < opts.sceneTrials; t++) {
+        double frame = 0, cpu = 0, gpu = 0;
+        for (uint32_t i = 0; i < opts.sceneFrames; i++) {
+            auto t0 = now();
+            drawFrame(0, cam);
+            if (readbackPending)
+                consumeReadback();
+            double ms = std::chrono::duration<double, std::milli>(now() - t0).count();
+            frame += ms;
+            cpu   += ms - lastWaitMs;
+            gpu   += gpuComputeMs + gpuHudMs + gpuCopyMs;
+        }
+        frameMs.push_back(frame / opts.sceneFrames);
+        cpuMs.push_back(cpu / opts.sceneFrames);
+        gpuMs.push_back(gpu / opts.sceneFrames);
+        std::cout << "trial " << t << ": frame " << frameMs.back() << " ms, cpu "
+                  << cpuMs.back() << " ms";
+        if (timestamps) std::cout << ", gpu " << gpuMs.back() << " ms";
+        std::cout << "\n";
+    }
+
+    double stepsPerPx = -1.0;
+    if (scene->mode == MODE_RAYMARCH) {
+        statsEnabled = true;
+        statsTotals  = StatsTotals{};
+        for (int i = 0; i < 3; i++) {
+            drawFrame(0, cam);
+            collectStats();
+        }
+        statsEnabled = false;
+        uint64_t pixels = statsTotals.hits + statsTotals.misses + statsTotals.capped;
+        if (pixels) stepsPerPx = double(statsTotals.steps) / pixels;
+        std::cout << "steps/px: " << stepsPerPx << "\n";
+    }
+    if (opts.readback)
+        std::cout << "readback: " << (storageLinear ? "in place" : "copied")
+                  << ", checksum " << readbackSum << "\n";
+    if (!opts.screenshot.empty()) {
+        readbackPending = true;
+        drawFrame(0, cam);
+        writePpm(opts.screenshot);
+    }
+
+    if (opts.sceneReport.empty()) return;
+    std::ofstream out(opts.sceneReport);
+    if (!out) throw std::runtime_error("Failed to open " + opts.sceneReport);
+    auto list = [&](const char* key, const std::vector<double> &v) {
+        out << ",\"" << key << "\":[";
+        for (size_t i = 0; i < v.size(); i++) out << (i ? "," : "") << v[i];
+        out << "]";
+    };
+    out << std::setprecision(9);
+    out << "{\"scene\":";
+    jsonWriteString(out, scene->name);
+    out << ",\"device\":";
+    jsonWriteString(out, deviceName);
+    out << ",\"width\":" << storageExtent.width << ",\"height\":" << storageExtent.height
+        << ",\"warmup\":" << opts.warmupFrames << ",\"frames\":" << opts.sceneFrames;
+    list("frame_ms", frameMs);
+    list("cpu_ms", cpuMs);
+    if (timestamps) list("gpu_ms", gpuMs);
+    if (stepsPerPx >= 0.0) out << ",\"steps_per_px\":" << stepsPerPx;
+    out << "}\n";
+}
+
+// Record into cmdBuffers[0], submit and wait: one-off work outside drawFrame
+template <typename Record>
+void submitOnce(Record &&record) {
+    VkCommandBuffer cb = cmdBuffers[0];
+    vkResetCommandBuffer(cb, 0);
+    VkCommandBufferBeginInfo bi{};
+    bi.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    VK_CHECK(vkBeginCommandBuffer(cb, &bi));
+    record(cb);
+    VK_CHECK(vkEndCommandBuffer(cb));
+    VkSubmitInfo si{};
+    si.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    si.commandBufferCount = 1;
+    si.pCommandBuffers    = &cb;
+    VK_CHECK(vkQueueSubmit(queue, 1, &si, VK_NULL_HANDLE));
+    VK_CHECK(vkQueueWaitIdle(queue));
+}
+
+// Copy pixels [first, end) of ptAccum to the start of a host-visible buffer
+void readAccum(const Buffer &dst, uint32_t first, uint32_t end) {
+    submitOnce([&](VkCommandBuffer cb) {
+        VkBufferCopy back{ 16 * VkDeviceSize(first), 0, 16 * VkDeviceSize(end - first) };
+        vkCmdCopyBuffer(cb, ptAccum.buffer, dst.buffer, 1, &back);
+        VkMemoryBarrier mb{};
+        mb.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        mb.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(cb,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+            0, 1,&mb, 0,nullptr, 0,nullptr);
+    });
+}
+
+// Samples [from, from + count) of pixels [first, end) into ptAccum
+void tracePtSamples(uint32_t first, uint32_t end, uint32_t from, uint32_t count) {
+    submitOnce([&](VkCommandBuffer cb) {
+        vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
+            ptPipelineLayout, 0, 1, &ptSet, 0, nullptr);
+        PtPush pc = ptPush();
+        for (uint32_t s = 0; s < count; s++) {
+            pc.frame = from + s;
+            recordPtSample(cb, pc, first, end);
+        }
+    });
+}
+
+// spp accumulated samples per pixel to RGB8, as pt_resolve.glsl does
+void resolveAccum(const float* accum, size_t pixels, uint32_t spp, uint8_t* rgb) {
+    for (size_t i = 0; i < 3 * pixels; i++) {
+        float c = 1.f - std::exp(-accum[4 * (i / 3) + i % 3] / spp);
+        rgb[i] = uint8_t(std::pow(c, 1.f / 2.2f) * 255.f + 0.5f);
+    }
+}
+
+// Offline path-traced still (--offline): offlineSpp samples per pixel, a
+// band of tileRows rows at a time. A band's accumulation goes to the
+// checkpoint every checkpointSecs and when it completes, so a restarted
+// job skips finished bands and continues the current one bit for bit:
+// samples are seeded by their index, not by a running frame counter.
+void runOffline() {
+    const Scene* scene = findScene(opts.scene.empty() ? "overview" : opts.scene);
+    if (!scene) throw std::runtime_error("Unknown scene '" + opts.scene + "' (--list-scenes)");
+    Camera cam{};
+    applyScene(*scene, cam);
+    renderMode = MODE_PATHTRACE;
+    if (!modeLive[MODE_PATHTRACE])
+        createModeResources();
+    updateCameraBuffer(cam);
+
+    uint32_t w = storageExtent.width, h = storageExtent.height;
+    uint32_t spp   = opts.offlineSpp;
+    uint32_t rows  = std::min(opts.tileRows, h);
+    uint32_t tiles = (h + rows - 1) / rows;
+    size_t tileBytes = size_t(16) * rows * w;   // one accum vec4 per pixel
+
+    // everything that decides the pixels, bar the shaders, names the job
+    uint32_t params[] = { 1u, w, h, rows, spp, opts.maxBounces };
+    uint64_t job = checksum64(params, sizeof(params), checksum64(&cam, sizeof(cam)));
+    std::string ckpt = opts.checkpointFile.empty() ? opts.offlineOut + ".ckpt" : opts.checkpointFile;
+    bool resumed = checkpointOpen(ckpt, job, tiles, tileBytes);
+
+    uint32_t complete = 0, partial = 0;
+    for (uint32_t t = 0; t < tiles; t++) {
+        uint32_t s = checkpointSamples(t);
+        complete += s >= spp;
+        partial  += s && s < spp;
+    }
+    std::cout << "offline: " << scene->name << " " << w << "x" << h << ", " << spp << " spp, "
+              << tiles << " tiles of " << rows << " rows, checkpoint " << ckpt;
+    if (resumed)
+        std::cout << " (resuming: " << complete << " tiles done, " << partial << " partial)";
+    std::cout << "\n";
+
+    Buffer staging = createBuffer(tileBytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    auto start = now(), lastCheckpoint = start;
+    for (uint32_t t = 0; t < tiles; t++) {
+        uint32_t samples = checkpointSamples(t);
+        if (samples >= spp) continue;
+        uint32_t first = t * rows * w, end = std::min(h, (t + 1) * rows) * w;
+        VkBufferCopy region{ 0, 16 * VkDeviceSize(first), 16 * VkDeviceSize(end - first) };
+
+        // restore the band's accumulation, or start it from zero
+        if (samples)
+            checkpointLoad(t, staging.mapped);
+        submitOnce([&](VkCommandBuffer cb) {
+            if (samples)
+                vkCmdCopyBuffer(cb, staging.buffer, ptAccum.buffer, 1, &region);
+            else
+                vkCmdFillBuffer(cb, ptAccum.buffer, region.dstOffset, region.size, 0);
+            computeBarrier(cb);
+        });
+
+        while (samples < spp) {
+            uint32_t batch = std::min(opts.samplesPerFrame, spp - samples);
+            tracePtSamples(first, end, samples, batch);
+            samples += batch;
+
+            float since = std::chrono::duration<float>(now() - lastCheckpoint).count();
+            if (samples < spp && since < opts.checkpointSecs) continue;
+            readAccum(staging, first, end);
+            checkpointStore(t, samples, staging.mapped);
+            lastCheckpoint = now();
+        }
+        std::cout << "offline: tile " << t + 1 << "/" << tiles << " done, "
+                  << std::chrono::duration<double>(now() - start).count() << " s\n";
+    }
+
+    // resolve from the checkpoint
+    std::ofstream out(opts.offlineOut, std::ios::binary);
+    if (!out) throw std::runtime_error("Failed to open " + opts.offlineOut);
+    out << "P6\n" << w << " " << h << "\n255\n";
+    std::vector<uint8_t> band(size_t(3) * w * rows);
+    for (uint32_t t = 0; t < tiles; t++) {
+        checkpointLoad(t, staging.mapped);
+        size_t pixels = size_t(std::min(h, (t + 1) * rows) - t * rows) * w;
+        resolveAccum(static_cast<const float*>(staging.mapped), pixels, spp, band.data());
+        out.write(reinterpret_cast<const char*>(band.data()), 3 * pixels);
+    }
+    out.close();
+    if (!out) throw std::runtime_error("Failed to write " + opts.offlineOut);
+    checkpointClose();
+    destroyBuffer(staging);
+    std::remove(ckpt.c_str());
+    std::cout << "offline: wrote " << opts.offlineOut << "\n";
+}
+
+// Cluster worker (--worker): render the coordinator's bands as runOffline
+// would, without checkpoints, until it hangs up. A band it can't render
+// (size mismatch, unknown scene) is reported and ends the session, so the
+// coordinator hands it to someone else.
+void runWorker() {
+    int fd = clusterConnect(opts.workerSocket, deviceName);
+    renderMode = MODE_PATHTRACE;
+    if (!modeLive[MODE_PATHTRACE])
+        createModeResources();
+    uint32_t w = storageExtent.width, h = storageExtent.height;
+    Buffer staging{};
+    ClusterJob job;
+    uint32_t bands = 0;
+    while (clusterNextJob(fd, job)) {
+        const Scene* scene = findScene(job.scene);
+        std::string error;
+        if (!scene)
+            error = std::string("unknown scene ") + job.scene;
+        else if (job.width != w || job.height != h || job.y0 + job.rows > h || !job.spp)
+            error = "job does not fit the " + std::to_string(w) + "x" + std::to_string(h) + " image";
+        if (!error.empty()) {
+            clusterSendError(fd, error);
+            break;
+        }
+
+        Camera cam{};
+        applyScene(*scene, cam);
+        updateCameraBuffer(cam);
+        opts.maxBounces = job.bounces;
+        uint32_t first = job.y0 * w, end = (job.y0 + job.rows) * w;
+        VkDeviceSize bytes = 16 * VkDeviceSize(end - first);
+        if (staging.size < bytes) {
+            destroyBuffer(staging);
+            staging = createBuffer(bytes, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        }
+        submitOnce([&](VkCommandBuffer cb) {
+            vkCmdFillBuffer(cb, ptAccum.buffer, 16 * VkDeviceSize(first), bytes, 0);
+            computeBarrier(cb);
+        });
+        for (uint32_t s = 0; s < job.spp; s += opts.samplesPerFrame)
+            tracePtSamples(first, end, s, std::min(opts.samplesPerFrame, job.spp - s));
+        readAccum(staging, first, end);
+
+        std::vector<uint8_t> rgb(size_t(3) * (end - first));
+        resolveAccum(static_cast<const float*>(staging.mapped), end - first, job.spp, rgb.data());
+        if (!clusterSendResult(fd, job, rgb)) break;
+        bands++;
+    }
+    destroyBuffer(staging);
+    clusterClose(fd);
+    std::cout << "worker: " << bands << " bands on " << deviceName << "\n";
+}
+
+// Camera update inside a command buffer, between dispatches that read it
+void recordCameraUpdate(VkCommandBuffer cb, const Camera &cam) {
+    VkMemoryBarrier mb{};
+    mb.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    vkCmdPipelineBarrier(cb,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 1,&mb, 0,nullptr, 0,nullptr);
+    vkCmdUpdateBuffer(cb, cameraBuffer, 0, sizeof(cam), &cam);
+    mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    mb.dstAccessMask = VK_ACCESS_UNIFORM_READ_BIT;
+    vkCmdPipelineBarrier(cb,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 1,&mb, 0,nullptr, 0,nullptr);
+}
+
+// Render daemon (--serve): device, pipelines and buffers stay up between
+// requests. Requests that arrive within serveWindowMs of each other and
+// agree on size and quality share one command buffer, one submit and one
+// wait, at most DAEMON_BATCH at a time; only a change of size costs a
+// storage image rebuild. Results go to the client's shared memory.
+const uint32_t DAEMON_BATCH = 16;
+
+// Everything that decides a daemon result's pixels, for the result cache:
+// the camera as rendered, so a scene and its explicit pose share entries,
+// the formula, quality and output format, and rendererId (device, driver
+// and shaders) so a different renderer misses. Rendering is deterministic
+// (path-traced samples are seeded by index), so a hit is exact.
+std::string rendererId;
+
+std::string resultKey(const DaemonRequest &r, const Camera &cam) {
+    struct {
+        float    camera[12];
+        float    power;
+        uint32_t width, height, quality, spp, bounces, format;
+    } k{};
+    const float* vecs[] = { cam.pos, cam.forward, cam.up, cam.right };
+    for (int v = 0; v < 4; v++)
+        for (int i = 0; i < 3; i++)
+            k.camera[3*v + i] = vecs[v][i] == 0.f ? 0.f : vecs[v][i];   // -0 == 0
+    k.power   = r.power;
+    k.width   = r.width;
+    k.height  = r.height;
+    k.quality = r.quality == "pathtrace" ? 2 : r.quality == "aa" ? 1 : 0;
+    if (k.quality == 2) {
+        k.spp     = r.spp;
+        k.bounces = r.bounces;
+    }
+    k.format  = VK_FORMAT_R8G8B8A8_UNORM;
+    return rendererId + std::string(reinterpret_cast<const char*>(&k), sizeof(k));
+}
+
+void printCacheStats() {
+    ResultCacheStats s = resultCacheStats();
+    uint64_t lookups = s.memoryHits + s.diskHits + s.misses;
+    if (!lookups) return;
+    std::cout << std::fixed << std::setprecision(1)
+              << "cache: " << 100.0 * (s.memoryHits + s.diskHits) / lookups << "% hits ("
+              << 100.0 * s.memoryHits / lookups << "% memory, " << 100.0 * s.diskHits / lookups
+              << "% disk) of " << lookups << ", " << s.memoryEntries << " entries in memory ("
+              << s.memoryBytes / (1024.0 * 1024.0) << " MiB), " << s.diskEntries << " on disk\n"
+              << std::defaultfloat;
+}
+
+void runDaemon() {
+    uint32_t maxW = storageExtent.width, maxH = storageExtent.height;
+    daemonOpen(opts.serveSocket, size_t(4) * maxW * maxH, maxW, maxH);
+    std::cout << "daemon: " << deviceName << ", up to " << maxW << "x" << maxH
+              << ", listening on " << opts.serveSocket << "\n";
+
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(physDevice, &props);
+    uint64_t id = checksum64(&props.driverVersion, sizeof(props.driverVersion));
+    for (std::string shader : { compModule, std::string("pt_args"), std::string("pt_generate"),
+                                std::string("pt_extend"), std::string("pt_shade"), std::string("pt_shadow"),
+                                std::string("pt_resolve") }) {
+        std::vector<char> spv = readFile("../shaders/" + shader + ".spv");
+        id = checksum64(spv.data(), spv.size(), id);
+    }
+    rendererId = deviceName + '\0' + std::string(reinterpret_cast<const char*>(&id), sizeof(id));
+    resultCacheOpen(size_t(opts.cacheMemoryMB) << 20, opts.cacheFile, size_t(opts.cacheDiskMB) << 20);
+
+    Buffer results{};
+    std::vector<DaemonRequest> reqs;
+    uint64_t served = 0, batches = 0;
+    double   renderMs = 0, worstMs = 0;
+    auto reportTime = now();
+    while (daemonPoll(opts.serveWindowMs, reqs)) {
+        // cameras first, so a bad request doesn't hold up its batch; then
+        // the cache, whose hits are answered before anything is rendered
+        std::vector<Camera>      cams(reqs.size());
+        std::vector<std::string> keys(reqs.size());
+        std::vector<uint8_t*>    dsts(reqs.size());
+        std::vector<uint32_t>    slots(reqs.size());
+        std::vector<size_t>      order;
+        for (size_t i = 0; i < reqs.size(); i++) {
+            const DaemonRequest &r = reqs[i];
+            auto start = now();
+            Scene custom{ "", MODE_RAYMARCH, false, { r.pos[0], r.pos[1], r.pos[2] }, r.yaw, r.pitch };
+            const Scene* scene = r.scene.empty() ? &custom : findScene(r.scene);
+            if (!scene) {
+                daemonReplyError(r, "unknown scene " + r.scene);
+                continue;
+            }
+            if (r.power != 8.f) {
+                daemonReplyError(r, "only power 8 is built into the shaders");
+                continue;
+            }
+            applyScene(*scene, cams[i]);
+            dsts[i] = daemonResultSlot(r, slots[i]);
+            if (!dsts[i]) continue;   // the client left
+            keys[i] = resultKey(r, cams[i]);
+            if (resultCacheGet(keys[i], dsts[i], 4 * size_t(r.width) * r.height))
+                daemonReply(r, slots[i], 0, std::chrono::duration<double, std::milli>(now() - start).count(), true);
+            else
+                order.push_back(i);
+        }
+        // spp and bounces only matter to the path tracer, as in resultKey
+        auto group = [&](size_t i) {
+            const DaemonRequest &r = reqs[i];
+            bool pt = r.quality == "pathtrace";
+            return std::make_tuple(r.width, r.height, r.quality, pt ? r.spp : 0u, pt ? r.bounces : 0u);
+        };
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return group(a) < group(b); });
+
+        for (size_t begin = 0; begin < order.size();) {
+            size_t end = begin + 1;
+            while (end < order.size() && end - begin < DAEMON_BATCH && group(order[end]) == group(order[begin]))
+                end++;
+            const DaemonRequest &first = reqs[order[begin]];
+            auto start = now();
+            if (first.width != storageExtent.width || first.height != storageExtent.height)
+                recreateSwapchain(first.width, first.height);
+            bool pathTrace = first.quality == "pathtrace";
+            renderMode = pathTrace ? MODE_PATHTRACE : MODE_RAYMARCH;
+            coneAA     = first.quality == "aa";
+            opts.maxBounces = first.bounces;
+            if (pathTrace && !modeLive[MODE_PATHTRACE])
+                createModeResources();
+
+            VkDeviceSize imageBytes = 4 * VkDeviceSize(first.width) * first.height;
+            if (results.size < imageBytes * (end - begin)) {
+                destroyBuffer(results);
+                results = createBuffer(imageBytes * (end - begin), VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            }
+
+            submitOnce([&](VkCommandBuffer cb) {
+                VkImageMemoryBarrier ib{};
+                ib.sType     = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                ib.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                ib.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+                ib.image     = storageImage;
+                ib.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                ib.subresourceRange.levelCount = 1;
+                ib.subresourceRange.layerCount = 1;
+                ib.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+                vkCmdPipelineBarrier(cb,
+                    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    0, 0,nullptr, 0,nullptr, 1,&ib);
+
+                for (size_t k = begin; k < end; k++) {
+                    recordCameraUpdate(cb, cams[order[k]]);
+                    if (pathTrace) {
+                        PtPush pc = ptPush();
+                        uint32_t pixels = pc.width * pc.height;
+                        vkCmdFillBuffer(cb, ptAccum.buffer, 0, 16 * VkDeviceSize(pixels), 0);
+                        computeBarrier(cb);
+                        vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
+                            ptPipelineLayout, 0, 1, &ptSet, 0, nullptr);
+                        for (uint32_t s = 0; s < first.spp; s++) {
+                            pc.frame = s;
+                            recordPtSample(cb, pc, 0, pixels);
+                        }
+                        pc.sampleCount = first.spp;
+                        vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, ptResolve);
+                        vkCmdPushConstants(cb, ptPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+                    } else {
+                        vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, getComputeVariant(currentSpec()));
+                        vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
+                            pipelineLayout, 0, 1, &ds, 0, nullptr);
+                    }
+                    vkCmdDispatch(cb, (storageExtent.width + 15)/16, (storageExtent.height + 15)/16, 1);
+
+                    // copy out in GENERAL, then let the next request overwrite the image
+                    VkMemoryBarrier mb{};
+                    mb.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+                    mb.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+                    mb.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+                    vkCmdPipelineBarrier(cb,
+                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                        0, 1,&mb, 0,nullptr, 0,nullptr);
+                    VkBufferImageCopy region{};
+                    region.bufferOffset = imageBytes * (k - begin);
+                    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                    region.imageSubresource.layerCount = 1;
+                    region.imageExtent = { storageExtent.width, storageExtent.height, 1 };
+                    vkCmdCopyImageToBuffer(cb, storageImage, VK_IMAGE_LAYOUT_GENERAL,
+                                           results.buffer, 1, &region);
+                    vkCmdPipelineBarrier(cb,
+                        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                        0, 0,nullptr, 0,nullptr, 0,nullptr);
+                }
+
+                VkMemoryBarrier mb{};
+                mb.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+                mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                mb.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+                vkCmdPipelineBarrier(cb,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+                    0, 1,&mb, 0,nullptr, 0,nullptr);
+            });
+
+            double ms = std::chrono::duration<double, std::milli>(now() - start).count();
+            for (size_t k = begin; k < end; k++) {
+                size_t i = order[k];
+                const uint8_t* px = static_cast<const uint8_t*>(results.mapped) + imageBytes * (k - begin);
+                resultCachePut(keys[i], px, imageBytes);
+                if (!daemonConnected(reqs[i])) continue;   // its slots went with it
+                std::memcpy(dsts[i], px, imageBytes);
+                daemonReply(reqs[i], slots[i], uint32_t(end - begin), ms);
+            }
+            served   += end - begin;
+            batches++;
+            renderMs += ms;
+            worstMs   = std::max(worstMs, ms);
+            begin = end;
+        }
+
+        if (served && now() - reportTime >= std::chrono::seconds(1)) {
+            std::cout << "daemon: " << served << " requests in " << batches << " batches, "
+                      << renderMs / batches << " ms per batch (worst " << worstMs << ")\n";
+            served = batches = 0;
+            renderMs = worstMs = 0;
+            reportTime = now();
+            printCacheStats();
+        }
+    }
+    std::cout << "daemon: shutting down\n";
+    printCacheStats();
+    resultCacheClose();
+    daemonClose();
+    destroyBuffer(results);
+}
+
+// Exponential-map zoom video (--zoom-video PREFIX): zoomFrames frames
+// zooming by opts.zoom in equal ratios, with the camera held still so each
+// frame is a rescaled image plane. The plane is marched once, strip by
+// strip, in log-polar coordinates (shaders/zm_*.glsl); every frame is
+// resampled from the strips it covers and only the disc of zoomInner
+// pixels at its centre is marched per frame. --zoom-direct marches every
+// pixel of every frame with comp.glsl instead, for comparison.
+struct ZmPush {
+    uint32_t width, height, rows, cols, ring, strip, last;
+    float    uTop, du, logScale, innerR;
+};
+
+const uint32_t ZM_STRIP_COLS = 256;
+
+void runZoomVideo() {
+    const Scene* scene = findScene(opts.scene.empty() ? "overview" : opts.scene);
+    if (!scene) throw std::runtime_error("Unknown scene '" + opts.scene + "' (--list-scenes)");
+    Camera cam{};
+    applyScene(*scene, cam);
+    renderMode = MODE_RAYMARCH;
+    readbackPending = true;
+
+    uint32_t w = storageExtent.width, h = storageExtent.height;
+    uint32_t frames  = opts.zoomFrames;
+    float    logZoom = std::log(opts.zoom);
+    auto logScaleOf = [&](uint32_t f) { return frames > 1 ? logZoom * f / (frames - 1) : 0.f; };
+    auto framePath  = [&](uint32_t f) {
+        char name[16];
+        std::snprintf(name, sizeof(name), "%06u.ppm", f);
+        return opts.zoomPrefix + name;
+    };
+    auto start = now();
+
+    if (opts.zoomDirect) {
+        for (uint32_t f = 0; f < frames; f++) {
+            Camera c = cam;
+            float s = std::exp(-logScaleOf(f));
+            for (int i = 0; i < 3; i++) {
+                c.up[i]    *= s;
+                c.right[i] *= s;
+            }
+            drawFrame(0, c);
+            writePpm(framePath(f));
+        }
+        std::cout << "zoom: " << frames << " frames marched directly, "
+                  << double(frames) * w * h << " rays, "
+                  << std::chrono::duration<double>(now() - start).count() << " s\n";
+        return;
+    }
+
+    // one log-radius column per pixel at the frame corner, the same
+    // spacing in angle, so both axes are only ever oversampled
+    float   corner = std::sqrt(float(w) * w / (float(h) * h) + 1.f);   // plane radius
+    float   rhoMax = corner * h / 2.f;                                  // in pixels
+    ZmPush pc{};
+    pc.width  = w;
+    pc.height = h;
+    pc.du     = 1.f / rhoMax;
+    pc.uTop   = std::log(corner);
+    pc.rows   = uint32_t(std::ceil(6.2831853f / pc.du));
+    pc.cols   = ZM_STRIP_COLS;
+    pc.innerR = opts.zoomInner;
+
+    // strips frame f needs: out to its corner, in to the marched disc plus
+    // zm_frame's widest footprint
+    auto span = [&](float logS, uint32_t &lo, uint32_t &hi) {
+        float outer = logS / pc.du - 1.f;
+        float inner = (pc.uTop - std::log(2.f * pc.innerR / h) + logS) / pc.du + rhoMax / pc.innerR / 2.f + 2.f;
+        lo = uint32_t(std::max(0.f, outer)) / pc.cols;
+        hi = uint32_t(inner) / pc.cols;
+    };
+    for (uint32_t f = 0; f < frames; f++) {
+        uint32_t lo, hi;
+        span(logScaleOf(f), lo, hi);
+        pc.ring = std::max(pc.ring, hi - lo + 1);
+    }
+
+    Buffer strips = createBuffer(4 * VkDeviceSize(pc.rows) * pc.cols * pc.ring,
+                                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    VkDescriptorSetLayout setLayout = createKernelSetLayout(1);
+    VkPipelineLayout      layout    = createKernelPipelineLayout(setLayout, sizeof(ZmPush));
+    VkDescriptorPool      pool;
+    VkDescriptorSet       set       = createKernelSet(setLayout, { &strips }, pool);
+    VkPipeline            zmStrip   = createKernel("zm_strip", layout);
+    VkPipeline            zmFrame   = createKernel("zm_frame", layout);
+    updateCameraBuffer(cam);
+    std::cout << "zoom: " << frames << " frames to " << opts.zoom << "x, strips of " << pc.cols << "x"
+              << pc.rows << ", " << pc.ring << " held ("
+              << (4.0 * pc.rows * pc.cols * pc.ring) / (1024.0 * 1024.0) << " MiB)\n";
+
+    uint32_t next = 0;   // first strip not yet marched
+    for (uint32_t f = 0; f < frames; f++) {
+        uint32_t lo, hi;
+        span(logScaleOf(f), lo, hi);
+        submitOnce([&](VkCommandBuffer cb) {
+            VkImageMemoryBarrier ib{};
+            ib.sType     = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            ib.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            ib.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+            ib.image     = storageImage;
+            ib.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            ib.subresourceRange.levelCount = 1;
+            ib.subresourceRange.layerCount = 1;
+            ib.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            vkCmdPipelineBarrier(cb,
+                VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                0, 0,nullptr, 0,nullptr, 1,&ib);
+            vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, 1, &set, 0, nullptr);
+
+            // strips the zoom has reached; the ring slots they reuse are past
+            if (next <= hi) {
+                vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, zmStrip);
+                for (; next <= hi; next++) {
+                    pc.strip = next;
+                    vkCmdPushConstants(cb, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+                    vkCmdDispatch(cb, (pc.cols + 15)/16, (pc.rows + 15)/16, 1);
+                }
+                computeBarrier(cb);
+            }
+
+            pc.strip    = lo;
+            pc.last     = hi;
+            pc.logScale = logScaleOf(f);
+            vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, zmFrame);
+            vkCmdPushConstants(cb, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+            vkCmdDispatch(cb, (w + 15)/16, (h + 15)/16, 1);
+
+            ib.oldLayout     = VK_IMAGE_LAYOUT_GENERAL;
+            ib.newLayout     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            ib.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            ib.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            vkCmdPipelineBarrier(cb,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0, 0,nullptr, 0,nullptr, 1,&ib);
+            recordReadback(cb);
+        });
+        writePpm(framePath(f));
+    }
+
+    double stripRays  = double(next) * pc.cols * pc.rows;
+    double centreRays = double(frames) * 3.14159265 * pc.innerR * pc.innerR;
+    double directRays = double(frames) * w * h;
+    std::cout << "zoom: " << next << " strips, " << stripRays + centreRays << " rays ("
+              << stripRays << " in strips, " << centreRays << " at frame centres) vs "
+              << directRays << " marched directly, " << directRays / (stripRays + centreRays)
+              << "x fewer, " << std::chrono::duration<double>(now() - start).count() << " s\n";
+
+    vkDestroyPipeline(device, zmStrip, nullptr);
+    vkDestroyPipeline(device, zmFrame, nullptr);
+    vkDestroyDescriptorPool(device, pool, nullptr);
+    vkDestroyPipelineLayout(device, layout, nullptr);
+    vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+    destroyBuffer(strips);
+}
+
+void parseArgs(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) throw std::runtime_error("Missing value for " + a);
+            return argv[++i];
+        };
+        if (a == "--pathtrace")    opts.mode = MODE_PATHTRACE;
+        else if (a == "--denoise") opts.mode = MODE_DENOISED;
+        else if (a == "--cone-aa") coneAA = true;
+        else if (a == "--stats")   statsEnabled = true;
+        else if (a == "--clock")   clockProfile = true;
+        else if (a == "--hud")     hudEnabled = true;
+        else if (a == "--memory")  opts.memoryReport = true;
+        else if (a == "--clock-csv") opts.clockCsv = value();
+        else if (a == "--spp")     opts.samplesPerFrame = std::max(1, std::stoi(value()));
+        else if (a == "--bounces") opts.maxBounces = std::max(1, std::stoi(value()));
+        else if (a == "--adaptive") opts.mode = MODE_ADAPTIVE;
+        else if (a == "--vrs-block") opts.vrBlockSize = std::stoi(value()) <= 2 ? 2 : 4;
+        else if (a == "--vrs-depth") opts.vrDepthThreshold = std::stof(value());
+        else if (a == "--vrs-color") opts.vrColorThreshold = std::stof(value());
+        else if (a == "--vrs-show") opts.vrShowBlocks = true;
+        else if (a == "--foveated") opts.mode = MODE_FOVEATED;
+        else if (a == "--cpu")     opts.mode = MODE_CPU;
+        else if (a == "--cpu-threads") opts.cpuThreads = std::max(0, std::stoi(value()));
+        else if (a == "--no-host-import") opts.hostImport = false;
+        else if (a == "--screenshot") opts.screenshot = value();
+        else if (a == "--record")  opts.recordPrefix = value();
+        else if (a == "--readback") opts.readback = true;
+        else if (a == "--no-uma")  opts.uma = false;
+        else if (a == "--offline") { opts.offlineOut = value(); opts.headless = true; }
+        else if (a == "--offline-spp") opts.offlineSpp = std::max(1, std::stoi(value()));
+        else if (a == "--tile-rows") opts.tileRows = std::max(1, std::stoi(value()));
+        else if (a == "--checkpoint") opts.checkpointFile = value();
+        else if (a == "--checkpoint-interval") opts.checkpointSecs = std::stof(value());
+        else if (a == "--coordinate") opts.coordinateOut = value();
+        else if (a == "--workers") opts.workerCount = std::max(1, std::stoi(value()));
+        else if (a == "--worker-devices") {
+            std::string v = value();
+            for (size_t pos = 0; pos <= v.size();) {
+                size_t comma = std::min(v.find(',', pos), v.size());
+                opts.workerDevices.push_back(std::stoi(v.substr(pos, comma - pos)));
+                pos = comma + 1;
+            }
+        }
+        else if (a == "--worker-timeout") opts.workerTimeout = std::stof(value());
+        else if (a == "--worker") { opts.workerSocket = value(); opts.headless = true; }
+        else if (a == "--serve") { opts.serveSocket = value(); opts.headless = true; }
+        else if (a == "--serve-window") opts.serveWindowMs = std::max(0.f, std::stof(value()));
+        else if (a == "--cache-memory") opts.cacheMemoryMB = std::max(0, std::stoi(value()));
+        else if (a == "--cache")   opts.cacheFile = value();
+        else if (a == "--cache-size") opts.cacheDiskMB = std::max(1, std::stoi(value()));
+        else if (a == "--zoom-video") { opts.zoomPrefix = value(); opts.headless = true; }
+        else if (a == "--zoom")    opts.zoom = std::max(1.f, std::stof(value()));
+        else if (a == "--zoom-frames") opts.zoomFrames = std::max(1, std::stoi(value()));
+        else if (a == "--zoom-inner") opts.zoomInner = std::max(8.f, std::stof(value()));
+        else if (a == "--zoom-direct") opts.zoomDirect = true;
+        else if (a == "--focus") {
+            std::string v = value();
+            size_t comma = v.find(',');
+            if (comma == std::string::npos) throw std::runtime_error("--focus expects x,y");
+            focusPoint[0] = std::clamp(std::stof(v.substr(0, comma)), 0.f, 1.f);
+            focusPoint[1] = std::clamp(std::stof(v.substr(comma + 1)), 0.f, 1.f);
+        }
+        else if (a == "--fovea-scale") opts.foveaScale = std::max(1.f, std::stof(value()));
+        else if (a == "--fovea-alpha") opts.foveaAlpha = std::max(1.f, std::stof(value()));
+        else if (a == "--ao-rays") opts.stochasticRays = std::clamp(std::stoi(value()), 1, 2);
+        else if (a == "--pipeline-report") opts.pipelineReport = value();
+        else if (a == "--no-pipeline-report") opts.pipelineReport.clear();
+        else if (a == "--trace")   opts.traceFile = value();
+        else if (a == "--hitch")   opts.hitchThreshold = std::max(1.f, std::stof(value()));
+        else if (a == "--hitch-prefix") opts.hitchPrefix = value();
+        else if (a == "--frame-stats") opts.frameStatsFile = value();
+        else if (a == "--metrics") opts.metricsFile = value();
+        else if (a == "--trace-frames") {
+            std::string v = value();
+            size_t colon = v.find(':');
+            if (colon == std::string::npos) throw std::runtime_error("--trace-frames expects first:last");
+            opts.traceFirst = std::stoull(v.substr(0, colon));
+            opts.traceLast  = std::stoull(v.substr(colon + 1));
+        }
+        else if (a == "--atrous")  opts.atrousPasses = std::clamp(std::stoi(value()), 0, 8);
+        else if (a == "--headless") opts.headless = true;
+        else if (a == "--size") {
+            std::string v = value();
+            size_t x = v.find('x');
+            if (x == std::string::npos) throw std::runtime_error("--size expects WxH");
+            opts.width  = std::max(16, std::stoi(v.substr(0, x)));
+            opts.height = std::max(16, std::stoi(v.substr(x + 1)));
+        }
+        else if (a == "--device")  opts.device = std::stoi(value());
+        else if (a == "--scene")   opts.scene = value();
+        else if (a == "--warmup")  opts.warmupFrames = std::max(0, std::stoi(value()));
+        else if (a == "--frames")  opts.sceneFrames = std::max(1, std::stoi(value()));
+        else if (a == "--trials")  opts.sceneTrials = std::max(1, std::stoi(value()));
+        else if (a == "--scene-report") opts.sceneReport = value();
+        else if (a == "--list-scenes") opts.listScenes = true;
+        else throw std::runtime_error("Unknown option " + a);
+    }
+}
+
+int main(int argc, char** argv) {
     try {
+        parseArgs(argc, argv);
+        if (opts.listScenes) {
+            for (const Scene &s : SCENES)
+                std::cout << s.name << "\n";
+            return EXIT_SUCCESS;
+        }
+        if (!opts.coordinateOut.empty()) {
+            CoordinatorOptions co;
+            co.output      = opts.coordinateOut;
+            co.workerArgv  = { argv[0], "--size", std::to_string(opts.width) + "x" + std::to_string(opts.height),
+                               "--spp", std::to_string(opts.samplesPerFrame) };
+            co.devices     = opts.workerDevices;
+            if (co.devices.empty()) co.devices.assign(opts.workerCount, opts.device);
+            co.scene       = opts.scene.empty() ? "overview" : opts.scene;
+            if (!findScene(co.scene))
+                throw std::runtime_error("Unknown scene '" + co.scene + "' (--list-scenes)");
+            co.width       = opts.width;
+            co.height      = opts.height;
+            co.spp         = opts.offlineSpp;
+            co.bounces     = opts.maxBounces;
+            co.bandRows    = std::min(opts.tileRows, opts.height);
+            co.timeoutSecs = opts.workerTimeout;
+            runCoordinator(co);
+            return EXIT_SUCCESS;
+        }
+        if (opts.headless && opts.scene.empty() && opts.offlineOut.empty() &&
+            opts.workerSocket.empty() && opts.serveSocket.empty() && opts.zoomPrefix.empty())
+            throw std::runtime_error("--headless needs a --scene");
+        renderMode = opts.mode;
         createInstance();
-        createWindowAndSurface();
+        if (!opts.headless)
+            createWindowAndSurface();
         pickPhysicalDevice();
         createLogicalDeviceAndQueue();
-        int fbw, fbh;
-        glfwGetFramebufferSize(window, &fbw, &fbh);
-        createSwapchain(fbw, fbh);
+        if (opts.headless) {
+            swapchainExtent = { opts.width, opts.height };
+        } else {
+            int fbw, fbh;
+            glfwGetFramebufferSize(window, &fbw, &fbh);
+            createSwapchain(fbw, fbh);
+        }
         createStorageImage();
+        if (storageLinear)
+            std::cout << "readback: storage image is linear in host-visible device memory\n";
         createCameraBuffer();
+        createStatsBuffer();
         createDescriptorSet();
         createComputePipeline();
+        createPathTracerPipelines();
+        createDenoiserPipelines();
+        createAdaptivePipelines();
+        createFoveatedPipelines();
+        updateMemoryBudget();
+        createModeResources();
+        createClockPipelines();
+        createClockResources();
+        createHudPipelines();
+        createHudResources();
+        createTimestampPool();
         createCommandPoolAndBuffers();
         createSyncObjects();
+        bool tracePending = !opts.traceFile.empty();
+        traceSetThreadName("main");
+        if (tracePending)
+            traceEnable(true);
+        if (opts.hitchThreshold > 0.f)
+            hitchEnable(opts.hitchThreshold, opts.hitchPrefix);
+        if (clockProfile && !hasShaderClock)
+            std::cerr << "VK_KHR_shader_clock not supported, --clock ignored\n";
+        if (!opts.zoomPrefix.empty()) {
+            runZoomVideo();
+            vkDeviceWaitIdle(device);
+            return EXIT_SUCCESS;
+        }
+        if (!opts.serveSocket.empty()) {
+            runDaemon();
+            vkDeviceWaitIdle(device);
+            return EXIT_SUCCESS;
+        }
+        if (!opts.workerSocket.empty()) {
+            runWorker();
+            vkDeviceWaitIdle(device);
+            return EXIT_SUCCESS;
+        }
+        if (!opts.offlineOut.empty()) {
+            runOffline();
+            vkDeviceWaitIdle(device);
+            return EXIT_SUCCESS;
+        }
+        if (opts.headless) {
+            runHeadlessScene();
+            vkDeviceWaitIdle(device);
+            return EXIT_SUCCESS;
+        }
 
         // initial camera
         Camera cam{};
@@ -697,18 +3428,32 @@ int main() {
         rotateVec(camRot, BASE_FORWARD, cam.forward);
         rotateVec(camRot, BASE_UP,      cam.up);
         rotateVec(camRot, BASE_RIGHT,   cam.right);
+        if (!opts.scene.empty()) {
+            const Scene* scene = findScene(opts.scene);
+            if (!scene) throw std::runtime_error("Unknown scene '" + opts.scene + "' (--list-scenes)");
+            camRot = applyScene(*scene, cam);
+        }
 
         double lastX = WIDTH/2.0, lastY = HEIGHT/2.0;
         glfwSetCursorPos(window, lastX, lastY);
         glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
         auto lastTime = now();
+        auto lastFrameEnd = lastTime;
+        auto runStart     = lastTime;
+        auto reportTime = lastTime;
+        uint64_t reportSamples = 0;
         while (!glfwWindowShouldClose(window)) {
-            glfwPollEvents();
-            int curW, curH;
-            glfwGetFramebufferSize(window, &curW, &curH);
-            if (curW != (int)swapchainExtent.width || curH != (int)swapchainExtent.height)
-                recreateSwapchain(curW, curH);
+            traceSetFrame(frameIndex);
+            {
+                TRACE_SCOPE("poll");
+                glfwPollEvents();
+                int curW, curH;
+                glfwGetFramebufferSize(window, &curW, &curH);
+                if (curW != (int)swapchainExtent.width || curH != (int)swapchainExtent.height)
+                    recreateSwapchain(curW, curH);
+            }
+            uint64_t inputBegin = traceEnabled ? traceNowNs() : 0;
             // delta
             auto t2 = now();
             float dt = std::chrono::duration<float>(t2 - lastTime).count();
@@ -770,10 +3515,119 @@ int main() {
             cam.pos[1] += move[1]*speed*dt;
             cam.pos[2] += move[2]*speed*dt;
 
+            // arrow keys steer the foveation focus point
+            float fdx = 0.f, fdy = 0.f;
+            if(glfwGetKey(window, GLFW_KEY_LEFT)==GLFW_PRESS)  fdx -= 1.f;
+            if(glfwGetKey(window, GLFW_KEY_RIGHT)==GLFW_PRESS) fdx += 1.f;
+            if(glfwGetKey(window, GLFW_KEY_UP)==GLFW_PRESS)    fdy -= 1.f;
+            if(glfwGetKey(window, GLFW_KEY_DOWN)==GLFW_PRESS)  fdy += 1.f;
+            focusPoint[0] = std::clamp(focusPoint[0] + fdx*0.5f*dt, 0.f, 1.f);
+            focusPoint[1] = std::clamp(focusPoint[1] + fdy*0.5f*dt, 0.f, 1.f);
+            if (traceEnabled)
+                traceCpu("input", inputBegin, traceNowNs());
+
+            readbackPending = screenshotPending || !opts.recordPrefix.empty();
             drawFrame(0, cam);
+            if (readbackPending)
+                consumeReadback();
+
+            auto frameEnd = now();
+            float frameMs = std::chrono::duration<float, std::milli>(frameEnd - lastFrameEnd).count();
+            double gpuMs = gpuComputeMs + gpuHudMs + gpuCopyMs;
+            frameStatsRecord(frameMs, timestampPool ? gpuMs : -1.0);
+            hudFrameMs[hudHead] = frameMs;
+            hudHead = (hudHead + 1) % HUD_SAMPLES;
+            if (hitchEnabled()) {
+                HitchFrame hf{};
+                hf.frame  = frameIndex - 1;
+                hf.cpuMs  = frameMs;
+                hf.gpuMs  = float(gpuMs);
+                std::copy(cam.pos,     cam.pos + 3,     hf.pos);
+                std::copy(cam.forward, cam.forward + 3, hf.forward);
+                hf.width  = swapchainExtent.width;
+                hf.height = swapchainExtent.height;
+                hitchRecord(hf);
+            }
+            lastFrameEnd = frameEnd;
+
+            if (tracePending && frameIndex > opts.traceLast) {
+                traceExport(opts.traceFile, opts.traceFirst, opts.traceLast);
+                tracePending = false;
+                traceEnable(hitchEnabled());
+                std::cout << "trace: wrote frames " << opts.traceFirst << "-" << opts.traceLast
+                          << " to " << opts.traceFile << "\n";
+            }
+            collectStats();
+            if (frameIndex % 30 == 0)
+                updateMemoryBudget();
+            bool clockFrame = clockProfile && hasShaderClock && renderMode == MODE_RAYMARCH;
+            if (clockFrame)
+                collectClock();
+
+            // drawFrame waits for the queue, so the refine count is final
+            if (renderMode == MODE_ADAPTIVE) {
+                vrBlocksTotal   += vrBlocks;
+                vrBlocksRefined += static_cast<const uint32_t*>(vrCounters.mapped)[4];
+            }
+
+            // per-mode reports, once per second
+            float reportSecs = std::chrono::duration<float>(now() - reportTime).count();
+            if (renderMode == MODE_PATHTRACE && reportSecs >= 1.f) {
+                double sps = (ptSamplesTraced - reportSamples) / reportSecs;
+                std::cout << "pathtrace: " << ptSampleCount << " spp, "
+                          << sps << " spp/s, "
+                          << sps * swapchainExtent.width * swapchainExtent.height / 1e6
+                          << " Mpaths/s\n";
+            }
+            if (renderMode == MODE_ADAPTIVE && reportSecs >= 1.f && vrBlocksTotal) {
+                double refined = double(vrBlocksRefined) / vrBlocksTotal;
+                double b2 = double(opts.vrBlockSize) * opts.vrBlockSize;
+                std::cout << "adaptive: " << refined * 100.0 << "% of blocks refined, ~"
+                          << (1.0 / b2 + refined) << " rays/pixel\n";
+            }
+#ifdef METHARIZON_CPU_RENDER
+            if (renderMode == MODE_CPU && reportSecs >= 1.f)
+                cpuRenderPrintStats(std::cout);
+#endif
+            if (statsEnabled && reportSecs >= 1.f)
+                printStatsReport();
+            if (opts.memoryReport && reportSecs >= 1.f)
+                printMemoryReport();
+            if (clockFrame && reportSecs >= 1.f) {
+                double total = double(clkPhaseTotals[0] + clkPhaseTotals[1] + clkPhaseTotals[2]);
+                if (total > 0)
+                    std::cout << "clock: march " << 100.0 * clkPhaseTotals[0] / total
+                              << "%, normal " << 100.0 * clkPhaseTotals[1] / total
+                              << "%, shade " << 100.0 * clkPhaseTotals[2] / total
+                              << "% of " << total / 1e9 << " Gcycles\n";
+                writeClockCsv(opts.clockCsv);
+            }
+            if (reportSecs >= 1.f) {
+                if (!opts.frameStatsFile.empty())
+                    frameStatsPrintInterval(std::cout);
+                if (!opts.metricsFile.empty())
+                    frameStatsWriteMetrics(opts.metricsFile);
+                frameStatsNewInterval();
+                reportTime    = now();
+                reportSamples = ptSamplesTraced;
+                vrBlocksTotal = vrBlocksRefined = 0;
+                statsTotals   = StatsTotals{};
+                std::fill(std::begin(clkPhaseTotals), std::end(clkPhaseTotals), 0);
+            }
         }
 
         vkDeviceWaitIdle(device);
+        if (!opts.frameStatsFile.empty()) {
+            frameStatsWriteJson(opts.frameStatsFile,
+                                std::chrono::duration<double>(now() - runStart).count());
+            std::cout << "frame stats: wrote " << opts.frameStatsFile << "\n";
+        }
+        if (!opts.metricsFile.empty())
+            frameStatsWriteMetrics(opts.metricsFile);
+        if (tracePending) {
+            traceExport(opts.traceFile, opts.traceFirst, opts.traceLast);
+            std::cout << "trace: wrote " << opts.traceFile << "\n";
+        }
         // TODO: cleanup all Vulkan resources...
     }
     catch (std::exception &e) {
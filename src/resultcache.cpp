@@ -0,0 +1,268 @@
+// src/resultcache.cpp
+#include "resultcache.h"
+#include "checkpoint.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <list>
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char   MAGIC[8]    = { 'M', 'Z', 'C', 'A', 'C', 'H', 'E', '1' };
+const char   ENTRY[8]    = { 'M', 'Z', 'E', 'N', 'T', 'R', 'Y', '1' };
+const size_t PAGE        = 4096;
+
+struct FileHeader {
+    char     magic[8];
+    uint64_t fileBytes;
+};
+
+struct EntryHeader {
+    char     magic[8];
+    uint64_t seq;
+    uint32_t keyBytes;
+    uint32_t pad;
+    uint64_t dataBytes;
+    uint64_t checksum;         // key then data
+    uint64_t headerChecksum;   // over the fields above
+};
+
+struct MemoryEntry {
+    std::string          key;
+    std::vector<uint8_t> data;
+};
+
+struct DiskEntry {
+    size_t   offset, size;     // page-aligned span in the file
+    uint64_t dataBytes;
+};
+
+// memory tier, most recently used first
+using LruList = std::list<MemoryEntry>;
+size_t                                             memoryLimit = 0;
+LruList                                            lru;
+std::unordered_map<std::string, LruList::iterator> lruIndex;
+
+// disk tier
+int      fd = -1;
+uint8_t* base = nullptr;
+size_t   fileSize = 0;
+size_t   head = PAGE;          // where the next entry goes
+uint64_t nextSeq = 1;
+std::unordered_map<std::string, DiskEntry> diskIndex;
+std::map<size_t, std::string>              byOffset;   // entry offset -> key
+
+ResultCacheStats stats;
+
+size_t roundUp(size_t n, size_t a) { return (n + a - 1) / a * a; }
+
+// A store to a hole of a full disk raises SIGBUS, so the file's blocks are
+// reserved up front (macOS has no posix_fallocate and keeps it sparse)
+void reserve(const std::string &path) {
+#if !defined(_WIN32) && !defined(__APPLE__)
+    if (int err = posix_fallocate(fd, 0, off_t(fileSize)))
+        throw std::runtime_error("Failed to reserve " + std::to_string(fileSize >> 20) + " MiB for " +
+                                 path + ": " + std::strerror(err));
+#else
+    (void)path;
+#endif
+}
+
+uint64_t headerChecksum(const EntryHeader &h) {
+    return checksum64(&h, offsetof(EntryHeader, headerChecksum));
+}
+
+uint64_t entryChecksum(const uint8_t* entry, const EntryHeader &h) {
+    return checksum64(entry + sizeof(EntryHeader), h.keyBytes + h.dataBytes);
+}
+
+void memoryInsert(const std::string &key, const void* data, size_t bytes) {
+    if (bytes > memoryLimit) return;
+    auto it = lruIndex.find(key);
+    if (it != lruIndex.end()) {
+        stats.memoryBytes -= it->second->data.size();
+        lru.erase(it->second);
+        lruIndex.erase(it);
+    }
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    lru.push_front({ key, std::vector<uint8_t>(p, p + bytes) });
+    lruIndex[key] = lru.begin();
+    stats.memoryBytes += bytes;
+    while (stats.memoryBytes > memoryLimit) {
+        stats.memoryBytes -= lru.back().data.size();
+        lruIndex.erase(lru.back().key);
+        lru.pop_back();
+    }
+}
+
+void diskForget(const std::string &key) {
+    auto it = diskIndex.find(key);
+    if (it == diskIndex.end()) return;
+    byOffset.erase(it->second.offset);
+    diskIndex.erase(it);
+}
+
+// Rebuild the index from whatever valid entries the file holds
+void diskScan() {
+    uint64_t newest = 0;
+    for (size_t off = PAGE; off + sizeof(EntryHeader) <= fileSize;) {
+        EntryHeader h;
+        std::memcpy(&h, base + off, sizeof(h));
+        size_t size = roundUp(sizeof(h) + size_t(h.keyBytes) + h.dataBytes, PAGE);
+        bool valid = std::memcmp(h.magic, ENTRY, sizeof(ENTRY)) == 0 &&
+                     h.headerChecksum == headerChecksum(h) && off + size <= fileSize &&
+                     h.checksum == entryChecksum(base + off, h);
+        if (!valid) {
+            off += PAGE;
+            continue;
+        }
+        std::string key(reinterpret_cast<const char*>(base + off + sizeof(h)), h.keyBytes);
+        auto it = diskIndex.find(key);
+        bool newer = it == diskIndex.end() ||
+            h.seq > reinterpret_cast<const EntryHeader*>(base + it->second.offset)->seq;
+        if (newer) {
+            diskForget(key);
+            diskIndex[key] = { off, size, h.dataBytes };
+            byOffset[off]  = key;
+        }
+        if (h.seq > newest) {
+            newest = h.seq;
+            head   = off + size;
+        }
+        off += size;
+    }
+    nextSeq = newest + 1;
+}
+
+void diskPut(const std::string &key, const void* data, size_t bytes) {
+    size_t size = roundUp(sizeof(EntryHeader) + key.size() + bytes, PAGE);
+    if (!base || size > fileSize - PAGE) return;
+    if (head + size > fileSize) head = PAGE;
+
+    // drop what the new entry overwrites, including an entry starting before it
+    diskForget(key);
+    auto it = byOffset.lower_bound(head);
+    if (it != byOffset.begin()) {
+        auto prev = std::prev(it);
+        if (prev->first + diskIndex[prev->second].size > head) it = prev;
+    }
+    while (it != byOffset.end() && it->first < head + size) {
+        diskIndex.erase(it->second);
+        it = byOffset.erase(it);
+    }
+
+    // body first, so a torn write leaves no valid header behind
+    uint8_t* entry = base + head;
+    std::memcpy(entry + sizeof(EntryHeader), key.data(), key.size());
+    std::memcpy(entry + sizeof(EntryHeader) + key.size(), data, bytes);
+    EntryHeader h{};
+    std::memcpy(h.magic, ENTRY, sizeof(ENTRY));
+    h.seq       = nextSeq++;
+    h.keyBytes  = uint32_t(key.size());
+    h.dataBytes = bytes;
+    h.checksum  = entryChecksum(entry, h);
+    h.headerChecksum = headerChecksum(h);
+    std::memcpy(entry, &h, sizeof(h));
+
+    diskIndex[key] = { head, size, bytes };
+    byOffset[head] = key;
+    head += size;
+}
+
+} // namespace
+
+void resultCacheOpen(size_t memoryBytes, const std::string &path, size_t diskBytes) {
+    resultCacheClose();
+    memoryLimit = memoryBytes;
+    if (path.empty()) return;
+#ifdef _WIN32
+    (void)diskBytes;
+    throw std::runtime_error("The disk cache needs POSIX mmap");
+#else
+    fileSize = roundUp(std::max(diskBytes, 2 * PAGE), PAGE);
+    fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) throw std::runtime_error("Failed to open " + path);
+    struct stat st;
+    if (fstat(fd, &st) != 0) throw std::runtime_error("Failed to stat " + path);
+    bool sized = size_t(st.st_size) == fileSize;
+    if (!sized && ftruncate(fd, off_t(fileSize)) != 0)
+        throw std::runtime_error("Failed to size " + path);
+    reserve(path);
+    void* mem = mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mem == MAP_FAILED) throw std::runtime_error("Failed to map " + path);
+    base = static_cast<uint8_t*>(mem);
+
+    FileHeader fh{};
+    std::memcpy(fh.magic, MAGIC, sizeof(MAGIC));
+    fh.fileBytes = fileSize;
+    if (sized && std::memcmp(base, &fh, sizeof(fh)) == 0) {
+        diskScan();
+    } else {
+        // resized or foreign: forget the entries
+        if (ftruncate(fd, 0) != 0 || ftruncate(fd, off_t(fileSize)) != 0)
+            throw std::runtime_error("Failed to reset " + path);
+        reserve(path);
+        std::memcpy(base, &fh, sizeof(fh));
+    }
+#endif
+}
+
+void resultCacheClose() {
+#ifndef _WIN32
+    if (base) munmap(base, fileSize);
+    if (fd >= 0) close(fd);
+#endif
+    base = nullptr;
+    fd   = -1;
+    head = PAGE;
+    nextSeq = 1;
+    diskIndex.clear();
+    byOffset.clear();
+    lru.clear();
+    lruIndex.clear();
+    stats = ResultCacheStats{};
+}
+
+bool resultCacheGet(const std::string &key, void* out, size_t bytes) {
+    auto m = lruIndex.find(key);
+    if (m != lruIndex.end() && m->second->data.size() == bytes) {
+        lru.splice(lru.begin(), lru, m->second);
+        std::memcpy(out, m->second->data.data(), bytes);
+        stats.memoryHits++;
+        return true;
+    }
+    auto d = diskIndex.find(key);
+    if (d != diskIndex.end() && d->second.dataBytes == bytes) {
+        std::memcpy(out, base + d->second.offset + sizeof(EntryHeader) + key.size(), bytes);
+        memoryInsert(key, out, bytes);
+        stats.diskHits++;
+        return true;
+    }
+    stats.misses++;
+    return false;
+}
+
+void resultCachePut(const std::string &key, const void* data, size_t bytes) {
+    memoryInsert(key, data, bytes);
+    diskPut(key, data, bytes);
+}
+
+ResultCacheStats resultCacheStats() {
+    ResultCacheStats s = stats;
+    s.memoryEntries = lru.size();
+    s.diskEntries   = diskIndex.size();
+    return s;
+}
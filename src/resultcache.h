@@ -0,0 +1,33 @@
+// src/resultcache.h
+//
+// Content-addressed store of rendered images, keyed by the canonical bytes
+// of everything that decides the pixels (the caller's job: camera, formula,
+// quality, format, plus the device and shaders so a different renderer
+// misses). Two tiers: an LRU in memory, and optionally a memory-mapped
+// file used as a ring log of page-aligned entries, the oldest overwritten
+// first. Entries carry their key and a checksum, so a reopened file is
+// rebuilt by scanning it and torn or overwritten entries are dropped. A
+// hit compares the full key, never just its hash.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct ResultCacheStats {
+    uint64_t memoryHits = 0, diskHits = 0, misses = 0;
+    uint64_t memoryEntries = 0, diskEntries = 0;
+    size_t   memoryBytes = 0;
+};
+
+// memoryBytes 0 disables the memory tier, an empty path the disk tier.
+// Throws if the file can't be created or mapped.
+void resultCacheOpen(size_t memoryBytes, const std::string &path, size_t diskBytes);
+void resultCacheClose();
+
+// Copy a cached result of exactly `bytes` bytes into out. Disk hits are
+// promoted to the memory tier.
+bool resultCacheGet(const std::string &key, void* out, size_t bytes);
+void resultCachePut(const std::string &key, const void* data, size_t bytes);
+
+ResultCacheStats resultCacheStats();
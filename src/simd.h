@@ -0,0 +1,66 @@
+// src/simd.h
+//
+// Fixed-width float vectors on the GCC/Clang vector extensions. Kernels
+// are templated on the lane count N and the compiler lowers each width to
+// what the target has: 4 lanes for SSE/NEON, 8 for AVX2, 16 for AVX-512.
+// The alias templates are non-deduced, so helpers take <N> explicitly.
+#pragma once
+
+#include <cstdint>
+
+// Widest float vector the build target executes natively
+#if defined(__AVX512F__)
+const int SIMD_LANES = 16;
+#elif defined(__AVX__)
+const int SIMD_LANES = 8;
+#else
+const int SIMD_LANES = 4;
+#endif
+
+template<int N> struct SimdTypes {
+    typedef float   f __attribute__((vector_size(N * sizeof(float))));
+    typedef int32_t i __attribute__((vector_size(N * sizeof(int32_t))));
+};
+template<int N> using vfloat = typename SimdTypes<N>::f;
+template<int N> using vint   = typename SimdTypes<N>::i;
+template<int N> using vmask  = vint<N>;   // comparison result: lanes all ones or zero
+
+template<int N> inline vfloat<N> splat(float x) {
+    return vfloat<N>{} + x;
+}
+
+template<int N> inline vfloat<N> select(vmask<N> m, vfloat<N> a, vfloat<N> b) {
+    return (vfloat<N>)((m & (vint<N>)a) | (~m & (vint<N>)b));
+}
+
+template<int N> inline bool any(vmask<N> m) {
+    for (int i = 0; i < N; i++)
+        if (m[i]) return true;
+    return false;
+}
+
+template<int N> inline vfloat<N> vmin(vfloat<N> a, vfloat<N> b) { return select<N>(a < b, a, b); }
+template<int N> inline vfloat<N> vmax(vfloat<N> a, vfloat<N> b) { return select<N>(a > b, a, b); }
+
+// Lane loops the compiler turns into single instructions
+// (sqrtps needs -fno-math-errno)
+template<int N> inline vfloat<N> vsqrt(vfloat<N> x) {
+    vfloat<N> r = x;
+    for (int i = 0; i < N; i++) r[i] = __builtin_sqrtf(x[i]);
+    return r;
+}
+
+template<int N> inline vfloat<N> vload(const float* p) {
+    vfloat<N> r{};
+    for (int i = 0; i < N; i++) r[i] = p[i];
+    return r;
+}
+
+template<int N> inline void vstore(float* p, vfloat<N> v) {
+    for (int i = 0; i < N; i++) p[i] = v[i];
+}
+
+// Keep a value alive without letting the optimiser see its use
+template<class T> inline void keepAlive(const T &v) {
+    asm volatile("" : : "r,m"(v) : "memory");
+}
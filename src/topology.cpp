@@ -0,0 +1,148 @@
+// src/topology.cpp
+#include "topology.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// "0-3,8,10-11"
+std::vector<int> parseCpuList(const std::string &s) {
+    std::vector<int> cpus;
+    std::stringstream ss(s);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || !std::isdigit((unsigned char)range[0])) continue;
+        size_t dash = range.find('-');
+        int lo = std::stoi(range.substr(0, dash));
+        int hi = dash == std::string::npos ? lo : std::stoi(range.substr(dash + 1));
+        for (int c = lo; c <= hi; c++) cpus.push_back(c);
+    }
+    return cpus;
+}
+
+std::string readLine(const std::string &path) {
+    std::ifstream f(path);
+    std::string line;
+    std::getline(f, line);
+    return line;
+}
+
+std::vector<int> allowedCpus() {
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; c++)
+            if (CPU_ISSET(c, &set)) cpus.push_back(c);
+        return cpus;
+    }
+#endif
+    for (unsigned c = 0; c < std::max(1u, std::thread::hardware_concurrency()); c++)
+        cpus.push_back(int(c));
+    return cpus;
+}
+
+} // namespace
+
+std::vector<NumaNode> discoverTopology() {
+    std::vector<int>      allowed = allowedCpus();
+    std::vector<NumaNode> nodes;
+
+#ifdef __linux__
+    if (DIR* dir = opendir("/sys/devices/system/node")) {
+        while (dirent* e = readdir(dir)) {
+            std::string name = e->d_name;
+            if (name.compare(0, 4, "node") != 0 || name.size() == 4 ||
+                !std::isdigit((unsigned char)name[4]))
+                continue;
+            std::string base = "/sys/devices/system/node/" + name;
+            NumaNode node;
+            node.id      = std::stoi(name.substr(4));
+            node.memNode = node.id;
+            for (int c : parseCpuList(readLine(base + "/cpulist")))
+                if (std::find(allowed.begin(), allowed.end(), c) != allowed.end())
+                    node.cpus.push_back(c);
+            std::stringstream dist(readLine(base + "/distance"));
+            for (int d; dist >> d;) node.distance.push_back(d);
+            nodes.push_back(node);
+        }
+        closedir(dir);
+    }
+    std::sort(nodes.begin(), nodes.end(),
+              [](const NumaNode &a, const NumaNode &b) { return a.id < b.id; });
+    // the distance rows are indexed by node id; re-index them by position
+    // and drop memory-only nodes
+    std::vector<NumaNode> withCpus;
+    for (const NumaNode &n : nodes) {
+        if (n.cpus.empty()) continue;
+        NumaNode m = n;
+        m.distance.clear();
+        for (const NumaNode &o : nodes)
+            if (!o.cpus.empty())
+                m.distance.push_back(o.id < int(n.distance.size()) ? n.distance[o.id] : 20);
+        withCpus.push_back(m);
+    }
+    nodes = withCpus;
+#endif
+
+    if (nodes.empty())
+        nodes.push_back({ 0, 0, allowed, { 10 } });
+
+    if (const char* fake = std::getenv("METHARIZON_NUMA_FAKE")) {
+        int n = std::max(1, std::atoi(fake));
+        if (nodes.size() == 1 && n > 1) {
+            std::vector<int> cpus = nodes[0].cpus;
+            int memNode = nodes[0].memNode;
+            nodes.clear();
+            for (int i = 0; i < n; i++) {
+                NumaNode node{ i, memNode, {}, std::vector<int>(n, 20) };
+                node.distance[i] = 10;
+                // at least one CPU each, shared round-robin if there are fewer CPUs than nodes
+                for (size_t c = i; c < std::max(cpus.size(), size_t(n)); c += n)
+                    node.cpus.push_back(cpus[c % cpus.size()]);
+                nodes.push_back(node);
+            }
+        }
+    }
+    return nodes;
+}
+
+bool pinThreadToCpu(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+int pageNode(const void* addr) {
+#if defined(__linux__) && defined(SYS_move_pages)
+    // move_pages with no target nodes only reports where each page lives
+    void* page = (void*)((uintptr_t)addr & ~uintptr_t(sysconf(_SC_PAGESIZE) - 1));
+    int status = -1;
+    if (syscall(SYS_move_pages, 0, 1UL, &page, nullptr, &status, 0) == 0 && status >= 0)
+        return status;
+#else
+    (void)addr;
+#endif
+    return -1;
+}
@@ -0,0 +1,26 @@
+// src/topology.h
+//
+// NUMA topology from sysfs (/sys/devices/system/node), without libnuma:
+// the CPUs of each node, restricted to this process's affinity mask, and
+// the node distance matrix. Machines without NUMA information come back
+// as one node holding every allowed CPU.
+#pragma once
+
+#include <vector>
+
+struct NumaNode {
+    int              id;
+    int              memNode;    // where its first-touched pages land (id, unless faked)
+    std::vector<int> cpus;
+    std::vector<int> distance;   // to every node, by index into the topology
+};
+
+// METHARIZON_NUMA_FAKE=N splits a single node into N pretend nodes, to
+// exercise node-aware scheduling on a one-socket machine
+std::vector<NumaNode> discoverTopology();
+
+// Pin the calling thread to one CPU; false if the OS refused
+bool pinThreadToCpu(int cpu);
+
+// Node holding the page at addr, -1 if unknown (not yet touched, no NUMA)
+int pageNode(const void* addr);
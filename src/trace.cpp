@@ -0,0 +1,152 @@
+// src/trace.cpp
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+const size_t RING_SIZE = 1u << 15;   // events kept per thread
+
+enum EventKind : uint8_t { EV_COMPLETE, EV_INSTANT, EV_COUNTER };
+
+struct Event {
+    const char* name;
+    uint64_t    begin, end;   // ns on the steady clock
+    uint64_t    frame;
+    EventKind   kind;
+    double      value;        // EV_COUNTER only
+};
+
+struct Ring {
+    std::vector<Event> events = std::vector<Event>(RING_SIZE);
+    uint64_t           written = 0;   // total pushed, the ring holds the last RING_SIZE
+    std::string        name;
+    uint32_t           tid;
+    std::mutex         lock;          // only contended by traceExport
+
+    void push(const Event &e) {
+        std::lock_guard<std::mutex> g(lock);
+        events[written++ % RING_SIZE] = e;
+    }
+};
+
+std::mutex                         registryLock;
+std::vector<std::unique_ptr<Ring>> rings;      // never shrinks, threads may exit
+Ring*                              gpuRing = nullptr;
+uint64_t                           currentFrame = 0;
+
+Ring* newRing(const char* name) {
+    std::lock_guard<std::mutex> g(registryLock);
+    rings.push_back(std::make_unique<Ring>());
+    Ring* ring = rings.back().get();
+    ring->tid  = (uint32_t)rings.size();
+    ring->name = name ? name : "thread " + std::to_string(ring->tid);
+    return ring;
+}
+
+Ring* threadRing() {
+    thread_local Ring* ring = newRing(nullptr);
+    return ring;
+}
+
+void writeEscaped(std::ostream &out, const std::string &s) {
+    for (char c : s) {
+        if (c == '"' || c == '\\') out << '\\';
+        out << c;
+    }
+}
+
+} // namespace
+
+bool traceEnabled = false;
+
+void traceEnable(bool on) {
+    traceEnabled = on;
+    if (on && !gpuRing) gpuRing = newRing("GPU queue");
+}
+
+uint64_t traceNowNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void traceSetFrame(uint64_t frame) {
+    currentFrame = frame;
+}
+
+void traceSetThreadName(const char* name) {
+    threadRing()->name = name;
+}
+
+void traceCpu(const char* name, uint64_t beginNs, uint64_t endNs) {
+    threadRing()->push({ name, beginNs, endNs, currentFrame, EV_COMPLETE, 0.0 });
+}
+
+void traceGpu(const char* name, uint64_t beginNs, uint64_t endNs, uint64_t frame) {
+    if (!traceEnabled) return;
+    gpuRing->push({ name, beginNs, endNs, frame, EV_COMPLETE, 0.0 });
+}
+
+void traceInstant(const char* name) {
+    if (!traceEnabled) return;
+    uint64_t t = traceNowNs();
+    threadRing()->push({ name, t, t, currentFrame, EV_INSTANT, 0.0 });
+}
+
+void traceCounter(const char* name, double value) {
+    if (!traceEnabled) return;
+    uint64_t t = traceNowNs();
+    threadRing()->push({ name, t, t, currentFrame, EV_COUNTER, value });
+}
+
+void traceExport(const std::string &path, uint64_t firstFrame, uint64_t lastFrame,
+                 const std::string &otherData) {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("Failed to open " + path);
+
+    std::lock_guard<std::mutex> g(registryLock);
+    out << std::fixed << std::setprecision(3);   // microseconds with ns resolution
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    auto sep = [&]() { out << (first ? "" : ",\n"); first = false; };
+
+    for (auto &ring : rings) {
+        sep();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->tid
+            << ",\"args\":{\"name\":\"";
+        writeEscaped(out, ring->name);
+        out << "\"}}";
+
+        std::lock_guard<std::mutex> rg(ring->lock);
+        uint64_t n = std::min<uint64_t>(ring->written, RING_SIZE);
+        for (uint64_t i = ring->written - n; i < ring->written; i++) {
+            const Event &e = ring->events[i % RING_SIZE];
+            if (e.frame < firstFrame || e.frame > lastFrame) continue;
+            sep();
+            // trace-event timestamps are microseconds
+            out << "{\"name\":\"";
+            writeEscaped(out, e.name);
+            out << "\",\"pid\":1,\"tid\":" << ring->tid << ",\"ts\":" << e.begin / 1000.0;
+            if (e.kind == EV_COUNTER) {
+                out << ",\"ph\":\"C\",\"args\":{\"value\":" << e.value << "}}";
+                continue;
+            }
+            if (e.kind == EV_COMPLETE)
+                out << ",\"ph\":\"X\",\"dur\":" << (e.end - e.begin) / 1000.0;
+            else
+                out << ",\"ph\":\"i\",\"s\":\"t\"";
+            out << ",\"args\":{\"frame\":" << e.frame << "}}";
+        }
+    }
+    out << "\n]";
+    if (!otherData.empty())
+        out << ",\"otherData\":{" << otherData << "}";
+    out << "}\n";
+}
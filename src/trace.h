@@ -0,0 +1,42 @@
+// src/trace.h
+//
+// Low-overhead CPU/GPU timeline capture, exported as Chrome trace-event
+// JSON (chrome://tracing, ui.perfetto.dev). Each thread records complete
+// events into its own fixed-size ring, whose lock only the exporter ever
+// contends. GPU intervals are added by the owner of the timestamp queries
+// once they are converted to the CPU clock.
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Recording is off until traceEnable(); scopes then cost two clock reads
+extern bool traceEnabled;
+
+void     traceEnable(bool on);
+uint64_t traceNowNs();                       // steady clock, the trace time base
+void     traceSetFrame(uint64_t frame);      // frame tag for subsequent events
+void     traceSetThreadName(const char* name);
+
+// `name` must outlive the trace (string literals)
+void traceCpu(const char* name, uint64_t beginNs, uint64_t endNs);
+void traceGpu(const char* name, uint64_t beginNs, uint64_t endNs, uint64_t frame);
+void traceInstant(const char* name);
+void traceCounter(const char* name, double value);
+
+// Write events of frames [firstFrame, lastFrame] still held in the rings.
+// `otherData`, if given, is the body of a JSON object stored as the
+// trace's top-level "otherData".
+void traceExport(const std::string &path, uint64_t firstFrame, uint64_t lastFrame,
+                 const std::string &otherData = "");
+
+struct TraceScope {
+    const char* name;
+    uint64_t    begin;
+    explicit TraceScope(const char* n) : name(n), begin(traceEnabled ? traceNowNs() : 0) {}
+    ~TraceScope() { if (traceEnabled && begin) traceCpu(name, begin, traceNowNs()); }
+};
+
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b)  TRACE_CONCAT2(a, b)
+#define TRACE_SCOPE(name)   TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name)
@@ -0,0 +1,171 @@
+// src/vmath.h
+//
+// Vectorised float transcendentals for the CPU DE ports, templated on the
+// lane count like simd.h: N = 8 compiles to AVX2 and N = 16 to AVX-512
+// under -march=native, N = 1 is the scalar fallback. Cephes-style range
+// reduction and minimax polynomials, branch-free with lane selects.
+//
+// Max error against double-precision libm, as checked by MetharizonBench
+// --accuracy (accuracy.cpp holds the same bounds):
+//
+//   vlog     x in [1e-30, 1e30]                    1 ulp
+//   vexp     x in [-87, 88]                        2 ulp
+//   vpow     x in [1e-3, 4], y in [1, 16]          2 + 2 |y ln x| ulp
+//            with x^y >= FLT_MIN
+//   vsincos  x in [-8192, 8192]                    2 ulp, or 2 ulp of 1e-3
+//                                                  for results below 1e-3
+//   vatan2   finite y, x in +-[1e-20, 1e20]        4 ulp
+//   vacos    x in [-1, 1]                          2 ulp
+//
+// Denormal inputs are treated as zero; vacos clamps to [-1, 1] instead of
+// returning NaN, which suits acos(z/r) with rounding in r.
+#pragma once
+
+#include "simd.h"
+
+template<int N> inline vfloat<N> asFloat(vint<N> i) { return (vfloat<N>)i; }
+template<int N> inline vint<N>   asInt(vfloat<N> f) { return (vint<N>)f; }
+
+template<int N> inline vfloat<N> vabs(vfloat<N> x) {
+    return asFloat<N>(asInt<N>(x) & 0x7fffffff);
+}
+
+// copy the sign of s onto |x|
+template<int N> inline vfloat<N> vcopysign(vfloat<N> x, vfloat<N> s) {
+    return asFloat<N>((asInt<N>(x) & 0x7fffffff) | (asInt<N>(s) & int32_t(0x80000000)));
+}
+
+template<int N> inline vfloat<N> vfloor(vfloat<N> x) {
+    vfloat<N> t = __builtin_convertvector(__builtin_convertvector(x, vint<N>), vfloat<N>);
+    return t - select<N>(t > x, splat<N>(1.f), splat<N>(0.f));
+}
+
+template<int N> inline vfloat<N> vlog(vfloat<N> x) {
+    vint<N> bits = asInt<N>(x);
+    vint<N> e    = ((bits >> 23) & 0xff) - 126;
+    vfloat<N> m  = asFloat<N>((bits & 0x807fffff) | 0x3f000000);   // [0.5, 1)
+
+    // m in [sqrt(0.5), sqrt(2)), f = m - 1
+    vmask<N>  small = m < 0.707106781186547524f;
+    vfloat<N> ef    = __builtin_convertvector(e, vfloat<N>) - select<N>(small, splat<N>(1.f), splat<N>(0.f));
+    vfloat<N> f     = select<N>(small, m + m, m) - 1.f;
+
+    vfloat<N> z = f * f;
+    vfloat<N> y = splat<N>(7.0376836292e-2f);
+    y = y*f - 1.1514610310e-1f;
+    y = y*f + 1.1676998740e-1f;
+    y = y*f - 1.2420140846e-1f;
+    y = y*f + 1.4249322787e-1f;
+    y = y*f - 1.6668057665e-1f;
+    y = y*f + 2.0000714765e-1f;
+    y = y*f - 2.4999993993e-1f;
+    y = y*f + 3.3333331174e-1f;
+    y = y * f * z;
+    y += -2.12194440e-4f * ef;
+    y += -0.5f * z;
+    vfloat<N> r = f + y + 0.693359375f * ef;
+
+    r = select<N>(x < 1.17549435e-38f, splat<N>(-__builtin_inff()), r);   // zero and denormals
+    r = select<N>(x < 0.f, splat<N>(__builtin_nanf("")), r);
+    r = select<N>(x == __builtin_inff(), x, r);
+    return select<N>(x != x, x, r);
+}
+
+template<int N> inline vfloat<N> vexp(vfloat<N> x) {
+    vfloat<N> c  = vmin<N>(vmax<N>(x, splat<N>(-87.3365447f)), splat<N>(88.7228391f));
+    vfloat<N> fx = vfloor<N>(c * 1.44269504088896341f + 0.5f);
+    vfloat<N> g  = c - fx * 0.693359375f - fx * -2.12194440e-4f;
+
+    vfloat<N> z = g * g;
+    vfloat<N> y = splat<N>(1.9875691500e-4f);
+    y = y*g + 1.3981999507e-3f;
+    y = y*g + 8.3334519073e-3f;
+    y = y*g + 4.1665795894e-2f;
+    y = y*g + 1.6666665459e-1f;
+    y = y*g + 5.0000001201e-1f;
+    y = y*z + g + 1.f;
+
+    // scale by 2^fx in two steps so fx = 128 does not overflow the exponent
+    vint<N> k  = __builtin_convertvector(fx, vint<N>);
+    vint<N> k1 = k >> 1;
+    y = y * asFloat<N>((k1 + 127) << 23) * asFloat<N>((k - k1 + 127) << 23);
+    y = select<N>(x > 88.7228391f, splat<N>(__builtin_inff()), y);
+    y = select<N>(x < -87.3365447f, splat<N>(0.f), y);
+    return select<N>(x != x, x, y);
+}
+
+// x^y for x >= 0, the only case the DE needs
+template<int N> inline vfloat<N> vpow(vfloat<N> x, vfloat<N> y) {
+    vfloat<N> r = vexp<N>(y * vlog<N>(x));
+    return select<N>(x == 0.f, select<N>(y > 0.f, splat<N>(0.f), splat<N>(1.f)), r);
+}
+
+template<int N> inline void vsincos(vfloat<N> x, vfloat<N> &s, vfloat<N> &c) {
+    vfloat<N> ax = vabs<N>(x);
+    // octant j, rounded up to even so the reduced argument is in [-pi/4, pi/4]
+    vint<N>   j  = __builtin_convertvector(ax * 1.27323954473516f, vint<N>);
+    j = (j + 1) & ~1;
+    vfloat<N> yj = __builtin_convertvector(j, vfloat<N>);
+    vfloat<N> r  = ((ax - yj * 0.78515625f) - yj * 2.4187564849853515625e-4f)
+                 - yj * 3.77489497744594108e-8f;
+    vfloat<N> z  = r * r;
+
+    vfloat<N> ps = ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * r + r;
+    vfloat<N> pc = ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z
+                   + 4.166664568298827e-2f) * z * z - 0.5f * z + 1.f;
+
+    vmask<N>  swap  = (j & 2) != 0;
+    vfloat<N> sinV  = select<N>(swap, pc, ps);
+    vfloat<N> cosV  = select<N>(swap, ps, pc);
+    // sin is odd in x and flips in octants 4..7; cos flips in octants 2..5
+    vint<N>   sSign = (((j & 4) != 0) ^ (asInt<N>(x) < 0)) & int32_t(0x80000000);
+    vint<N>   cSign = (((j + 2) & 4) != 0) & int32_t(0x80000000);
+    s = asFloat<N>(asInt<N>(sinV) ^ sSign);
+    c = asFloat<N>(asInt<N>(cosV) ^ cSign);
+}
+
+template<int N> inline vfloat<N> vatan(vfloat<N> x) {
+    vfloat<N> ax   = vabs<N>(x);
+    vmask<N>  big  = ax > 2.414213562373095f;    // tan(3 pi / 8)
+    vmask<N>  mid  = (ax > 0.4142135623730950f) & ~big;
+    vfloat<N> base = select<N>(big, splat<N>(1.5707963267948966f),
+                     select<N>(mid, splat<N>(0.7853981633974483f), splat<N>(0.f)));
+    vfloat<N> t    = select<N>(big, -1.f / ax, select<N>(mid, (ax - 1.f) / (ax + 1.f), ax));
+
+    vfloat<N> z = t * t;
+    vfloat<N> y = (((8.05374449538e-2f * z - 1.38776856032e-1f) * z + 1.99777106478e-1f) * z
+                  - 3.33329491539e-1f) * z * t + t;
+    return vcopysign<N>(base + y, x);
+}
+
+template<int N> inline vfloat<N> vatan2(vfloat<N> y, vfloat<N> x) {
+    vfloat<N> a = vatan<N>(y / x);
+    // left half plane: move to the quadrant of y
+    vfloat<N> pi = vcopysign<N>(splat<N>(3.14159265358979f), y);
+    a = select<N>(x < 0.f, a + pi, a);
+    a = select<N>(x == 0.f, vcopysign<N>(splat<N>(1.5707963267948966f), y), a);
+    vmask<N> zero = (x == 0.f) & (y == 0.f);
+    return select<N>(zero, select<N>(asInt<N>(x) < 0, pi, vcopysign<N>(splat<N>(0.f), y)), a);
+}
+
+// asin on [0, 0.5] by its odd polynomial
+template<int N> inline vfloat<N> asinKernel(vfloat<N> x) {
+    vfloat<N> z = x * x;
+    vfloat<N> y = splat<N>(4.2163199048e-2f);
+    y = y*z + 2.4181311049e-2f;
+    y = y*z + 4.5470025998e-2f;
+    y = y*z + 7.4953002686e-2f;
+    y = y*z + 1.6666752422e-1f;
+    return y * z * x + x;
+}
+
+template<int N> inline vfloat<N> vacos(vfloat<N> x) {
+    x = vmin<N>(vmax<N>(x, splat<N>(-1.f)), splat<N>(1.f));
+    vfloat<N> ax   = vabs<N>(x);
+    vmask<N>  tail = ax > 0.5f;
+    // acos(|x|) = 2 asin(sqrt((1 - |x|) / 2)) near the ends
+    vfloat<N> s    = asinKernel<N>(select<N>(tail, vsqrt<N>(0.5f * (1.f - ax)), x));
+    vfloat<N> head = 1.5707963267948966f - s;
+    vfloat<N> tl   = select<N>(x < 0.f, 3.14159265358979f - 2.f * s, 2.f * s);
+    return select<N>(tail, tl, head);
+}